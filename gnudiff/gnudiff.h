@@ -36,6 +36,12 @@ extern "C"
         /* 1 more than the maximum equivalence value used for this or its
            sibling file.  */
         lin equiv_max;
+
+        /* Vector, indexed by line number, containing 1 for a line that
+           matches no line of the sibling file and 2 for a line that matches
+           many, or null if discard_confusing_lines has to count them
+           itself.  It is modified by the comparison.  */
+        char *discards;
     };
 
     struct comparison
@@ -43,10 +49,31 @@ extern "C"
         file_data file[2];
     };
 
+    /* Comparisons on different threads can run at the same time. */
     int diff_2_files (comparison *);
 
+    /* The callback is called for the comparisons of the calling thread. */
     using HunkCallback = void (*)(int first0, int last0, int first1, int last1, void *pContext);
     void setHunkCallback(HunkCallback pHunkCallback, void *pContext);
 
+    /* The working memory of diff_2_files is kept for reuse by the next call
+       on the same thread. This returns the calling thread's working memory to
+       the system once it does no more diffs. */
+    void arena_release(void);
+
+    /* A forward and a backward kernel that follow snakes, i.e. runs of equal
+       lines, for one instruction set. They are declared here so that they
+       can be tested against each other. */
+    struct snake_kernel
+    {
+        const char *name;
+        lin (*forward)(const lin *xv, const lin *yv, lin n);
+        lin (*backward)(const lin *xv, const lin *yv, lin n);
+    };
+
+    /* Stores the kernels that this CPU can run in *kernels, the scalar ones
+       first, and returns how many there are. */
+    int snake_kernels(const snake_kernel **kernels);
+
 }
 
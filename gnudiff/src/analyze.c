@@ -39,21 +39,29 @@
 //#include <error.h>
 //#include <file-type.h>
 #include <xalloc.h>
+#include <snake.h>
+#include <limits.h>
 
-static lin *xvec, *yvec;	/* Vectors being compared. */
-static lin *fdiag;		/* Vector, indexed by diagonal, containing
+/* The state of a comparison is per thread, so that several comparisons
+   can run at the same time.  */
+
+static _Thread_local lin *xvec, *yvec;	/* Vectors being compared. */
+static _Thread_local lin *fdiag;		/* Vector, indexed by diagonal, containing
 				   1 + the X coordinate of the point furthest
 				   along the given diagonal in the forward
 				   search of the edit matrix. */
-static lin *bdiag;		/* Vector, indexed by diagonal, containing
+static _Thread_local lin *bdiag;		/* Vector, indexed by diagonal, containing
 				   the X coordinate of the point furthest
 				   along the given diagonal in the backward
 				   search of the edit matrix. */
-static lin too_expensive;	/* Edit scripts longer than this are too
+static _Thread_local lin too_expensive;	/* Edit scripts longer than this are too
 				   expensive to compute.  */
 
 #define SNAKE_LIMIT 20	/* Snakes bigger than this are considered `big'.  */
 
+#define EQUIV_COUNT_MAX USHRT_MAX	/* Saturation value of the counts in
+					   discard_confusing_lines.  */
+
 struct partition
 {
   lin xmid, ymid;	/* Midpoints of this partition.  */
@@ -128,8 +136,13 @@ diag (lin xoff, lin xlim, lin yoff, lin ylim, bool find_minimal,
 	    x = thi;
 	  oldx = x;
 	  y = x - d;
+#if 0
 	  while (x < xlim && y < ylim && xv[x] == yv[y])
 	    ++x, ++y;
+#else
+	  x += snake_forward (xv + x, yv + y, MIN (xlim - x, ylim - y));
+	  y = x - d;
+#endif
 	  if (x - oldx > SNAKE_LIMIT)
 	    big_snake = true;
 	  fd[d] = x;
@@ -155,8 +168,13 @@ diag (lin xoff, lin xlim, lin yoff, lin ylim, bool find_minimal,
 	    x = thi - 1;
 	  oldx = x;
 	  y = x - d;
+#if 0
 	  while (x > xoff && y > yoff && xv[x - 1] == yv[y - 1])
 	    --x, --y;
+#else
+	  x -= snake_backward (xv + x, yv + y, MIN (x - xoff, y - yoff));
+	  y = x - d;
+#endif
 	  if (oldx - x > SNAKE_LIMIT)
 	    big_snake = true;
 	  bd[d] = x;
@@ -333,12 +351,23 @@ compareseq (lin xoff, lin xlim, lin yoff, lin ylim, bool find_minimal)
   lin const *xv = xvec; /* Help the compiler.  */
   lin const *yv = yvec;
 
+#if 0
   /* Slide down the bottom initial diagonal. */
   while (xoff < xlim && yoff < ylim && xv[xoff] == yv[yoff])
     ++xoff, ++yoff;
   /* Slide up the top initial diagonal. */
   while (xlim > xoff && ylim > yoff && xv[xlim - 1] == yv[ylim - 1])
     --xlim, --ylim;
+#else
+  lin slide;
+
+  /* Slide down the bottom initial diagonal. */
+  slide = snake_forward (xv + xoff, yv + yoff, MIN (xlim - xoff, ylim - yoff));
+  xoff += slide, yoff += slide;
+  /* Slide up the top initial diagonal. */
+  slide = snake_backward (xv + xlim, yv + ylim, MIN (xlim - xoff, ylim - yoff));
+  xlim -= slide, ylim -= slide;
+#endif
 
   /* Handle simple cases. */
   if (xoff == xlim)
@@ -378,7 +407,16 @@ discard_confusing_lines (struct file_data filevec[])
   int f;
   lin i;
   char *discarded[2];
+#if 0
   lin *equiv_count[2];
+#else
+  /* Lines are only compared against MANY below, which is far smaller than
+     EQUIV_COUNT_MAX for any file of fewer than 2**34 lines, so the counts
+     can saturate without changing which lines are discarded.  Compared to
+     exact counts, this takes a quarter of the memory, which matters when
+     most lines are unique and EQUIV_MAX approaches the number of lines.  */
+  unsigned short *equiv_count[2];
+#endif
   lin *p;
 
   /* Allocate our results.  */
@@ -390,52 +428,84 @@ discard_confusing_lines (struct file_data filevec[])
       filevec[f].realindexes = p;  p += filevec[f].buffered_lines;
     }
 
-  /* Set up equiv_count[F][I] as the number of lines in file F
-     that fall in equivalence class I.  */
+  /* When the caller has already marked the lines that match no line
+     or many lines of the other file, because it counted them while
+     assigning the equivalence classes, the marks are used as they are.
+     That avoids the counts, which take memory in proportion to
+     EQUIV_MAX rather than to the number of lines.  */
 
-  p = zalloc (filevec[0].equiv_max * (2 * sizeof *p));
-  equiv_count[0] = p;
-  equiv_count[1] = p + filevec[0].equiv_max;
-
-  for (i = 0; i < filevec[0].buffered_lines; ++i)
-    ++equiv_count[0][filevec[0].equivs[i]];
-  for (i = 0; i < filevec[1].buffered_lines; ++i)
-    ++equiv_count[1][filevec[1].equivs[i]];
+  if (filevec[0].discards && filevec[1].discards)
+    {
+      discarded[0] = filevec[0].discards;
+      discarded[1] = filevec[1].discards;
+    }
+  else
+    {
+      /* Set up equiv_count[F][I] as the number of lines in file F
+	 that fall in equivalence class I.  */
 
-  /* Set up tables of which lines are going to be discarded.  */
+#if 0
+      p = zalloc (filevec[0].equiv_max * (2 * sizeof *p));
+      equiv_count[0] = p;
+      equiv_count[1] = p + filevec[0].equiv_max;
+
+      for (i = 0; i < filevec[0].buffered_lines; ++i)
+	++equiv_count[0][filevec[0].equivs[i]];
+      for (i = 0; i < filevec[1].buffered_lines; ++i)
+	++equiv_count[1][filevec[1].equivs[i]];
+#else
+      equiv_count[0] = zalloc (filevec[0].equiv_max * (2 * sizeof **equiv_count));
+      equiv_count[1] = equiv_count[0] + filevec[0].equiv_max;
 
-  discarded[0] = zalloc (filevec[0].buffered_lines
-			 + filevec[1].buffered_lines);
-  discarded[1] = discarded[0] + filevec[0].buffered_lines;
+      for (f = 0; f < 2; f++)
+	for (i = 0; i < filevec[f].buffered_lines; ++i)
+	  {
+	    unsigned short *count = &equiv_count[f][filevec[f].equivs[i]];
+	    *count += *count < EQUIV_COUNT_MAX;
+	  }
+#endif
 
-  /* Mark to be discarded each line that matches no line of the other file.
-     If a line matches many lines, mark it as provisionally discardable.  */
+      /* Set up tables of which lines are going to be discarded.  */
 
-  for (f = 0; f < 2; f++)
-    {
-      size_t end = filevec[f].buffered_lines;
-      char *discards = discarded[f];
-      lin *counts = equiv_count[1 - f];
-      lin *equivs = filevec[f].equivs;
-      size_t many = 5;
-      size_t tem = end / 64;
+      discarded[0] = zalloc (filevec[0].buffered_lines
+			     + filevec[1].buffered_lines);
+      discarded[1] = discarded[0] + filevec[0].buffered_lines;
 
-      /* Multiply MANY by approximate square root of number of lines.
-	 That is the threshold for provisionally discardable lines.  */
-      while ((tem = tem >> 2) > 0)
-	many *= 2;
+      /* Mark to be discarded each line that matches no line of the other file.
+	 If a line matches many lines, mark it as provisionally discardable.  */
 
-      for (i = 0; i < end; i++)
+      for (f = 0; f < 2; f++)
 	{
-	  lin nmatch;
-	  if (equivs[i] == 0)
-	    continue;
-	  nmatch = counts[equivs[i]];
-	  if (nmatch == 0)
-	    discards[i] = 1;
-	  else if (nmatch > many)
-	    discards[i] = 2;
+	  size_t end = filevec[f].buffered_lines;
+	  char *discards = discarded[f];
+#if 0
+	  lin *counts = equiv_count[1 - f];
+#else
+	  unsigned short *counts = equiv_count[1 - f];
+#endif
+	  lin *equivs = filevec[f].equivs;
+	  size_t many = 5;
+	  size_t tem = end / 64;
+
+	  /* Multiply MANY by approximate square root of number of lines.
+	     That is the threshold for provisionally discardable lines.  */
+	  while ((tem = tem >> 2) > 0)
+	    many *= 2;
+
+	  for (i = 0; i < end; i++)
+	    {
+	      lin nmatch;
+	      if (equivs[i] == 0)
+		continue;
+	      nmatch = counts[equivs[i]];
+	      if (nmatch == 0)
+		discards[i] = 1;
+	      else if (nmatch > many)
+		discards[i] = 2;
+	    }
 	}
+
+      free (equiv_count[0]);
     }
 
   /* Don't really discard the provisional lines except when they occur
@@ -567,8 +637,13 @@ discard_confusing_lines (struct file_data filevec[])
       filevec[f].nondiscarded_lines = j;
     }
 
+#if 0
   free (discarded[0]);
   free (equiv_count[0]);
+#else
+  if (discarded[0] != filevec[0].discards)
+    free (discarded[0]);
+#endif
 }
 
 /* Adjust inserts/deletes of identical lines to join changes
@@ -799,8 +874,8 @@ diff_2_files (struct comparison *cmp)
   lin diags;
 #if 0
   int f;
-#endif
   struct change *e, *p;
+#endif
   struct change *script;
   int changes;
 
@@ -1033,11 +1108,17 @@ diff_2_files (struct comparison *cmp)
 	}
 #endif
 
+#if 0
       for (e = script; e; e = p)
 	{
 	  p = e->link;
 	  free (e);
 	}
+#endif
+
+      /* Everything allocated above came from the arena.  Rewind it so the
+	 next comparison reuses the same memory.  */
+      arena_reset ();
 
 #if 0
       if (! ROBUST_OUTPUT_STYLE (output_style))
@@ -302,6 +302,12 @@ struct file_data {
     /* 1 more than the maximum equivalence value used for this or its
        sibling file.  */
     lin equiv_max;
+
+    /* Vector, indexed by line number, containing 1 for a line that
+       matches no line of the sibling file and 2 for a line that matches
+       many, or null if discard_confusing_lines has to count them
+       itself.  It is modified by the comparison.  */
+    char *discards;
 };
 
 /* The file buffer, considered as an array of bytes rather than
@@ -320,7 +326,7 @@ struct comparison
 
 /* Describe the two files currently being compared.  */
 
-XTERN struct file_data files[2];
+XTERN _Thread_local struct file_data files[2];
 
 /* Stdio stream to output diffs to.  */
 
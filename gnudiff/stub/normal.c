@@ -24,8 +24,9 @@
 
 typedef void (HunkCallback)(int, int, int, int, void *);
 
-HunkCallback *g_pHunkCallback = NULL;
-void *g_pContext = NULL;
+/* Per thread, like the comparison it is called for.  */
+_Thread_local HunkCallback *g_pHunkCallback = NULL;
+_Thread_local void *g_pContext = NULL;
 
 void setHunkCallback(HunkCallback *pHunkCallback, void *pContext)
 {
@@ -0,0 +1,170 @@
+/* This file is not part of GNU diffutils */
+
+#include "snake.h"
+
+#if defined __x86_64__ && defined __GNUC__
+#include <immintrin.h>
+#define SNAKE_X86_64 1
+#endif
+
+static lin
+snake_forward_scalar (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  while (i < n && xv[i] == yv[i])
+    ++i;
+  return i;
+}
+
+static lin
+snake_backward_scalar (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  while (i < n && xv[-1 - i] == yv[-1 - i])
+    ++i;
+  return i;
+}
+
+#ifdef SNAKE_X86_64
+
+/* SSE2 is part of x86-64, so these are the baseline kernels.  Without a
+   64-bit compare, two lines are equal if both of their 32-bit halves are.  */
+
+static lin
+snake_forward_sse2 (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128i a = _mm_loadu_si128 ((__m128i const *) (xv + i));
+      __m128i b = _mm_loadu_si128 ((__m128i const *) (yv + i));
+      int mask = _mm_movemask_epi8 (_mm_cmpeq_epi32 (a, b));
+      if (mask != 0xFFFF)
+        return i + ((mask & 0xFF) == 0xFF);
+    }
+  return i + snake_forward_scalar (xv + i, yv + i, n - i);
+}
+
+static lin
+snake_backward_sse2 (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128i a = _mm_loadu_si128 ((__m128i const *) (xv - i - 2));
+      __m128i b = _mm_loadu_si128 ((__m128i const *) (yv - i - 2));
+      int mask = _mm_movemask_epi8 (_mm_cmpeq_epi32 (a, b));
+      if (mask != 0xFFFF)
+        return i + ((mask & 0xFF00) == 0xFF00);
+    }
+  return i + snake_backward_scalar (xv - i, yv - i, n - i);
+}
+
+/* Compare eight lines per iteration, but only work out which one differs
+   once a difference has been found.  */
+
+__attribute__ ((target ("avx2"))) static lin
+snake_forward_avx2 (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  for (; i + 8 <= n; i += 8)
+    {
+      __m256i a0 = _mm256_loadu_si256 ((__m256i const *) (xv + i));
+      __m256i b0 = _mm256_loadu_si256 ((__m256i const *) (yv + i));
+      __m256i a1 = _mm256_loadu_si256 ((__m256i const *) (xv + i + 4));
+      __m256i b1 = _mm256_loadu_si256 ((__m256i const *) (yv + i + 4));
+      __m256i eq0 = _mm256_cmpeq_epi64 (a0, b0);
+      __m256i eq1 = _mm256_cmpeq_epi64 (a1, b1);
+      if (!_mm256_testc_si256 (_mm256_and_si256 (eq0, eq1),
+                               _mm256_set1_epi64x (-1)))
+        {
+          unsigned mask = _mm256_movemask_pd (_mm256_castsi256_pd (eq0))
+                          | _mm256_movemask_pd (_mm256_castsi256_pd (eq1)) << 4;
+          return i + __builtin_ctz (~mask);
+        }
+    }
+  return i + snake_forward_scalar (xv + i, yv + i, n - i);
+}
+
+__attribute__ ((target ("avx2"))) static lin
+snake_backward_avx2 (lin const *xv, lin const *yv, lin n)
+{
+  lin i = 0;
+  for (; i + 8 <= n; i += 8)
+    {
+      __m256i a0 = _mm256_loadu_si256 ((__m256i const *) (xv - i - 8));
+      __m256i b0 = _mm256_loadu_si256 ((__m256i const *) (yv - i - 8));
+      __m256i a1 = _mm256_loadu_si256 ((__m256i const *) (xv - i - 4));
+      __m256i b1 = _mm256_loadu_si256 ((__m256i const *) (yv - i - 4));
+      __m256i eq0 = _mm256_cmpeq_epi64 (a0, b0);
+      __m256i eq1 = _mm256_cmpeq_epi64 (a1, b1);
+      if (!_mm256_testc_si256 (_mm256_and_si256 (eq0, eq1),
+                               _mm256_set1_epi64x (-1)))
+        {
+          /* Bit 7 is the line closest to the starting point.  */
+          unsigned mask = _mm256_movemask_pd (_mm256_castsi256_pd (eq0))
+                          | _mm256_movemask_pd (_mm256_castsi256_pd (eq1)) << 4;
+          return i + __builtin_clz (~mask << 24);
+        }
+    }
+  return i + snake_backward_scalar (xv - i, yv - i, n - i);
+}
+
+static lin (*forward_kernel) (lin const *, lin const *, lin) = snake_forward_sse2;
+static lin (*backward_kernel) (lin const *, lin const *, lin) = snake_backward_sse2;
+
+__attribute__ ((constructor)) static void
+select_snake_kernels (void)
+{
+  __builtin_cpu_init ();
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      forward_kernel = snake_forward_avx2;
+      backward_kernel = snake_backward_avx2;
+    }
+}
+
+static struct snake_kernel const kernels[] =
+{
+  { "scalar", snake_forward_scalar, snake_backward_scalar },
+  { "sse2", snake_forward_sse2, snake_backward_sse2 },
+  { "avx2", snake_forward_avx2, snake_backward_avx2 },
+};
+
+int
+snake_kernels (struct snake_kernel const **k)
+{
+  *k = kernels;
+  return __builtin_cpu_supports ("avx2") ? 3 : 2;
+}
+
+#else
+
+static lin (*forward_kernel) (lin const *, lin const *, lin) = snake_forward_scalar;
+static lin (*backward_kernel) (lin const *, lin const *, lin) = snake_backward_scalar;
+
+static struct snake_kernel const kernels[] =
+{
+  { "scalar", snake_forward_scalar, snake_backward_scalar },
+};
+
+int
+snake_kernels (struct snake_kernel const **k)
+{
+  *k = kernels;
+  return 1;
+}
+
+#endif
+
+lin
+snake_forward_run (lin const *xv, lin const *yv, lin n)
+{
+  return forward_kernel (xv, yv, n);
+}
+
+lin
+snake_backward_run (lin const *xv, lin const *yv, lin n)
+{
+  return backward_kernel (xv, yv, n);
+}
@@ -0,0 +1,52 @@
+/* This header is not part of GNU diffutils */
+
+#include "system.h"
+
+/* Snakes (runs of matching lines along a diagonal) are followed by comparing
+   the equivalence classes of the lines.  The kernels compare several lines
+   at a time and are selected at startup based on what the CPU supports.  */
+
+lin snake_forward_run (lin const *xv, lin const *yv, lin n);
+lin snake_backward_run (lin const *xv, lin const *yv, lin n);
+
+/* A forward and a backward kernel for one instruction set, so that they
+   can be tested against each other.  */
+
+struct snake_kernel
+{
+  char const *name;
+  lin (*forward) (lin const *xv, lin const *yv, lin n);
+  lin (*backward) (lin const *xv, lin const *yv, lin n);
+};
+
+/* Store the kernels that this CPU can run in *KERNELS, the scalar ones
+   first, and return how many there are.  */
+
+int snake_kernels (struct snake_kernel const **kernels);
+
+/* Return the number of leading elements, at most N, that are equal in XV
+   and YV.  Most snakes are very short, so the first lines are compared
+   before calling one of the kernels.  */
+
+static inline lin
+snake_forward (lin const *xv, lin const *yv, lin n)
+{
+  if (n <= 0 || xv[0] != yv[0])
+    return 0;
+  if (n == 1 || xv[1] != yv[1])
+    return 1;
+  return 2 + snake_forward_run (xv + 2, yv + 2, n - 2);
+}
+
+/* Return the number of elements, at most N, that are equal in XV and YV
+   going backwards from (and not including) XV[0] and YV[0].  */
+
+static inline lin
+snake_backward (lin const *xv, lin const *yv, lin n)
+{
+  if (n <= 0 || xv[-1] != yv[-1])
+    return 0;
+  if (n == 1 || xv[-2] != yv[-2])
+    return 1;
+  return 2 + snake_backward_run (xv - 2, yv - 2, n - 2);
+}
@@ -0,0 +1,111 @@
+/* This file is a stub */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "xalloc.h"
+
+/* Freeing is done by xfree, which is called through the free macro, so make
+   sure the real free is called here.  */
+#undef free
+
+#define ARENA_ALIGNMENT 16
+#define ARENA_MIN_BLOCK_SIZE (1024 * 1024)
+
+struct arena_block
+{
+  struct arena_block *next;	/* Previously filled block, if any.  */
+  size_t size;			/* Usable size of data.  */
+  size_t used;			/* Bytes of data handed out so far.  */
+  _Alignas (ARENA_ALIGNMENT) char data[];
+};
+
+/* The block allocations are currently taken from.  Older blocks that
+   filled up during this comparison are linked from it.  Each thread has an
+   arena of its own, so comparisons can run concurrently.  */
+static _Thread_local struct arena_block *current_block;
+
+static struct arena_block *
+new_block (size_t size, struct arena_block *next)
+{
+  struct arena_block *block = malloc (sizeof *block + size);
+  if (!block)
+    {
+      fputs ("memory exhausted\n", stderr);
+      abort ();
+    }
+  block->next = next;
+  block->size = size;
+  block->used = 0;
+  return block;
+}
+
+void *
+xmalloc (size_t n)
+{
+  void *p;
+
+  n = (n + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+
+  if (!current_block || current_block->size - current_block->used < n)
+    {
+      /* Grow geometrically so that the number of blocks stays small even
+         if the first comparison starts with an empty arena.  */
+      size_t size = current_block ? 2 * current_block->size
+                                  : ARENA_MIN_BLOCK_SIZE;
+      if (size < n)
+        size = n;
+      current_block = new_block (size, current_block);
+    }
+
+  p = current_block->data + current_block->used;
+  current_block->used += n;
+  return p;
+}
+
+void
+xfree (void *p)
+{
+  /* Released all at once by arena_reset.  */
+  (void) p;
+}
+
+/* Make all memory in the arena available again.  If the last comparison
+   needed more than one block, replace them by a single block that is large
+   enough for all of them, so that a comparison of similar size does not need
+   to call malloc at all.  */
+
+void
+arena_reset (void)
+{
+  struct arena_block *block;
+  size_t total = 0;
+
+  if (!current_block)
+    return;
+
+  if (!current_block->next)
+    {
+      current_block->used = 0;
+      return;
+    }
+
+  for (block = current_block; block; block = block->next)
+    total += block->used;
+
+  arena_release ();
+  current_block = new_block (total, NULL);
+}
+
+/* Return all memory held by the arena to the system.  */
+
+void
+arena_release (void)
+{
+  while (current_block)
+    {
+      struct arena_block *next = current_block->next;
+      free (current_block);
+      current_block = next;
+    }
+}
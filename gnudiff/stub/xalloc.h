@@ -1,2 +1,16 @@
+/* This header is a stub */
 
-#define xmalloc malloc
+#include <stddef.h>
+
+/* All working memory of a comparison is taken from an arena that is rewound
+   at the end of diff_2_files, so the memory (and the pages backing it) is
+   reused by the next comparison instead of being returned to the system.
+   The arena belongs to the calling thread.  */
+
+void *xmalloc (size_t n);
+void xfree (void *p);
+void arena_reset (void);
+void arena_release (void);
+
+/* Memory from the arena cannot be freed individually. */
+#define free xfree
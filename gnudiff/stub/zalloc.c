@@ -1,7 +1,7 @@
 #include "diff.h"
+#include "xalloc.h"
 
 void *zalloc (size_t n)
 {
-  return calloc(n, 1);
+  return memset (xmalloc (n), 0, n);
 }
-
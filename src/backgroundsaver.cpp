@@ -0,0 +1,137 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include "backgroundsaver.h"
+
+BackgroundSaver::BackgroundSaver(unsigned nrOfThreads):
+    m_workerPool(nrOfThreads),
+    m_thread(&BackgroundSaver::saverLoop, this)
+{
+}
+
+BackgroundSaver::~BackgroundSaver()
+{
+    /* The last requested save is what the user expects to find on disk
+     * after quitting, so it is finished rather than cancelled */
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobAdded.notify_one();
+    m_thread.join();
+}
+
+void BackgroundSaver::save(const ContentMapper& contentMapper,
+                           const std::string& outputFileName,
+                           const std::vector<ILineProvider*>& lineProviders,
+                           const std::vector<std::string>& labels)
+{
+    /* Reading lines only changes a line provider while it still has to
+     * find line endings, so after this the saver can read them at the same
+     * time as the user interface */
+    for(auto lineProvider: lineProviders)
+    {
+        lineProvider->getLastLineNumber();
+    }
+
+    auto job = std::make_unique<Job>(Job{ contentMapper.createSnapshot(), outputFileName, lineProviders, labels });
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pendingJob = std::move(job);
+        if(m_progress)
+        {
+            m_progress->cancelled = true;
+        }
+        m_state = State::SAVING;
+    }
+    m_jobAdded.notify_one();
+}
+
+BackgroundSaver::Status BackgroundSaver::getStatus() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Status status{ m_state, 0, 0, m_conflicts, m_error };
+    if(m_progress)
+    {
+        status.bytesWritten = m_progress->bytesWritten;
+        status.totalBytes = m_progress->totalBytes;
+    }
+    return status;
+}
+
+void BackgroundSaver::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobDone.wait(lock, [this] { return !m_pendingJob && !m_progress; });
+}
+
+void BackgroundSaver::saverLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_jobAdded.wait(lock, [this] { return m_stop || m_pendingJob; });
+        if(m_stop)
+        {
+            return;
+        }
+
+        auto job = std::move(m_pendingJob);
+        auto progress = std::make_shared<SaveProgress>();
+        m_progress = progress;
+        lock.unlock();
+
+        State state = State::SAVED;
+        size_t conflicts = 0;
+        std::string error;
+        try
+        {
+            conflicts = saveMergeResult(job->outputFileName, job->snapshot, job->lineProviders, job->labels,
+                                        m_workerPool, progress.get());
+        }
+        catch(SaveCancelled&)
+        {
+            /* Superseded by the pending job */
+        }
+        catch(std::exception& e)
+        {
+            state = State::FAILED;
+            error = e.what();
+        }
+        job.reset();
+
+        lock.lock();
+        m_progress.reset();
+        if(!progress->cancelled && !m_pendingJob)
+        {
+            m_state = state;
+            m_conflicts = conflicts;
+            m_error = error;
+        }
+        m_jobDone.notify_all();
+    }
+}
@@ -0,0 +1,124 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "contentmapper.h"
+#include "ilineprovider.h"
+#include "mergeresultwriter.h"
+#include "workerpool.h"
+
+/**
+ * Saves merge results on a background thread, so that the user interface
+ * stays responsive and the user can keep editing while a save is going on.
+ *
+ * Every save works on a snapshot of the content mapper that is taken when
+ * it is requested. A save that is requested while another one is going on
+ * cancels that one, so only the latest merge result is written. Saves use
+ * their own worker pool, so they do not hold up other parallel stages.
+ *
+ * Destroying the saver waits until the latest requested save is done.
+ */
+class BackgroundSaver
+{
+public:
+    enum class State
+    {
+        IDLE,
+        SAVING,
+        SAVED,
+        FAILED
+    };
+
+    struct Status
+    {
+        State state;
+
+        /** The progress of the save that is going on */
+        size_t bytesWritten;
+        size_t totalBytes;
+
+        /** The result of the last save once it is SAVED or FAILED */
+        size_t conflicts;
+        std::string error;
+    };
+
+    explicit BackgroundSaver(unsigned nrOfThreads = std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    ~BackgroundSaver();
+
+    BackgroundSaver(const BackgroundSaver&) = delete;
+    BackgroundSaver& operator=(const BackgroundSaver&) = delete;
+
+    /**
+     * Starts saving the current merge result. Only the snapshot is taken on
+     * the calling thread. The line providers must remain valid until the
+     * save is done.
+     */
+    void save(const ContentMapper& contentMapper,
+              const std::string& outputFileName,
+              const std::vector<ILineProvider*>& lineProviders,
+              const std::vector<std::string>& labels);
+
+    Status getStatus() const;
+
+    /**
+     * Waits until all requested saves are done.
+     */
+    void wait();
+
+private:
+    struct Job
+    {
+        ContentMapper snapshot;
+        std::string outputFileName;
+        std::vector<ILineProvider*> lineProviders;
+        std::vector<std::string> labels;
+    };
+
+    void saverLoop();
+
+    WorkerPool m_workerPool;
+
+    /** Protects the members below */
+    mutable std::mutex m_mutex;
+    std::condition_variable m_jobAdded;
+    std::condition_variable m_jobDone;
+    bool m_stop = false;
+    std::unique_ptr<Job> m_pendingJob;
+    std::shared_ptr<SaveProgress> m_progress;
+    State m_state = State::IDLE;
+    size_t m_conflicts = 0;
+    std::string m_error;
+
+    std::thread m_thread;
+};
@@ -0,0 +1,121 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "bytecompare.h"
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "finding the first differing byte in a word assumes little endian");
+
+/* Large blocks are compared with memcmp, which the C library implements with
+ * the widest vector instructions available on the CPU it runs on. Only the
+ * block that contains the first difference is searched word by word.
+ */
+static const size_t blockSize = 4096;
+
+static uint64_t loadWord(const char *p)
+{
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static size_t equalBytesAtStartOfBlock(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        uint64_t diff = loadWord(a + i) ^ loadWord(b + i);
+        if(diff != 0)
+        {
+            return i + __builtin_ctzll(diff) / 8;
+        }
+    }
+    while(i < n && a[i] == b[i])
+    {
+        i++;
+    }
+    return i;
+}
+
+static size_t equalBytesAtEndOfBlock(const char *a, const char *b, size_t n)
+{
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t))
+    {
+        uint64_t diff = loadWord(a + n - i - sizeof(uint64_t)) ^ loadWord(b + n - i - sizeof(uint64_t));
+        if(diff != 0)
+        {
+            return i + __builtin_clzll(diff) / 8;
+        }
+    }
+    while(i < n && a[n - i - 1] == b[n - i - 1])
+    {
+        i++;
+    }
+    return i;
+}
+
+size_t commonPrefixLength(std::string_view a, std::string_view b)
+{
+    size_t length = std::min(a.size(), b.size());
+    size_t offset = 0;
+
+    while(offset < length)
+    {
+        size_t n = std::min(blockSize, length - offset);
+        if(memcmp(a.data() + offset, b.data() + offset, n) != 0)
+        {
+            return offset + equalBytesAtStartOfBlock(a.data() + offset, b.data() + offset, n);
+        }
+        offset += n;
+    }
+
+    return length;
+}
+
+size_t commonSuffixLength(std::string_view a, std::string_view b)
+{
+    size_t length = std::min(a.size(), b.size());
+    const char *endA = a.data() + a.size();
+    const char *endB = b.data() + b.size();
+    size_t offset = 0;
+
+    while(offset < length)
+    {
+        size_t n = std::min(blockSize, length - offset);
+        if(memcmp(endA - offset - n, endB - offset - n, n) != 0)
+        {
+            return offset + equalBytesAtEndOfBlock(endA - offset - n, endB - offset - n, n);
+        }
+        offset += n;
+    }
+
+    return length;
+}
@@ -0,0 +1,145 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * A vector of fixed size whose elements are stored in chunks that copies of
+ * it share.
+ *
+ * Copying a chunked vector only copies a pointer for every CHUNK_SIZE
+ * elements. A chunk is copied the first time one of its elements is
+ * changed after it became shared, so changing an element of a copy takes
+ * O(CHUNK_SIZE) once and O(1) after that. A shared chunk is never changed,
+ * so a copy can be read by another thread while the original is changed.
+ *
+ * Copying changes the original as well, as from then on the original no
+ * longer owns its chunks, so it must be done on the thread that changes
+ * the original.
+ */
+template <typename T>
+class ChunkedVector
+{
+public:
+    static constexpr size_t CHUNK_SIZE = 256;
+
+    ChunkedVector() = default;
+
+    explicit ChunkedVector(std::vector<T> elements):
+        m_size(elements.size())
+    {
+        for(size_t first = 0; first < m_size; first += CHUNK_SIZE)
+        {
+            auto begin = elements.begin() + first;
+            auto end = elements.begin() + std::min(first + CHUNK_SIZE, m_size);
+            m_chunks.push_back(std::make_shared<Chunk>(std::make_move_iterator(begin), std::make_move_iterator(end)));
+        }
+        m_isOwned.assign(m_chunks.size(), true);
+    }
+
+    ChunkedVector(size_t size, const T& value):
+        ChunkedVector(std::vector<T>(size, value))
+    {
+    }
+
+    ChunkedVector(const ChunkedVector& other):
+        m_chunks(other.m_chunks),
+        m_isOwned(other.m_chunks.size(), false),
+        m_size(other.m_size)
+    {
+        other.m_isOwned.assign(other.m_chunks.size(), false);
+    }
+
+    ChunkedVector& operator=(const ChunkedVector& other)
+    {
+        return *this = ChunkedVector(other);
+    }
+
+    ChunkedVector(ChunkedVector&& other) noexcept:
+        m_chunks(std::move(other.m_chunks)),
+        m_isOwned(std::move(other.m_isOwned)),
+        m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    ChunkedVector& operator=(ChunkedVector&& other) noexcept
+    {
+        m_chunks = std::move(other.m_chunks);
+        m_isOwned = std::move(other.m_isOwned);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    const T& operator[](size_t index) const
+    {
+        assert(index < m_size);
+        return (*m_chunks[index / CHUNK_SIZE])[index % CHUNK_SIZE];
+    }
+
+    /**
+     * Returns an element that can be changed, after copying its chunk if
+     * that is shared.
+     */
+    T& modify(size_t index)
+    {
+        assert(index < m_size);
+        size_t chunk = index / CHUNK_SIZE;
+        if(!m_isOwned[chunk])
+        {
+            m_chunks[chunk] = std::make_shared<Chunk>(*m_chunks[chunk]);
+            m_isOwned[chunk] = true;
+        }
+        return (*m_chunks[chunk])[index % CHUNK_SIZE];
+    }
+
+private:
+    using Chunk = std::vector<T>;
+
+    std::vector<std::shared_ptr<Chunk>> m_chunks;
+
+    /** Whether no copy shares a chunk, in which case it can be changed in
+     *  place */
+    mutable std::vector<bool> m_isOwned;
+
+    size_t m_size = 0;
+};
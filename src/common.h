@@ -46,6 +46,11 @@ struct Diff
 
     int diff1;
     int diff2;
+
+    bool operator==(const Diff& other) const
+    {
+        return nofEquals == other.nofEquals && diff1 == other.diff1 && diff2 == other.diff2;
+    }
 };
 
 using DiffList = std::vector<Diff>;
@@ -74,10 +79,19 @@ struct StyleFragment
 {
     DiffStyle style;
     int length;
+
+    bool operator==(const StyleFragment& other) const
+    {
+        return style == other.style && length == other.length;
+    }
 };
 
 using StyleList = std::vector<StyleFragment>;
 
+/**
+ * A single row of the alignment of the three input files. Complete alignments
+ * are stored in a Diff3Table, which also holds the styles of the lines.
+ */
 struct Diff3Line
 {
     int lineA = -1;
@@ -88,10 +102,6 @@ struct Diff3Line
     bool bAEqC = false;
     bool bBEqC = false;
 
-    StyleList styleA;
-    StyleList styleB;
-    StyleList styleC;
-
     int& line(int i)
     {
         switch(i)
@@ -119,26 +129,8 @@ struct Diff3Line
             return bBEqC;
         }
     }
-
-    StyleList& style(int i)
-    {
-        switch(i)
-        {
-        case 0:
-            return styleA;
-        case 1:
-            return styleB;
-        case 2:
-            return styleC;
-        default:
-            assert(false);
-        }
-    }
 };
 
-using Diff3LineList = std::vector<Diff3Line>;
-//using Diff3LineArray = std::array<Diff3Line>;
-
 #if 0
 template where(T)
 {
@@ -0,0 +1,649 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <optional>
+
+#include "contentmapper.h"
+
+static int index(LineSource lineSource)
+{
+    assert(lineSource != LineSource::UNDEFINED);
+    return static_cast<int>(lineSource);
+}
+
+MergeResultSection::MergeResultSection(bool isDifference,
+                                       int firstInputLineA, int lastInputLineA,
+                                       int firstInputLineB, int lastInputLineB,
+                                       int firstInputLineC, int lastInputLineC,
+                                       int firstDiff3Line, int lastDiff3Line):
+    m_inputLineNumbers{ LineNumberRange(firstInputLineA, lastInputLineA),
+                        LineNumberRange(firstInputLineB, lastInputLineB),
+                        LineNumberRange(firstInputLineC, lastInputLineC) },
+    m_diff3LineNumbers(firstDiff3Line, lastDiff3Line),
+    m_isDifference(isDifference)
+{
+}
+
+LineNumberRange MergeResultSection::getLineNumberRange(LineSource lineSource) const
+{
+    return m_inputLineNumbers[index(lineSource)];
+}
+
+LineNumberRange MergeResultSection::getDiff3LineNumberRange() const
+{
+    return m_diff3LineNumbers;
+}
+
+bool MergeResultSection::isDifference() const
+{
+    return m_isDifference;
+}
+
+int MergeResultSection::getOutputSize() const
+{
+    if(m_edits)
+    {
+        /* If the edits have removed all lines of a difference section, it
+         * consists of a single "no source line" line. A section in which the
+         * input files are the same just disappears. */
+        int numberOfLines = m_edits->size();
+        if(numberOfLines == 0 && m_isDifference)
+        {
+            numberOfLines = 1;
+        }
+        return numberOfLines;
+    }
+    return getUneditedOutputSize();
+}
+
+int MergeResultSection::getUneditedOutputSize() const
+{
+    int count = 0;
+
+    if(m_isDifference)
+    {
+        if(m_selectedSources.empty())
+        {
+            /* <unresolved conflict> */
+            count = 1;
+        }
+        else
+        {
+            for(auto selectedSource: m_selectedSources)
+            {
+                auto& lineNumbers = m_inputLineNumbers[index(selectedSource)];
+                if(lineNumbers.firstLine == -1)
+                {
+                    count += 1;
+                }
+                else
+                {
+                    count += lineNumbers.lastLine - lineNumbers.firstLine + 1;
+                }
+            }
+        }
+    }
+    else
+    {
+        auto& lineNumbers = m_inputLineNumbers[index(DEFAULT_LINE_SOURCE)];
+        count = lineNumbers.lastLine - lineNumbers.firstLine + 1;
+    }
+
+    return count;
+}
+
+void MergeResultSection::toggle(LineSource lineSource)
+{
+    assert(m_isDifference);
+
+    m_edits.reset();
+
+    auto it = std::find(m_selectedSources.begin(), m_selectedSources.end(), lineSource);
+    if(it != m_selectedSources.end())
+    {
+        m_selectedSources.erase(it);
+    }
+    else
+    {
+        m_selectedSources.push_back(lineSource);
+    }
+}
+
+LineInfo MergeResultSection::getLineInfo(int relativeLineNumber) const
+{
+    if(m_edits)
+    {
+        LineInfo lineInfo;
+        lineInfo.state = LineState::EDITED;
+        lineInfo.sectionIndex = -1;
+
+        if(m_edits->size() == 0)
+        {
+            /* The "no source line" line of a section whose lines were all removed */
+            assert(relativeLineNumber == 0);
+            lineInfo.lineNumber = -1;
+            return lineInfo;
+        }
+
+        auto line = m_edits->getLine(relativeLineNumber);
+        if(line.isOriginal)
+        {
+            return getUneditedLineInfo(line.index);
+        }
+        lineInfo.lineNumber = relativeLineNumber;
+        return lineInfo;
+    }
+    return getUneditedLineInfo(relativeLineNumber);
+}
+
+LineInfo MergeResultSection::getUneditedLineInfo(int relativeLineNumber) const
+{
+    LineInfo lineInfo;
+
+    if(m_isDifference)
+    {
+        if(m_selectedSources.empty())
+        {
+            assert(relativeLineNumber == 0);
+
+            lineInfo.state = LineState::UNSELECTED;
+            lineInfo.source = LineSource::UNDEFINED;
+            lineInfo.lineNumber = -1;
+            return lineInfo;
+        }
+
+        for(auto selectedSource: m_selectedSources)
+        {
+            auto& lineNumbers = m_inputLineNumbers[index(selectedSource)];
+            bool selectedSourceHasNoLines = (lineNumbers.firstLine == -1);
+            int linesFromSelectedSource = selectedSourceHasNoLines ? 1 : lineNumbers.lastLine - lineNumbers.firstLine + 1;
+
+            if(relativeLineNumber < linesFromSelectedSource)
+            {
+                lineInfo.state = LineState::ORIGINAL;
+                lineInfo.source = selectedSource;
+                lineInfo.lineNumber = selectedSourceHasNoLines ? -1 : lineNumbers.firstLine + relativeLineNumber;
+                return lineInfo;
+            }
+
+            relativeLineNumber -= linesFromSelectedSource;
+        }
+        assert(false);
+    }
+
+    auto& lineNumbers = m_inputLineNumbers[index(DEFAULT_LINE_SOURCE)];
+    auto inputLineNumber = lineNumbers.firstLine + relativeLineNumber;
+    assert(inputLineNumber <= lineNumbers.lastLine);
+
+    lineInfo.state = LineState::ORIGINAL;
+    lineInfo.source = LineSource::C;
+    lineInfo.lineNumber = inputLineNumber;
+    return lineInfo;
+}
+
+bool MergeResultSection::isSolved() const
+{
+    return !m_isDifference || !m_selectedSources.empty();
+}
+
+bool MergeResultSection::isEdited() const
+{
+    return m_edits != nullptr;
+}
+
+const std::vector<LineSource>& MergeResultSection::getSelectedSources() const
+{
+    return m_selectedSources;
+}
+
+void MergeResultSection::applyModification(const Modification& modification)
+{
+    auto edits = std::make_shared<PieceTable>(m_edits ? *m_edits : PieceTable(getUneditedOutputSize()));
+
+    /* The "no source line" line of a section without lines can be replaced,
+     * but there is nothing to remove for it */
+    assert(modification.firstLine >= 0);
+    assert(modification.firstLine + modification.originalLineCount <= getOutputSize());
+    int firstLine = std::min(modification.firstLine, edits->size());
+    int originalLineCount = std::min(modification.originalLineCount, edits->size() - firstLine);
+
+    edits->replace(firstLine, originalLineCount, modification.lines);
+    m_edits = std::move(edits);
+}
+
+std::string_view MergeResultSection::getEditedLine(int relativeLineNumber) const
+{
+    assert(m_edits);
+    auto line = m_edits->getLine(relativeLineNumber);
+    assert(!line.isOriginal);
+    return line.text;
+}
+
+MergeResultSections ContentMapper::calculateMergeResultSections(const Diff3Table& diff3Table)
+{
+    MergeResultSections mergeResultSections;
+
+    int prevEquality = -1;
+    size_t d3lIndex = 0;
+    while(d3lIndex < diff3Table.size())
+    {
+        auto d3l = diff3Table.get(d3lIndex);
+        int equality = (d3l.bAEqB ? 1 : 0) | (d3l.bAEqC ? 2 : 0) | (d3l.bBEqC ? 4 : 0);
+
+        /* A run of equal rows extends the section at once, so only its first
+         * and last row are looked at */
+        size_t nextIndex = diff3Table.endOfEqualRun(d3lIndex);
+        auto lastD3l = (nextIndex - d3lIndex > 1) ? diff3Table.get(nextIndex - 1) : d3l;
+
+        if(equality != prevEquality)
+        {
+            mergeResultSections.emplace_back(equality != 7,
+                                             d3l.lineA, lastD3l.lineA,
+                                             d3l.lineB, lastD3l.lineB,
+                                             d3l.lineC, lastD3l.lineC,
+                                             d3lIndex, nextIndex - 1);
+        }
+        else
+        {
+            auto& section = mergeResultSections.back();
+            for(int i = 0; i < 3; i++)
+            {
+                /* A file may have no line in the first rows of a section */
+                auto& lineNumbers = section.m_inputLineNumbers[i];
+                if(lineNumbers.firstLine == -1) lineNumbers.firstLine = d3l.line(i);
+                if(lastD3l.line(i) != -1) lineNumbers.lastLine = lastD3l.line(i);
+            }
+            section.m_diff3LineNumbers.lastLine = nextIndex - 1;
+        }
+        prevEquality = equality;
+        d3lIndex = nextIndex;
+    }
+
+    for([[maybe_unused]] auto& section: mergeResultSections)
+    {
+        for([[maybe_unused]] auto& lineNumbers: section.m_inputLineNumbers)
+        {
+            assert((lineNumbers.firstLine == -1) == (lineNumbers.lastLine == -1));
+        }
+    }
+
+    return mergeResultSections;
+}
+
+void ContentMapper::determineMergeResultSections(const Diff3Table& diff3Table)
+{
+    assert(m_mergeResultSections.empty());
+    m_mergeResultSections = ChunkedVector<MergeResultSection>(calculateMergeResultSections(diff3Table));
+    indexSections();
+}
+
+void ContentMapper::setMergeResultSections(MergeResultSections mergeResultSections)
+{
+    assert(m_mergeResultSections.empty());
+    m_mergeResultSections = ChunkedVector<MergeResultSection>(std::move(mergeResultSections));
+    indexSections();
+}
+
+void ContentMapper::indexSections()
+{
+    std::vector<int> outputSizes;
+    outputSizes.reserve(m_mergeResultSections.size());
+    m_differences = IndexSet(m_mergeResultSections.size());
+    m_unsolvedDifferences = IndexSet(m_mergeResultSections.size());
+    for(size_t i = 0; i < m_mergeResultSections.size(); i++)
+    {
+        auto& section = m_mergeResultSections[i];
+        outputSizes.push_back(section.getOutputSize());
+        m_differences.set(i, section.isDifference());
+        m_unsolvedDifferences.set(i, !section.isSolved());
+    }
+    m_outputSizes = FenwickTree(outputSizes);
+
+    /* The sections the history refers to may no longer exist */
+    m_history.clear();
+    m_historyPosition = 0;
+}
+
+void ContentMapper::automaticallyResolveDifferences(const Diff3Table& diff3Table,
+                                                    const LineEquivalences *lineEquivalences)
+{
+    assert(!m_mergeResultSections.empty());
+
+    for(size_t i = 0; i < m_mergeResultSections.size(); i++)
+    {
+        if(!m_mergeResultSections[i].m_isDifference)
+            continue;
+
+        auto& section = m_mergeResultSections.modify(i);
+        auto d3l = diff3Table.get(section.m_diff3LineNumbers.firstLine);
+
+        if(d3l.bAEqC)
+        {
+            /* Everything is the same, but we shouldn't have come here for non-difference sections */
+            assert(!d3l.bAEqB);
+            section.toggle(LineSource::B);
+        }
+        else if(d3l.bAEqB)
+        {
+            section.toggle(LineSource::C);
+        }
+        else if(d3l.bBEqC)
+        {
+            /* Choose either B or C */
+            section.toggle(LineSource::C);
+        }
+        else
+        {
+            /* The rows do not necessarily line up all lines that are equal,
+             * so the files can still be the same over the whole section */
+            auto& lines = section.m_inputLineNumbers;
+            if(lineEquivalences != nullptr && lineEquivalences->equal(0, lines[0], 2, lines[2]))
+            {
+                section.toggle(LineSource::B);
+            }
+            else if(lineEquivalences != nullptr && (lineEquivalences->equal(0, lines[0], 1, lines[1]) ||
+                                                    lineEquivalences->equal(1, lines[1], 2, lines[2])))
+            {
+                section.toggle(LineSource::C);
+            }
+            else
+            {
+                /* Unresolvable conflict, don't choose anything */
+            }
+        }
+    }
+
+    indexSections();
+}
+
+LineInfo ContentMapper::getMergeResultLineInfo(int lineInMergeResultPane) const
+{
+    if(lineInMergeResultPane >= 0)
+    {
+        int relativeLineNumber;
+        size_t sectionIndex = m_outputSizes.find(lineInMergeResultPane, relativeLineNumber);
+        if(sectionIndex < m_mergeResultSections.size())
+        {
+            auto lineInfo = m_mergeResultSections[sectionIndex].getLineInfo(relativeLineNumber);
+            if(lineInfo.state == LineState::EDITED)
+            {
+                lineInfo.sectionIndex = static_cast<int>(sectionIndex);
+            }
+            return lineInfo;
+        }
+    }
+
+    LineInfo lineInfo;
+    lineInfo.state = LineState::NONE;
+    lineInfo.source = LineSource::UNDEFINED;
+    lineInfo.lineNumber = -1;
+    return lineInfo;
+}
+
+size_t ContentMapper::getNumberOfSections() const
+{
+    return m_mergeResultSections.size();
+}
+
+const MergeResultSection& ContentMapper::getSection(size_t sectionIndex) const
+{
+    assert(sectionIndex < m_mergeResultSections.size());
+    return m_mergeResultSections[sectionIndex];
+}
+
+SectionInfo ContentMapper::getSectionInfo(size_t sectionIndex) const
+{
+    auto& section = getSection(sectionIndex);
+    int firstLine = m_outputSizes.prefixSum(sectionIndex);
+    int lastLine = firstLine + m_outputSizes.get(sectionIndex) - 1;
+
+    return SectionInfo{ section.m_diff3LineNumbers,
+                        LineNumberRange(firstLine, lastLine),
+                        section.m_isDifference };
+}
+
+int ContentMapper::findNext(const IndexSet& sections, int sectionIndex)
+{
+    size_t found = sections.findFrom(static_cast<size_t>(sectionIndex + 1));
+    return (found == IndexSet::npos) ? -1 : static_cast<int>(found);
+}
+
+int ContentMapper::findPrevious(const IndexSet& sections, int sectionIndex)
+{
+    if(sectionIndex <= 0)
+    {
+        return -1;
+    }
+    size_t found = sections.findUpTo(static_cast<size_t>(sectionIndex - 1));
+    return (found == IndexSet::npos) ? -1 : static_cast<int>(found);
+}
+
+int ContentMapper::findNextDifference(int sectionIndex) const
+{
+    return findNext(m_differences, sectionIndex);
+}
+
+int ContentMapper::findNextUnsolvedDifference(int sectionIndex) const
+{
+    return findNext(m_unsolvedDifferences, sectionIndex);
+}
+
+int ContentMapper::findPreviousDifference(int sectionIndex) const
+{
+    return findPrevious(m_differences, sectionIndex);
+}
+
+int ContentMapper::findPreviousUnsolvedDifference(int sectionIndex) const
+{
+    return findPrevious(m_unsolvedDifferences, sectionIndex);
+}
+
+bool ContentMapper::allDifferencesSolved() const
+{
+    return m_unsolvedDifferences.count() == 0;
+}
+
+void ContentMapper::applyModification(Modification modification)
+{
+    if(modification.firstLine < 0)
+    {
+        return;
+    }
+
+    /* The listener is told about the modification as it was requested */
+    std::optional<Modification> requestedModification;
+    if(m_actionListener != nullptr)
+    {
+        requestedModification = modification;
+    }
+
+    int firstLine;
+    size_t sectionIndex = m_outputSizes.find(modification.firstLine, firstLine);
+    modification.firstLine = firstLine;
+
+    /* A modification that extends beyond the section removes the lines it
+     * covers in the sections that follow */
+    HistoryEntry entry;
+    for(; sectionIndex < m_mergeResultSections.size(); sectionIndex++)
+    {
+        auto& section = m_mergeResultSections.modify(sectionIndex);
+        int sectionSize = m_outputSizes.get(sectionIndex);
+        int linesInFollowingSections = modification.firstLine + modification.originalLineCount - sectionSize;
+        if(linesInFollowingSections > 0)
+        {
+            modification.originalLineCount -= linesInFollowingSections;
+        }
+
+        entry.push_back(saveSectionState(sectionIndex));
+        section.applyModification(modification);
+        sectionChanged(sectionIndex);
+
+        if(linesInFollowingSections <= 0)
+        {
+            break;
+        }
+        modification = Modification{ 0, linesInFollowingSections, {} };
+    }
+
+    if(!entry.empty())
+    {
+        addHistoryEntry(std::move(entry));
+        if(m_actionListener != nullptr)
+        {
+            m_actionListener->modificationApplied(*requestedModification);
+        }
+    }
+}
+
+std::string_view ContentMapper::getEditedLine(size_t sectionIndex, int lineNumber) const
+{
+    return getSection(sectionIndex).getEditedLine(lineNumber);
+}
+
+void ContentMapper::toggleSectionSource(size_t sectionIndex, LineSource lineSource)
+{
+    assert(sectionIndex < m_mergeResultSections.size());
+
+    addHistoryEntry({ saveSectionState(sectionIndex) });
+    m_mergeResultSections.modify(sectionIndex).toggle(lineSource);
+    sectionChanged(sectionIndex);
+    if(m_actionListener != nullptr)
+    {
+        m_actionListener->sectionToggled(sectionIndex, lineSource);
+    }
+}
+
+int ContentMapper::getContentHeight() const
+{
+    return m_outputSizes.total();
+}
+
+bool ContentMapper::undo()
+{
+    if(m_historyPosition == 0)
+    {
+        return false;
+    }
+    m_historyPosition--;
+    swapStates(m_history[m_historyPosition]);
+    if(m_actionListener != nullptr)
+    {
+        m_actionListener->actionUndone();
+    }
+    return true;
+}
+
+bool ContentMapper::redo()
+{
+    if(m_historyPosition == m_history.size())
+    {
+        return false;
+    }
+    swapStates(m_history[m_historyPosition]);
+    m_historyPosition++;
+    if(m_actionListener != nullptr)
+    {
+        m_actionListener->actionRedone();
+    }
+    return true;
+}
+
+size_t ContentMapper::getHistoryPosition() const
+{
+    return m_historyPosition;
+}
+
+size_t ContentMapper::getHistorySize() const
+{
+    return m_history.size();
+}
+
+void ContentMapper::goToHistoryPosition(size_t historyPosition)
+{
+    assert(historyPosition <= m_history.size());
+    while(m_historyPosition > historyPosition)
+    {
+        undo();
+    }
+    while(m_historyPosition < historyPosition)
+    {
+        redo();
+    }
+}
+
+void ContentMapper::setActionListener(IActionListener *actionListener)
+{
+    m_actionListener = actionListener;
+}
+
+ContentMapper ContentMapper::createSnapshot() const
+{
+    ContentMapper snapshot;
+    snapshot.m_mergeResultSections = m_mergeResultSections;
+    snapshot.m_outputSizes = m_outputSizes;
+    snapshot.m_differences = m_differences;
+    snapshot.m_unsolvedDifferences = m_unsolvedDifferences;
+    return snapshot;
+}
+
+ContentMapper::SectionState ContentMapper::saveSectionState(size_t sectionIndex) const
+{
+    auto& section = m_mergeResultSections[sectionIndex];
+    return SectionState{ sectionIndex, section.m_selectedSources, section.m_edits };
+}
+
+void ContentMapper::addHistoryEntry(HistoryEntry entry)
+{
+    m_history.resize(m_historyPosition);
+    m_history.push_back(std::move(entry));
+    m_historyPosition++;
+}
+
+/**
+ * Exchanges the states in the entry with the current ones of their
+ * sections, which undoes the action if it was done and redoes it if not.
+ */
+void ContentMapper::swapStates(HistoryEntry& entry)
+{
+    for(auto& state: entry)
+    {
+        auto& section = m_mergeResultSections.modify(state.sectionIndex);
+        std::swap(section.m_selectedSources, state.selectedSources);
+        std::swap(section.m_edits, state.edits);
+        sectionChanged(state.sectionIndex);
+    }
+}
+
+/**
+ * Brings the indices up to date after a change to a section.
+ */
+void ContentMapper::sectionChanged(size_t sectionIndex)
+{
+    auto& section = m_mergeResultSections[sectionIndex];
+    m_outputSizes.set(sectionIndex, section.getOutputSize());
+    m_unsolvedDifferences.set(sectionIndex, !section.isSolved());
+}
@@ -0,0 +1,339 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "chunkedvector.h"
+#include "common.h"
+#include "diff3table.h"
+#include "fenwicktree.h"
+#include "indexset.h"
+#include "lineequivalences.h"
+#include "piecetable.h"
+
+enum class LineSource
+{
+    A,
+    B,
+    C,
+    UNDEFINED
+};
+
+enum class LineState
+{
+    ORIGINAL,
+    EDITED,
+    UNSELECTED,
+    NONE
+};
+
+/**
+ * Information about the location of a section within the content for each
+ * pane, as well as the difference status of the section.
+ */
+struct SectionInfo
+{
+    /** The content line numbers in the input panes associated with the section */
+    LineNumberRange inputPaneLineNumbers;
+
+    /** The content line numbers in the merge result pane associated with the section */
+    LineNumberRange mergeResultPaneLineNumbers;
+
+    /** Whether or not the section represents a difference between input files */
+    bool isDifference;
+};
+
+/**
+ * Information about a line that indicates where the text of that line is stored.
+ */
+struct LineInfo
+{
+    /** Whether this line is from one of the input files (ORIGINAL) or has been modified by the user (EDITED) */
+    LineState state;
+    union
+    {
+        /** The input file this line is from (A/B/C) (only if state is ORIGINAL) */
+        LineSource source;
+        /** The section index of the section that contains the edited line (only if state is EDITED) */
+        int sectionIndex;
+    };
+    /** The line number in the input file if state is ORIGINAL or the line number relative to the start of the section if state is EDITED. */
+    int lineNumber;
+};
+
+/**
+ * A line-based modification of text, which replaces a number of lines by
+ * the lines that are contained in the modification.
+ */
+struct Modification
+{
+    /** The first line that is replaced, relative to the start of the content
+     *  the modification is applied to */
+    int firstLine;
+
+    /** The number of lines that are replaced */
+    int originalLineCount;
+
+    /** The replacement lines */
+    std::vector<std::string> lines;
+};
+
+/**
+ * The MergeResultSection maintains the user's conflict resolution choices for
+ * a single difference section and provides source file and line number
+ * information for the lines in this section.
+ *
+ * The lines of a section can also be edited. The edited content is a piece
+ * table on top of the lines the section would otherwise have, so an edit
+ * takes O(log n) regardless of the size of the section.
+ */
+class MergeResultSection
+{
+public:
+    MergeResultSection(bool isDifference,
+                       int firstInputLineA, int lastInputLineA,
+                       int firstInputLineB, int lastInputLineB,
+                       int firstInputLineC, int lastInputLineC,
+                       int firstDiff3Line, int lastDiff3Line);
+
+    LineNumberRange getLineNumberRange(LineSource lineSource) const;
+    LineNumberRange getDiff3LineNumberRange() const;
+    bool isDifference() const;
+    int getOutputSize() const;
+    void toggle(LineSource lineSource);
+    LineInfo getLineInfo(int relativeLineNumber) const;
+    bool isSolved() const;
+    bool isEdited() const;
+    const std::vector<LineSource>& getSelectedSources() const;
+
+    /**
+     * Applies a modification to the current (possibly already edited)
+     * content of the section. Toggling a source discards all edits.
+     */
+    void applyModification(const Modification& modification);
+
+    /**
+     * Returns an edited line, given the line number from a LineInfo with
+     * state EDITED. The text remains valid for as long as this section or a
+     * copy of it contains the line.
+     */
+    std::string_view getEditedLine(int relativeLineNumber) const;
+
+private:
+    int getUneditedOutputSize() const;
+    LineInfo getUneditedLineInfo(int relativeLineNumber) const;
+
+    friend class ContentMapper;
+
+    static const LineSource DEFAULT_LINE_SOURCE = LineSource::C;
+
+    LineNumberRange m_inputLineNumbers[3];
+    LineNumberRange m_diff3LineNumbers;
+
+    bool m_isDifference;
+    std::vector<LineSource> m_selectedSources;
+
+    /** Only set once the section has been edited. A copy of the section
+     *  shares it until either of them is edited. */
+    std::shared_ptr<const PieceTable> m_edits;
+};
+
+using MergeResultSections = std::vector<MergeResultSection>;
+
+/**
+ * Is told about every action that changes a merge result, after it has
+ * been done.
+ */
+class IActionListener
+{
+public:
+    virtual ~IActionListener() = default;
+
+    virtual void sectionToggled(size_t sectionIndex, LineSource lineSource) = 0;
+    virtual void modificationApplied(const Modification& modification) = 0;
+    virtual void actionUndone() = 0;
+    virtual void actionRedone() = 0;
+};
+
+/**
+ * The ContentMapper is responsible for keeping track of the source for each
+ * line in the merge result. One possible source is the list of edited lines
+ * that it also maintains. It must also be able to provide location and state
+ * information for all difference sections in the merge result.
+ */
+class ContentMapper
+{
+public:
+    /**
+     * Groups consecutive rows with the same equality into sections. Runs of
+     * rows in which all lines are equal are added to a section as a whole,
+     * so the number of rows visited only depends on the number of
+     * differences.
+     */
+    static MergeResultSections calculateMergeResultSections(const Diff3Table& diff3Table);
+
+    void determineMergeResultSections(const Diff3Table& diff3Table);
+
+    /**
+     * Takes sections that were determined before, e.g. by another content
+     * mapper for the same diff3 table.
+     */
+    void setMergeResultSections(MergeResultSections mergeResultSections);
+    /**
+     * Selects the lines of the file that differs from the other two in every
+     * difference where two of the files are the same. If lineEquivalences is
+     * specified, differences in which the rows show no equal lines are also
+     * resolved if two of the files have the same lines over the whole
+     * difference.
+     */
+    void automaticallyResolveDifferences(const Diff3Table& diff3Table,
+                                         const LineEquivalences *lineEquivalences = nullptr);
+
+    /**
+     * Returns where the text of a line of the merge result is stored, or a
+     * line info with state NONE if the merge result has no such line. Takes
+     * O(log n) in the number of sections.
+     */
+    LineInfo getMergeResultLineInfo(int lineInMergeResultPane) const;
+
+    size_t getNumberOfSections() const;
+    const MergeResultSection& getSection(size_t sectionIndex) const;
+    SectionInfo getSectionInfo(size_t sectionIndex) const;
+
+    /**
+     * The find functions return the index of the nearest matching section
+     * after or before the specified one, or -1 if there is none. They take
+     * O(log n) in the number of sections.
+     */
+    int findNextDifference(int sectionIndex) const;
+    int findNextUnsolvedDifference(int sectionIndex) const;
+    int findPreviousDifference(int sectionIndex) const;
+    int findPreviousUnsolvedDifference(int sectionIndex) const;
+    bool allDifferencesSolved() const;
+
+    void toggleSectionSource(size_t sectionIndex, LineSource lineSource);
+
+    /**
+     * Applies a modification to the merge result, in which firstLine is a
+     * line of the merge result pane. Finding the section takes O(log n) in
+     * the number of sections.
+     */
+    void applyModification(Modification modification);
+
+    /**
+     * Returns an edited line, given the section index and line number from a
+     * LineInfo with state EDITED.
+     */
+    std::string_view getEditedLine(size_t sectionIndex, int lineNumber) const;
+
+    /**
+     * Returns the number of lines in the merge result.
+     */
+    int getContentHeight() const;
+
+    /**
+     * Undoes the last action that has not been undone yet, i.e. a toggle or
+     * a modification. Returns false if there is none.
+     */
+    bool undo();
+
+    /**
+     * Redoes the last action that was undone. Returns false if there is
+     * none. Any other action discards the actions that can be redone.
+     */
+    bool redo();
+
+    /**
+     * Returns the number of actions that have been done and not undone.
+     */
+    size_t getHistoryPosition() const;
+    size_t getHistorySize() const;
+
+    /**
+     * Undoes or redoes actions until the specified number of them is done.
+     */
+    void goToHistoryPosition(size_t historyPosition);
+
+    /**
+     * Returns a copy of the merge result without the history. Nothing that
+     * the copy shares with this content mapper is ever changed, so another
+     * thread can read the copy while this one is changed. The sections and
+     * indices are shared in chunks, so this takes
+     * O(n / ChunkedVector::CHUNK_SIZE) in the number of sections and the
+     * first change to a chunk afterwards copies only that chunk.
+     */
+    ContentMapper createSnapshot() const;
+
+    /**
+     * Sets the listener that is told about all actions from now on, or
+     * none if nullptr.
+     */
+    void setActionListener(IActionListener *actionListener);
+
+private:
+    /**
+     * The part of a section that actions change. Saving it takes O(1),
+     * because the edits are shared with the state they were made in.
+     */
+    struct SectionState
+    {
+        size_t sectionIndex;
+        std::vector<LineSource> selectedSources;
+        std::shared_ptr<const PieceTable> edits;
+    };
+
+    /** The states of the sections that an action changed, from before the
+     *  action if it is done and from after it if it is undone */
+    using HistoryEntry = std::vector<SectionState>;
+
+    SectionState saveSectionState(size_t sectionIndex) const;
+    void addHistoryEntry(HistoryEntry entry);
+    void swapStates(HistoryEntry& entry);
+    void sectionChanged(size_t sectionIndex);
+
+    void indexSections();
+    static int findNext(const IndexSet& sections, int sectionIndex);
+    static int findPrevious(const IndexSet& sections, int sectionIndex);
+
+    ChunkedVector<MergeResultSection> m_mergeResultSections;
+
+    /** The output size of every section, so that lines of the merge result
+     *  can be found without visiting all sections before them */
+    FenwickTree m_outputSizes;
+
+    /** The sections that are differences and those that are unsolved ones */
+    IndexSet m_differences;
+    IndexSet m_unsolvedDifferences;
+
+    std::vector<HistoryEntry> m_history;
+    size_t m_historyPosition = 0;
+
+    IActionListener *m_actionListener = nullptr;
+};
@@ -0,0 +1,1660 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ * Copyright (C) 2014  Joachim Eibl <joachim.eibl at gmx.de>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * This module contains the alignment algorithm taken from KDiff3.
+ *
+ * Authors: Maurice van der Pot, Joachim Eibl
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+#include <deque>
+#include <list>
+
+#include "bytecompare.h"
+#include "common.h"
+#include "diff.h"
+#include "diff3table.h"
+#include "diffsource.h"
+#include "longlinediff.h"
+#include "worddiff.h"
+
+namespace
+{
+
+/**
+ * Produces the rows of the alignment of A and B, with the lines of C already
+ * added based on the diff between A and C, one row at a time.
+ *
+ * Per diff between A and B, the equal lines of A and B come side by side,
+ * then the differing lines of A and B side by side and then the remaining
+ * lines of either A or B. A line of C that is equal to a line of A is put in
+ * the row of that line. The other lines of C get rows of their own, directly
+ * after the row of the last line of C that is equal to a line of A or at the
+ * very beginning if there is no such line.
+ */
+class AlignedRowSource
+{
+public:
+    /**
+     * The diffs can be part of longer diff lists, in which case the first
+     * lines of the part in each of the files must be specified.
+     */
+    AlignedRowSource(IDiffSource& diffs12, IDiffSource& diffs13, const int (&firstLines)[3]):
+        m_diffs12(diffs12),
+        m_diffs13(diffs13),
+        m_lineA12(firstLines[0]),
+        m_lineB(firstLines[1]),
+        m_lineA13(firstLines[0]),
+        m_lineC(firstLines[2])
+    {
+        m_more12 = m_diffs12.next(m_diff12);
+        m_more13 = m_diffs13.next(m_diff13);
+    }
+
+    /**
+     * Stores the next row in d3l. Returns false if there are no more rows.
+     */
+    bool next(Diff3Line& d3l)
+    {
+        d3l = Diff3Line();
+
+        if(m_afterEqualC)
+        {
+            if(nextUnequalC(d3l))
+            {
+                return true;
+            }
+            m_afterEqualC = false;
+        }
+
+        if(!nextAB(d3l))
+        {
+            return false;
+        }
+
+        /* nextUnequalC stops at the next line of A that is equal to C */
+        if(d3l.lineA != -1 && m_more13 && d3l.lineA == m_lineA13)
+        {
+            d3l.lineC = m_lineC++;
+            d3l.bAEqC = true;
+            d3l.bBEqC = d3l.bAEqB;
+
+            m_lineA13++;
+            m_diff13.nofEquals--;
+            m_afterEqualC = true;
+        }
+        return true;
+    }
+
+private:
+    bool nextAB(Diff3Line& d3l)
+    {
+        while(m_more12)
+        {
+            Diff& d = m_diff12;
+            if(d.nofEquals > 0)
+            {
+                d3l.bAEqB = true;
+                d3l.lineA = m_lineA12++;
+                d3l.lineB = m_lineB++;
+                d.nofEquals--;
+                return true;
+            }
+            if(d.diff1 > 0 && d.diff2 > 0)
+            {
+                d3l.lineA = m_lineA12++;
+                d3l.lineB = m_lineB++;
+                d.diff1--;
+                d.diff2--;
+                return true;
+            }
+            if(d.diff1 > 0)
+            {
+                d3l.lineA = m_lineA12++;
+                d.diff1--;
+                return true;
+            }
+            if(d.diff2 > 0)
+            {
+                d3l.lineB = m_lineB++;
+                d.diff2--;
+                return true;
+            }
+
+            m_more12 = m_diffs12.next(m_diff12);
+        }
+        return false;
+    }
+
+    /**
+     * Skips the lines of A that are not equal to C and produces a row for the
+     * next line of C that is not equal to A. Returns false when the next line
+     * of C is equal to a line of A or if there are no more lines in C.
+     */
+    bool nextUnequalC(Diff3Line& d3l)
+    {
+        while(m_more13)
+        {
+            Diff& d = m_diff13;
+            if(d.nofEquals > 0)
+            {
+                return false;
+            }
+            if(d.diff1 > 0)
+            {
+                m_lineA13 += d.diff1;
+                d.diff1 = 0;
+            }
+            if(d.diff2 > 0)
+            {
+                d3l.lineC = m_lineC++;
+                d.diff2--;
+                return true;
+            }
+
+            m_more13 = m_diffs13.next(m_diff13);
+        }
+        return false;
+    }
+
+    IDiffSource& m_diffs12;
+    IDiffSource& m_diffs13;
+
+    bool m_more12;
+    Diff m_diff12 = Diff(0, 0, 0);
+    int m_lineA12;
+    int m_lineB;
+
+    bool m_more13;
+    Diff m_diff13 = Diff(0, 0, 0);
+    int m_lineA13;
+    int m_lineC;
+
+    /* Lines of C that are not equal to A follow the last line that is, so
+     * start out as if one was just produced. */
+    bool m_afterEqualC = true;
+};
+
+/**
+ * Completes the alignment produced by AlignedRowSource using the diff between
+ * B and C.
+ *
+ * Equal lines of B and C are put in the same row by moving the lower of the
+ * two up, and lines of B that differ from C are moved up as far as they can.
+ * Neither ever changes rows before the current positions in B and C, so the
+ * rows are taken from the source only when they are needed and are written
+ * to the result as soon as both positions have passed them. The result can
+ * be anything rows can be appended to with push_back.
+ */
+template<typename Result>
+class Diff3LineListBuilder
+{
+public:
+    using Row = std::list<Diff3Line>::iterator;
+
+    Diff3LineListBuilder(AlignedRowSource& source, Result& result):
+        m_source(source),
+        m_result(result)
+    {
+    }
+
+    void build(IDiffSource& diffs23, int firstLineB, int firstLineC)
+    {
+        int lineB = firstLineB;
+        int lineC = firstLineC;
+
+        pull();
+        Row r3b = m_window.begin();
+        Row r3c = m_window.begin();
+
+        Diff d(0, 0, 0);
+        while(diffs23.next(d))
+        {
+            while(d.nofEquals > 0)
+            {
+                while(r3b->lineB != lineB)
+                {
+                    r3b = next(r3b);
+                }
+                while(r3c->lineC != lineC)
+                {
+                    r3c = next(r3c);
+                }
+
+                assert(r3b != m_window.end());
+                assert(r3c != m_window.end());
+
+                if(r3b == r3c)
+                {
+                    assert(r3b->lineC == lineC);
+                    r3b->bBEqC = true;
+                }
+                else
+                {
+                    moveLowerLineUp(r3b, r3c);
+                }
+
+                d.nofEquals--;
+                lineB++;
+                lineC++;
+                r3b = next(r3b);
+                r3c = next(r3c);
+                flush(r3b, r3c);
+            }
+
+            Row r3from = r3b;
+            while(d.diff1 > 0)
+            {
+                /* Move lines in B that are not equal to A or C as far up as they
+                 * can, i.e. insert it between the previous line from B and the
+                 * lines from A and C that follow it
+                 */
+                while(r3from->lineB != lineB)
+                {
+                    assert(r3from->lineB == -1);
+                    r3from = next(r3from);
+                }
+                if(r3from != r3b && !r3from->bAEqB)
+                {
+                    Diff3Line d3l;
+                    d3l.lineB = lineB;
+                    m_window.insert(r3b, d3l);
+                    r3from->lineB = -1;
+                }
+                else
+                {
+                    r3from = next(r3from);
+                    r3b = r3from;
+                }
+                d.diff1--;
+                lineB++;
+            }
+            flush(r3b, r3c);
+
+            lineC += d.diff2;
+        }
+
+        while(pull())
+        {
+        }
+        flush(m_window.end(), m_window.end());
+    }
+
+private:
+    /**
+     * Appends the next row from the source to the window. Returns false if
+     * there are no more rows.
+     */
+    bool pull()
+    {
+        Diff3Line d3l;
+        if(!m_source.next(d3l))
+        {
+            return false;
+        }
+        m_window.push_back(std::move(d3l));
+        return true;
+    }
+
+    /**
+     * Returns the row after the specified one, taking it from the source if
+     * it is not in the window yet. Only returns the end of the window if
+     * there are no more rows at all.
+     */
+    Row next(Row row)
+    {
+        ++row;
+        if(row == m_window.end() && pull())
+        {
+            row = std::prev(m_window.end());
+        }
+        return row;
+    }
+
+    /**
+     * Moves the rows before both of the specified rows to the result.
+     */
+    void flush(Row r3b, Row r3c)
+    {
+        while(!m_window.empty() && m_window.begin() != r3b && m_window.begin() != r3c)
+        {
+            m_result.push_back(m_window.front());
+            m_window.pop_front();
+        }
+    }
+
+    void moveLowerLineUp(Row r3b, Row r3c)
+    {
+        // Is it possible to move this line up?
+        // Test if no other B's are used between r3c and r3b
+
+        // First test which is before: r3c or r3b ?
+        Row r3b1 = r3b;
+        Row r3c1 = r3c;
+        while(r3b1 != r3c && r3c1 != r3b)
+        {
+            assert(r3b1 != m_window.end() || r3c1 != m_window.end());
+            if(r3b1 != m_window.end()) r3b1 = next(r3b1);
+            if(r3c1 != m_window.end()) r3c1 = next(r3c1);
+        }
+
+        /* The code below works for B before C as well as C before B, but to avoid
+         * having to write more or less the same code twice it uses some locally
+         * defined functions to access things like bAEqB/bAEqC/lineB/lineC.
+         *
+         * The locally defined functions are named left* and right*. When reading
+         * the code just assume that the line on the left is above the line on the
+         * right. The functions take care of swapping everything when it's the
+         * other way around.
+         */
+
+        bool bFirst = (r3b1 == r3c);
+
+        auto leftEqualToA = [bFirst](Diff3Line& d3l) -> bool& { return bFirst ? d3l.bAEqB : d3l.bAEqC; };
+        auto rightEqualToA = [bFirst](Diff3Line& d3l) -> bool& { return bFirst ? d3l.bAEqC : d3l.bAEqB; };
+        auto leftEqualToRight = [](Diff3Line& d3l) -> bool& { return d3l.bBEqC; };
+        auto rightLine = [bFirst](Diff3Line& d3l) -> int& { return bFirst ? d3l.lineC : d3l.lineB; };
+
+        Row first = bFirst ? r3b : r3c;
+        Row last = bFirst ? r3c : r3b;
+
+        if(!rightEqualToA(*last)) // left before right
+        {
+            Row r3 = first;
+
+            Row r3LastEqualA = last;
+            int nofDisturbingLines = 0;
+
+            while(r3 != last)
+            {
+                assert(r3 != m_window.end());
+                if(rightLine(*r3) != -1)
+                {
+                    nofDisturbingLines++;
+
+                    if(rightEqualToA(*r3))
+                    {
+                        r3LastEqualA = r3;
+                    }
+                }
+                ++r3;
+            }
+
+            if(nofDisturbingLines > 0)
+            {
+                /* If r3LastEqualA isn't still set to last, then we've found a
+                 * line in A that is equal to one in C somewhere between r3b
+                 * and r3c
+                 */
+                bool beforeOrOnEqualLineInA = (r3LastEqualA != last);
+
+                r3 = first;
+                while(r3 != last)
+                {
+                    if( (rightLine(*r3) != -1) ||
+                        (beforeOrOnEqualLineInA && r3->lineA != -1) )
+                    {
+                        Diff3Line d3l;
+                        rightLine(d3l) = rightLine(*r3);
+                        rightLine(*r3) = -1;
+
+                        if(beforeOrOnEqualLineInA)
+                        {
+                            d3l.lineA = r3->lineA;
+                            rightEqualToA(d3l) = rightEqualToA(*r3);
+                            r3->lineA = -1;
+                            leftEqualToA(*r3) = false;
+                        }
+
+                        rightEqualToA(*r3) = false;
+                        leftEqualToRight(*r3) = false;
+                        m_window.insert(first, d3l);
+                    }
+
+                    if(r3 == r3LastEqualA)
+                    {
+                        beforeOrOnEqualLineInA = false;
+                    }
+
+                    ++r3;
+                }
+                nofDisturbingLines = 0;
+            }
+
+            assert(nofDisturbingLines == 0);
+            rightLine(*first) = rightLine(*last);
+            leftEqualToRight(*first) = true;
+            rightEqualToA(*first) = leftEqualToA(*first);
+            rightLine(*last) = -1;
+            rightEqualToA(*last) = false;
+            leftEqualToRight(*last) = false;
+        }
+    }
+
+    AlignedRowSource& m_source;
+    Result& m_result;
+
+    /** The rows that have been taken from the source but are not final yet */
+    std::list<Diff3Line> m_window;
+};
+
+/**
+ * Moves lines up into earlier rows as described for trimDiff3LineList. The
+ * rows are passed in one at a time, so trimming can follow the alignment
+ * without the untrimmed table being stored.
+ */
+class Diff3LineListTrimmer
+{
+public:
+    Diff3LineListTrimmer(const LineEquivalences& lineEquivalences):
+        m_lineEquivalences(lineEquivalences)
+    {
+    }
+
+    /**
+     * Adds the next row of the alignment.
+     */
+    void push_back(const Diff3Line& d3l)
+    {
+        m_window.push_back(d3l);
+        auto& r3 = row(m_line);
+
+        if( m_line > m_lineA && r3.lineA != -1 && row(m_lineA).lineB != -1 && row(m_lineA).bBEqC &&
+            equal(0, r3.lineA, 1, row(m_lineA).lineB) )
+        {
+            auto& r3a = row(m_lineA);
+            r3a.lineA = r3.lineA;
+            r3a.bAEqB = true;
+            r3a.bAEqC = true;
+
+            r3.lineA = -1;
+            r3.bAEqB = false;
+            r3.bAEqC = false;
+
+            m_lineA++;
+        }
+
+        if( m_line > m_lineB && r3.lineB != -1 && row(m_lineB).lineA != -1 && row(m_lineB).bAEqC &&
+            equal(1, r3.lineB, 0, row(m_lineB).lineA) )
+        {
+            auto& r3b = row(m_lineB);
+            r3b.lineB = r3.lineB;
+            r3b.bAEqB = true;
+            r3b.bBEqC = true;
+
+            r3.lineB = -1;
+            r3.bAEqB = false;
+            r3.bBEqC = false;
+
+            m_lineB++;
+        }
+
+        if( m_line > m_lineC && r3.lineC != -1 && row(m_lineC).lineA != -1 && row(m_lineC).bAEqB &&
+            equal(2, r3.lineC, 0, row(m_lineC).lineA) )
+        {
+            auto& r3c = row(m_lineC);
+            r3c.lineC = r3.lineC;
+            r3c.bAEqC = true;
+            r3c.bBEqC = true;
+
+            r3.lineC = -1;
+            r3.bAEqC = false;
+            r3.bBEqC = false;
+
+            m_lineC++;
+        }
+
+        if( m_line > m_lineA && r3.lineA != -1 && !r3.bAEqB && !r3.bAEqC )
+        {
+            auto& r3a = row(m_lineA);
+            r3a.lineA = r3.lineA;
+            r3.lineA = -1;
+
+            if(r3a.lineB != -1 && equal(0, r3a.lineA, 1, r3a.lineB))
+            {
+                r3a.bAEqB = true;
+            }
+            if((r3a.bAEqB && r3a.bBEqC) ||
+               (r3a.lineC != -1 && equal(0, r3a.lineA, 2, r3a.lineC)))
+            {
+                r3a.bAEqC = true;
+            }
+
+            m_lineA++;
+        }
+
+        if( m_line > m_lineB && r3.lineB != -1 && !r3.bAEqB && !r3.bBEqC )
+        {
+            auto& r3b = row(m_lineB);
+            r3b.lineB = r3.lineB;
+            r3.lineB = -1;
+
+            if(r3b.lineA != -1 && equal(0, r3b.lineA, 1, r3b.lineB))
+            {
+                r3b.bAEqB = true;
+            }
+            if((r3b.bAEqB && r3b.bAEqC) ||
+               (r3b.lineC != -1 && equal(1, r3b.lineB, 2, r3b.lineC)))
+            {
+                r3b.bBEqC = true;
+            }
+
+            m_lineB++;
+        }
+
+        if( m_line > m_lineC && r3.lineC != -1 && !r3.bAEqC && !r3.bBEqC )
+        {
+            auto& r3c = row(m_lineC);
+            r3c.lineC = r3.lineC;
+            r3.lineC = -1;
+
+            if(r3c.lineA != -1 && equal(0, r3c.lineA, 2, r3c.lineC))
+            {
+                r3c.bAEqC = true;
+            }
+            if((r3c.bAEqC && r3c.bAEqB) ||
+               (r3c.lineB != -1 && equal(1, r3c.lineB, 2, r3c.lineC)))
+            {
+                r3c.bBEqC = true;
+            }
+
+            m_lineC++;
+        }
+
+        if( m_line > m_lineA && m_line > m_lineB && r3.lineA != -1 &&
+            r3.bAEqB && !r3.bAEqC )
+        {
+            /* if A and B are equal and not equal to C, then move them up to the first position where both A and B are -1 */
+
+            size_t l = std::max(m_lineA, m_lineB);
+            auto& r = row(l);
+
+            r.lineA = r3.lineA;
+            r.lineB = r3.lineB;
+            r.bAEqB = true;
+
+            if(r.lineC != -1 && equal(0, r.lineA, 2, r.lineC))
+            {
+                r.bAEqC = true;
+                r.bBEqC = true;
+            }
+
+            r3.lineA = -1;
+            r3.lineB = -1;
+            r3.bAEqB = false;
+
+            m_lineA = l + 1;
+            m_lineB = l + 1;
+        }
+        else if( m_line > m_lineA && m_line > m_lineC && r3.lineA != -1 &&
+                 r3.bAEqC && !r3.bAEqB )
+        {
+            /* if A and C are equal and not equal to B, then move them up to the first position where both A and C are -1 */
+
+            size_t l = std::max(m_lineA, m_lineC);
+            auto& r = row(l);
+
+            r.lineA = r3.lineA;
+            r.lineC = r3.lineC;
+            r.bAEqC = true;
+
+            if(r.lineB != -1 && equal(0, r.lineA, 1, r.lineB))
+            {
+                r.bAEqB = true;
+                r.bBEqC = true;
+            }
+
+            r3.lineA = -1;
+            r3.lineC = -1;
+            r3.bAEqC = false;
+
+            m_lineA = l + 1;
+            m_lineC = l + 1;
+        }
+        else if( m_line > m_lineB && m_line > m_lineC && r3.lineB != -1 &&
+                 r3.bBEqC && !r3.bAEqC )
+        {
+            /* if B and C are equal and not equal to A, then move them up to the first position where both B and C are -1 */
+
+            size_t l = std::max(m_lineB, m_lineC);
+            auto& r = row(l);
+
+            r.lineB = r3.lineB;
+            r.lineC = r3.lineC;
+            r.bBEqC = true;
+
+            if(r.lineA != -1 && equal(0, r.lineA, 1, r.lineB))
+            {
+                r.bAEqB = true;
+                r.bAEqC = true;
+            }
+
+            r3.lineB = -1;
+            r3.lineC = -1;
+            r3.bBEqC = false;
+
+            m_lineB = l + 1;
+            m_lineC = l + 1;
+        }
+
+        if(r3.lineA != -1)
+        {
+            m_lineA = m_line + 1;
+        }
+        if(r3.lineB != -1)
+        {
+            m_lineB = m_line + 1;
+        }
+        if(r3.lineC != -1)
+        {
+            m_lineC = m_line + 1;
+        }
+
+        m_line++;
+
+        /* Rows that have become empty are left out */
+        size_t firstModifiableRow = std::min({ m_lineA, m_lineB, m_lineC });
+        while(m_windowStart < firstModifiableRow)
+        {
+            auto& front = m_window.front();
+            if(front.lineA != -1 || front.lineB != -1 || front.lineC != -1)
+            {
+                m_trimmed.push_back(front);
+            }
+            m_window.pop_front();
+            m_windowStart++;
+        }
+    }
+
+    /**
+     * Returns the trimmed table and sets isClosed if none of the lines that
+     * follow the rows passed in so far could be moved up into them. Tables
+     * of consecutive parts of an alignment give the same result when trimmed
+     * one by one as when trimmed as a whole if all but the last of them are
+     * closed.
+     */
+    Diff3Table finish(bool& isClosed)
+    {
+        isClosed = m_window.empty();
+        for(auto& d3l: m_window)
+        {
+            if(d3l.lineA != -1 || d3l.lineB != -1 || d3l.lineC != -1)
+            {
+                m_trimmed.push_back(d3l);
+            }
+        }
+        m_window.clear();
+
+        return std::move(m_trimmed);
+    }
+
+private:
+    bool equal(int file1, int line1, int file2, int line2) const
+    {
+        return m_lineEquivalences.equal(file1, line1, file2, line2);
+    }
+
+    Diff3Line& row(size_t index)
+    {
+        assert(index >= m_windowStart && index - m_windowStart < m_window.size());
+        return m_window[index - m_windowStart];
+    }
+
+    const LineEquivalences& m_lineEquivalences;
+
+    Diff3Table m_trimmed;
+
+    /* Lines are only moved up to rows at or after m_lineA, m_lineB and
+     * m_lineC, so the rows before those can be written to the result. The
+     * others are kept in a window that starts at row m_windowStart. */
+    std::deque<Diff3Line> m_window;
+    size_t m_windowStart = 0;
+
+    size_t m_line = 0;
+    size_t m_lineA = 0;
+    size_t m_lineB = 0;
+    size_t m_lineC = 0;
+};
+
+}
+
+/**
+ * Aligns the lines of the three files for diff lists that can be part of
+ * longer ones, starting at the specified line of each file.
+ */
+static Diff3Table buildDiff3Table(const DiffList& diffList12,
+                                  const DiffList& diffList13,
+                                  const DiffList& diffList23,
+                                  const int (&firstLines)[3])
+{
+    /* Runs of rows in which all lines are equal take no room in the table.
+     * The other rows are those of the differences between A and B, the lines
+     * of A that differ from C and the lines of C that have a row of their
+     * own. Moving lines up rarely adds rows, so this is usually all memory
+     * that is needed. */
+    size_t nrOfRows = 0;
+    for(auto& d: diffList12)
+    {
+        nrOfRows += std::max(d.diff1, d.diff2);
+    }
+    for(auto& d: diffList13)
+    {
+        nrOfRows += d.diff1 + d.diff2;
+    }
+
+    Diff3Table diff3Table;
+    diff3Table.reserve(nrOfRows);
+
+    DiffListSource diffs12(diffList12);
+    DiffListSource diffs13(diffList13);
+    DiffListSource diffs23(diffList23);
+    AlignedRowSource source(diffs12, diffs13, firstLines);
+    Diff3LineListBuilder<Diff3Table> builder(source, diff3Table);
+    builder.build(diffs23, firstLines[1], firstLines[2]);
+
+    return diff3Table;
+}
+
+Diff3Table calcDiff3LineList(const DiffList& diffList12,
+                             const DiffList& diffList13,
+                             const DiffList& diffList23)
+{
+    return buildDiff3Table(diffList12, diffList13, diffList23, { 0, 0, 0 });
+}
+
+void validateDiff3LineListForN(Diff3Table& diff3Table, int n, int leftLine, int rightLine)
+{
+    int line = leftLine;
+    for(auto d3l: diff3Table)
+    {
+        if(d3l.line(n) == -1)
+            continue;
+
+        assert(line == d3l.line(n));
+        line++;
+    }
+    assert(line == rightLine + 1);
+}
+
+static Diff3Line toDiff3Line(const Diff3Table::Row& row)
+{
+    Diff3Line d3l;
+    d3l.lineA = row.line(0);
+    d3l.lineB = row.line(1);
+    d3l.lineC = row.line(2);
+    d3l.bAEqB = row.equal(DiffSelection::A_vs_B);
+    d3l.bAEqC = row.equal(DiffSelection::A_vs_C);
+    d3l.bBEqC = row.equal(DiffSelection::B_vs_C);
+    return d3l;
+}
+
+static Diff3Table trimDiff3LineList(Diff3Table& diff3Table, const LineEquivalences& lineEquivalences,
+                                    bool& isClosed)
+{
+    Diff3LineListTrimmer trimmer(lineEquivalences);
+    for(auto row: diff3Table)
+    {
+        trimmer.push_back(toDiff3Line(row));
+    }
+    return trimmer.finish(isClosed);
+}
+
+Diff3Table trimDiff3LineList(Diff3Table& diff3Table, const LineEquivalences& lineEquivalences)
+{
+    bool isClosed;
+    return trimDiff3LineList(diff3Table, lineEquivalences, isClosed);
+}
+
+namespace
+{
+
+/**
+ * A stretch of lines that are equal in two or three files.
+ */
+struct EqualRun
+{
+    int firstLines[3];
+    int count;
+};
+
+/**
+ * Returns the stretches of equal lines of a diff list, with the lines of its
+ * two files in the first two elements of firstLines.
+ */
+std::vector<EqualRun> equalRuns(const DiffList& diffList)
+{
+    std::vector<EqualRun> runs;
+    int line1 = 0;
+    int line2 = 0;
+    for(auto& d: diffList)
+    {
+        if(d.nofEquals > 0)
+        {
+            runs.push_back(EqualRun{{ line1, line2, -1 }, d.nofEquals});
+        }
+        line1 += d.nofEquals + d.diff1;
+        line2 += d.nofEquals + d.diff2;
+    }
+    return runs;
+}
+
+/**
+ * Returns the rows in which all three lines are equal according to all three
+ * diff lists. These are sync points of the alignment: no line is ever moved
+ * past them, neither while aligning nor while trimming, so the parts of the
+ * diff lists between them can be aligned independently.
+ */
+std::vector<EqualRun> findSyncRuns(const DiffList& diffList12,
+                                   const DiffList& diffList13,
+                                   const DiffList& diffList23)
+{
+    auto runs12 = equalRuns(diffList12);
+    auto runs13 = equalRuns(diffList13);
+    auto runs23 = equalRuns(diffList23);
+
+    /* Lines of A that are equal to both B and C */
+    std::vector<EqualRun> runsABC;
+    for(size_t i = 0, j = 0; i < runs12.size() && j < runs13.size();)
+    {
+        auto& r12 = runs12[i];
+        auto& r13 = runs13[j];
+        int first = std::max(r12.firstLines[0], r13.firstLines[0]);
+        int end = std::min(r12.firstLines[0] + r12.count, r13.firstLines[0] + r13.count);
+        if(first < end)
+        {
+            runsABC.push_back(EqualRun{{ first,
+                                         r12.firstLines[1] + (first - r12.firstLines[0]),
+                                         r13.firstLines[1] + (first - r13.firstLines[0]) },
+                                       end - first});
+        }
+        (r12.firstLines[0] + r12.count < r13.firstLines[0] + r13.count) ? i++ : j++;
+    }
+
+    /* Of those, the ones where the diff between B and C agrees */
+    std::vector<EqualRun> syncRuns;
+    for(size_t i = 0, j = 0; i < runsABC.size() && j < runs23.size();)
+    {
+        auto& rABC = runsABC[i];
+        auto& r23 = runs23[j];
+        int first = std::max(rABC.firstLines[1], r23.firstLines[0]);
+        int end = std::min(rABC.firstLines[1] + rABC.count, r23.firstLines[0] + r23.count);
+        if(first < end && rABC.firstLines[2] - rABC.firstLines[1] == r23.firstLines[1] - r23.firstLines[0])
+        {
+            int offset = first - rABC.firstLines[1];
+            syncRuns.push_back(EqualRun{{ rABC.firstLines[0] + offset, first, rABC.firstLines[2] + offset },
+                                        end - first});
+        }
+        (rABC.firstLines[1] + rABC.count < r23.firstLines[0] + r23.count) ? i++ : j++;
+    }
+
+    return syncRuns;
+}
+
+/**
+ * Splits a diff list in front of the specified lines of its first file,
+ * which must all be in stretches of equal lines or directly after one.
+ */
+std::vector<DiffList> splitDiffList(const DiffList& diffList, const std::vector<int>& cuts)
+{
+    std::vector<DiffList> parts(1);
+    size_t cut = 0;
+    int line1 = 0;
+    for(auto d: diffList)
+    {
+        while(cut < cuts.size() && cuts[cut] <= line1 + d.nofEquals)
+        {
+            int before = cuts[cut] - line1;
+            assert(before >= 0);
+            if(before > 0)
+            {
+                parts.back().push_back(Diff(before, 0, 0));
+            }
+            d.nofEquals -= before;
+            line1 += before;
+            parts.emplace_back();
+            cut++;
+        }
+        if(d.nofEquals > 0 || d.diff1 > 0 || d.diff2 > 0)
+        {
+            parts.back().push_back(d);
+        }
+        line1 += d.nofEquals + d.diff1;
+    }
+    assert(cut == cuts.size());
+    return parts;
+}
+
+/**
+ * Builds a trimmed table from the diff lists of consecutive stretches of the
+ * files. Each stretch must start at the first lines of the files or directly
+ * after a row in which all lines are equal according to all three diff
+ * lists. The stretches are split into parts in the same way, which are
+ * aligned and trimmed on the worker pool.
+ */
+class PartitionedTableBuilder
+{
+public:
+    PartitionedTableBuilder(const LineEquivalences& lineEquivalences, WorkerPool& workerPool):
+        m_lineEquivalences(lineEquivalences),
+        m_workerPool(workerPool)
+    {
+    }
+
+    void add(const DiffList& diffList12,
+             const DiffList& diffList13,
+             const DiffList& diffList23,
+             const std::array<int, 3>& firstLines)
+    {
+        /* Split after the last row of a sync run, so that the runs of equal
+         * rows before it usually keep trimming from moving lines out of the
+         * part. The parts are chosen to have about the same number of
+         * lines. */
+        auto syncRuns = findSyncRuns(diffList12, diffList13, diffList23);
+        int nrOfLines = 0;
+        for(auto& d: diffList12)
+        {
+            nrOfLines += d.nofEquals + d.diff1;
+        }
+        long long nrOfParts = m_workerPool.concurrency() * 4;
+
+        std::vector<std::array<int, 3>> partStarts = { { 0, 0, 0 } };
+        for(auto& run: syncRuns)
+        {
+            int next = run.firstLines[0] + run.count;
+            if(next < nrOfLines && next >= nrOfLines * static_cast<long long>(partStarts.size()) / nrOfParts)
+            {
+                partStarts.push_back({ next, run.firstLines[1] + run.count, run.firstLines[2] + run.count });
+            }
+        }
+
+        std::vector<int> cutsA;
+        std::vector<int> cutsB;
+        for(size_t part = 1; part < partStarts.size(); part++)
+        {
+            cutsA.push_back(partStarts[part][0]);
+            cutsB.push_back(partStarts[part][1]);
+        }
+        auto parts12 = splitDiffList(diffList12, cutsA);
+        auto parts13 = splitDiffList(diffList13, cutsA);
+        auto parts23 = splitDiffList(diffList23, cutsB);
+
+        std::vector<Diff3Table> aligned(partStarts.size());
+        std::vector<Diff3Table> trimmed(partStarts.size());
+        std::vector<char> isClosed(partStarts.size());
+        m_workerPool.run(partStarts.size(), [&](size_t part, unsigned)
+        {
+            int partFirstLines[3] = { firstLines[0] + partStarts[part][0],
+                                      firstLines[1] + partStarts[part][1],
+                                      firstLines[2] + partStarts[part][2] };
+            aligned[part] = buildDiff3Table(parts12[part], parts13[part], parts23[part], partFirstLines);
+            bool closed;
+            trimmed[part] = trimDiff3LineList(aligned[part], m_lineEquivalences, closed);
+            isClosed[part] = closed;
+        });
+
+        for(size_t part = 0; part < partStarts.size(); part++)
+        {
+            if(m_open.size() == 0)
+            {
+                if(isClosed[part])
+                {
+                    m_result.append(trimmed[part]);
+                }
+                else
+                {
+                    m_open.append(aligned[part]);
+                }
+                continue;
+            }
+
+            /* Trimming could move lines of this part into the open ones, so
+             * they are trimmed together until a closed part is reached */
+            m_open.append(aligned[part]);
+            bool closed;
+            auto combined = trimDiff3LineList(m_open, m_lineEquivalences, closed);
+            if(closed)
+            {
+                m_result.append(combined);
+                m_open = Diff3Table();
+            }
+        }
+    }
+
+    Diff3Table finish()
+    {
+        if(m_open.size() != 0)
+        {
+            bool closed;
+            m_result.append(trimDiff3LineList(m_open, m_lineEquivalences, closed));
+            m_open = Diff3Table();
+        }
+        return std::move(m_result);
+    }
+
+private:
+    const LineEquivalences& m_lineEquivalences;
+    WorkerPool& m_workerPool;
+    Diff3Table m_result;
+
+    /** The aligned rows of the last parts, which lines of the next part can
+     *  still be moved into */
+    Diff3Table m_open;
+};
+
+/**
+ * The diffs of a source that have been read but not added to the table yet.
+ */
+struct PendingDiffs
+{
+    explicit PendingDiffs(IDiffSource& source):
+        source(source)
+    {
+    }
+
+    /**
+     * Reads diffs until they cover the lines of the first file up to
+     * endLine or until there are no more.
+     */
+    void readUntil(int endLine)
+    {
+        Diff d(0, 0, 0);
+        while(!done && end1 < endLine)
+        {
+            if(!source.next(d))
+            {
+                done = true;
+                break;
+            }
+            diffList.push_back(d);
+            end1 += d.nofEquals + d.diff1;
+            end2 += d.nofEquals + d.diff2;
+        }
+    }
+
+    IDiffSource& source;
+    DiffList diffList;
+
+    /** The lines of both files after the last diff that was read */
+    int end1 = 0;
+    int end2 = 0;
+    bool done = false;
+};
+
+}
+
+Diff3Table calcTrimmedDiff3LineList(const DiffList& diffList12,
+                                    const DiffList& diffList13,
+                                    const DiffList& diffList23,
+                                    const LineEquivalences& lineEquivalences,
+                                    WorkerPool& workerPool)
+{
+    PartitionedTableBuilder builder(lineEquivalences, workerPool);
+    builder.add(diffList12, diffList13, diffList23, { 0, 0, 0 });
+    return builder.finish();
+}
+
+Diff3Table calcTrimmedDiff3LineList(IDiffSource& diffs12,
+                                    IDiffSource& diffs13,
+                                    IDiffSource& diffs23,
+                                    const LineEquivalences& lineEquivalences,
+                                    WorkerPool& workerPool,
+                                    int minStretchLines)
+{
+    PartitionedTableBuilder builder(lineEquivalences, workerPool);
+    PendingDiffs pending12(diffs12);
+    PendingDiffs pending13(diffs13);
+    PendingDiffs pending23(diffs23);
+    std::array<int, 3> firstLines = { 0, 0, 0 };
+    int stretchLines = minStretchLines;
+
+    while(true)
+    {
+        /* The diffs between B and C are read up to where those between A
+         * and B are, so that all three cover about the same lines */
+        int endA = (stretchLines > INT_MAX - firstLines[0]) ? INT_MAX : firstLines[0] + stretchLines;
+        pending12.readUntil(endA);
+        pending13.readUntil(endA);
+        pending23.readUntil(pending12.done ? INT_MAX : pending12.end2);
+
+        if(pending12.done && pending13.done && pending23.done)
+        {
+            builder.add(pending12.diffList, pending13.diffList, pending23.diffList, firstLines);
+            return builder.finish();
+        }
+
+        /* The stretch ends after the last sync run in the diffs that were
+         * read. Those diffs can end anywhere, but every row of a sync run
+         * that is found in them is known to have equal lines. */
+        auto syncRuns = findSyncRuns(pending12.diffList, pending13.diffList, pending23.diffList);
+        if(syncRuns.empty())
+        {
+            stretchLines = (stretchLines > INT_MAX / 2) ? INT_MAX : stretchLines * 2;
+            continue;
+        }
+        auto& last = syncRuns.back();
+        int cuts[3] = { last.firstLines[0] + last.count, last.firstLines[1] + last.count, last.firstLines[2] + last.count };
+
+        auto parts12 = splitDiffList(pending12.diffList, { cuts[0] });
+        auto parts13 = splitDiffList(pending13.diffList, { cuts[0] });
+        auto parts23 = splitDiffList(pending23.diffList, { cuts[1] });
+        builder.add(parts12[0], parts13[0], parts23[0], firstLines);
+
+        pending12.diffList = std::move(parts12[1]);
+        pending13.diffList = std::move(parts13[1]);
+        pending23.diffList = std::move(parts23[1]);
+        for(int i = 0; i < 3; i++)
+        {
+            firstLines[i] += cuts[i];
+        }
+        stretchLines = minStretchLines;
+    }
+}
+
+static void verifyDiffList(const DiffList& diffList, int size1, int size2)
+{
+    int l1 = 0;
+    int l2 = 0;
+
+    for(auto& entry: diffList)
+    {
+        l1 += entry.nofEquals + entry.diff1;
+        l2 += entry.nofEquals + entry.diff2;
+    }
+
+    assert(l1 == size1);
+    assert(l2 == size2);
+}
+
+DiffList calcDiff(std::string_view line1, std::string_view line2, int match, int maxSearchRange)
+{
+    DiffList diffList;
+    calcDiff(line1, line2, match, maxSearchRange, diffList);
+    return diffList;
+}
+
+void calcDiff(std::string_view line1, std::string_view line2, int match, int maxSearchRange, DiffList& diffList)
+{
+    diffList.clear();
+
+    /* TODO: this algorithm must be done char by char, but the count in the
+     * Diff's returned should be in bytes so it can be used for splicing the
+     * string */
+
+    /* The parts of the lines that have not been matched yet */
+    auto r1 = line1;
+    auto r2 = line2;
+
+    for(;;)
+    {
+        int nofEquals = static_cast<int>(commonPrefixLength(r1, r2));
+        r1.remove_prefix(nofEquals);
+        r2.remove_prefix(nofEquals);
+
+        bool bestValid = false;
+        int bestI1 = 0;
+        int bestI2 = 0;
+        int r1Length = static_cast<int>(r1.size());
+        int r2Length = static_cast<int>(r2.size());
+
+        // Look for a character that occurs in both r1 and r2 and that is closest to the current position
+        for(int i1 = 0; ; i1++)
+        {
+            // Stop looking ahead in r1 if we've already found a match that is closer to the current position
+            if(i1 == r1Length || (bestValid && (i1 >= bestI1 + bestI2)))
+            {
+                break;
+            }
+            // Only look as far ahead in r2 as could still give a match that is
+            // closer to the current position
+            int i2Limit = std::min(maxSearchRange, r2Length);
+            if(bestValid)
+            {
+                i2Limit = std::min(i2Limit, bestI1 + bestI2 - i1);
+            }
+
+            // Find the candidates with memchr, which compares a vector of
+            // characters at a time
+            auto searchRange = r2.substr(0, i2Limit);
+            for(auto i2 = searchRange.find(r1[i1]); i2 != std::string_view::npos; i2 = searchRange.find(r1[i1], i2 + 1))
+            {
+                // If we've found a matching character and one of the following holds..
+                // - it is about as far from the previous set of matching chars in r1 as in r2
+                // - it is the last char in both r1 and r2
+                // - the next char in r1 and r2 also matches
+                int j2 = static_cast<int>(i2);
+                if( match == 1 ||
+                    std::abs(i1 - j2) < 3 ||
+                    (i1 + 1 == r1Length && j2 + 1 == r2Length) ||
+                    (i1 + 1 != r1Length && j2 + 1 != r2Length && r1[i1 + 1] == r2[j2 + 1]) )
+                {
+                    bestI1 = i1;
+                    bestI2 = j2;
+                    bestValid = true;
+                    break;
+                }
+            }
+        }
+
+        bool endReached = false;
+        if(bestValid)
+        {
+            // continue somehow
+            diffList.push_back(Diff(nofEquals, bestI1, bestI2));
+
+            r1.remove_prefix(bestI1);
+            r2.remove_prefix(bestI2);
+        }
+        else
+        {
+            // Nothing else to match.
+            diffList.push_back(Diff(nofEquals, r1Length, r2Length));
+
+            endReached = true;
+        }
+
+        // Sometimes the algorithm that chooses the first match unfortunately chooses
+        // a match where later actually equal parts don't match anymore.
+        // A different match could be achieved, if we start at the end.
+        // Do it, if it would be a better match.
+        auto ru1 = line1.substr(0, line1.size() - r1.size());
+        auto ru2 = line2.substr(0, line2.size() - r2.size());
+        int nofUnmatched = static_cast<int>(commonSuffixLength(ru1, ru2));
+        ru1.remove_suffix(nofUnmatched);
+        ru2.remove_suffix(nofUnmatched);
+
+        if(nofUnmatched > 0)
+        {
+            // We want to go backwards the nofUnmatched elements and redo
+            // the matching
+            Diff d = diffList.back();
+            Diff origBack = d;
+            diffList.pop_back();
+
+            while(nofUnmatched > 0)
+            {
+                if(d.diff1 > 0 && d.diff2 > 0)
+                {
+                    d.diff1--;
+                    d.diff2--;
+                    nofUnmatched--;
+                }
+                else if(d.nofEquals > 0)
+                {
+                    d.nofEquals--;
+                    nofUnmatched--;
+                }
+
+                if(d.nofEquals == 0 && (d.diff1 == 0 || d.diff2 == 0) && nofUnmatched > 0)
+                {
+                    if(diffList.empty())
+                    {
+                        break;
+                    }
+                    d.nofEquals += diffList.back().nofEquals;
+                    d.diff1 += diffList.back().diff1;
+                    d.diff2 += diffList.back().diff2;
+                    diffList.pop_back();
+                    endReached = false;
+                }
+            }
+
+            if(endReached)
+            {
+                diffList.push_back(origBack);
+            }
+            else
+            {
+                assert(nofUnmatched == 0);
+                r1 = line1.substr(ru1.size() + nofUnmatched);
+                r2 = line2.substr(ru2.size() + nofUnmatched);
+                diffList.push_back(d);
+            }
+        }
+
+        if(endReached)
+        {
+            break;
+        }
+    }
+
+    verifyDiffList(diffList, static_cast<int>(line1.size()), static_cast<int>(line2.size()));
+}
+
+DiffList fineDiff(int k1, int k2, std::string_view line1, std::string_view line2, FineDiffGranularity granularity)
+{
+    DiffList diffList;
+    fineDiff(k1, k2, line1, line2, diffList, granularity);
+    return diffList;
+}
+
+void fineDiff(int k1, int k2, std::string_view line1, std::string_view line2, DiffList& diffList,
+              FineDiffGranularity granularity)
+{
+    const int maxSearchLength = 500;
+
+    diffList.clear();
+    int line1Length = (k1 == -1) ? 0 : static_cast<int>(line1.size());
+    int line2Length = (k2 == -1) ? 0 : static_cast<int>(line2.size());
+    if(k1 == -1 || k2 == -1)
+    {
+        diffList.push_back(Diff(0, line1Length, line2Length));
+    }
+    else if(line1 == line2)
+    {
+        diffList.push_back(Diff(line1Length, 0, 0));
+    }
+    else
+    {
+        if(granularity == FineDiffGranularity::WORD)
+        {
+            diffList = calcWordDiff(line1, line2);
+        }
+        else if(std::max(line1.size(), line2.size()) >= LONG_LINE_THRESHOLD)
+        {
+            diffList = calcLongLineDiff(line1, line2);
+        }
+        else
+        {
+            calcDiff(line1, line2, 2, maxSearchLength, diffList);
+        }
+
+        // Optimize the diff list
+        bool fineDiffUseless = std::none_of(diffList.begin(), diffList.end(),
+                                            [](const Diff& d) { return d.nofEquals >= 4; });
+
+        bool first = true;
+        for(auto& dli: diffList)
+        {
+            if(dli.nofEquals < 4 &&
+               (dli.diff1 > 0 || dli.diff2 > 0) &&
+               (fineDiffUseless || !first))
+            {
+                dli.diff1 += dli.nofEquals;
+                dli.diff2 += dli.nofEquals;
+                dli.nofEquals = 0;
+            }
+            first = false;
+        }
+    }
+}
+
+DiffListIterator::DiffListIterator(const DiffList& diffList, int whichFile):
+    m_diffList(diffList),
+    m_whichFile(whichFile)
+{
+}
+
+int& DiffListIterator::diffField(Diff& d)
+{
+    switch(m_whichFile)
+    {
+    case 0:
+        return d.diff1;
+    case 1:
+        return d.diff2;
+    default:
+        assert(false);
+        return d.diff1;
+    }
+}
+
+void DiffListIterator::updateHead()
+{
+    while(m_head.nofEquals == 0 && diffField(m_head) == 0 && m_next < m_diffList.size())
+    {
+        m_head = m_diffList[m_next++];
+    }
+}
+
+bool DiffListIterator::atEnd()
+{
+    updateHead();
+    return m_head.nofEquals == 0 && diffField(m_head) == 0;
+}
+
+std::pair<bool, int> DiffListIterator::getNextRun()
+{
+    updateHead();
+    if(m_head.nofEquals > 0)
+    {
+        return { true, m_head.nofEquals };
+    }
+    else
+    {
+        return { false, diffField(m_head) };
+    }
+}
+
+void DiffListIterator::advance(int n)
+{
+    while(n > 0)
+    {
+        updateHead();
+
+        auto step = std::min(n, m_head.nofEquals);
+        n -= step;
+        m_head.nofEquals -= step;
+
+        if(n > 0)
+        {
+            step = std::min(n, diffField(m_head));
+            n -= step;
+            diffField(m_head) -= step;
+        }
+    }
+}
+
+StyleList lineStyleFromFineDiffs(DiffListIterator& it1,
+                                 DiffListIterator& it2,
+                                 DiffStyle sameInIt1,
+                                 DiffStyle sameInIt2)
+{
+    StyleList styleList;
+
+    DiffStyle style = DiffStyle::ALL_SAME;
+    int run = 0;
+
+    while(true)
+    {
+        auto [equal1, length1] = it1.getNextRun();
+        auto [equal2, length2] = it2.getNextRun();
+
+        // check if either of the iterators is at its end
+        if(it1.atEnd() || it2.atEnd())
+        {
+            break;
+        }
+
+        DiffStyle nextStyle = equal1 ? (equal2 ? DiffStyle::ALL_SAME : sameInIt1)
+                                     : (equal2 ? sameInIt2 : DiffStyle::DIFFERENT);
+
+        if(nextStyle != style)
+        {
+            if(run > 0)
+            {
+                styleList.push_back(StyleFragment{style, run});
+                run = 0;
+            }
+            style = nextStyle;
+        }
+
+        int step = std::min(length1, length2);
+
+        run += step;
+        it1.advance(step);
+        it2.advance(step);
+    }
+
+    assert(it1.atEnd() && it2.atEnd());
+
+    /* Add the style for the remaining set of characters if any */
+    if(run != 0)
+    {
+        /* Since the style for the entire line will be assumed to be ALL_SAME
+         * if the styleList is empty, don't create lines with only a single
+         * ALL_SAME entry. This case (all 3 lines being equal) is very common,
+         * so saving allocations here can increase performance significantly.
+         */
+        if(style != DiffStyle::ALL_SAME || !styleList.empty())
+        {
+            styleList.push_back(StyleFragment{style, run});
+        }
+    }
+
+    return styleList;
+}
+
+static std::string_view lineText(ILineProvider& lp, int line)
+{
+    if(line == -1)
+    {
+        return std::string_view();
+    }
+    auto text = lp.get(line);
+    return text.empty() ? std::string_view() : text[0];
+}
+
+std::array<StyleList, 3> determineFineDiffStylePerLine(const Diff3Line& d3l,
+                                                       ILineProvider& lpA,
+                                                       ILineProvider& lpB,
+                                                       ILineProvider& lpC)
+{
+    FineDiffBuffers buffers;
+    return determineFineDiffStylePerLine(d3l, lpA, lpB, lpC, buffers);
+}
+
+/**
+ * Calculates the fine diff of the lines of two files in a row, unless their
+ * IDs show that they are equal.
+ */
+static void fineDiffPair(const LineEquivalences *lineEquivalences,
+                         int file1, int k1, std::string_view line1,
+                         int file2, int k2, std::string_view line2,
+                         DiffList& diffList, FineDiffGranularity granularity)
+{
+    if(lineEquivalences != nullptr && k1 != -1 && k2 != -1 && lineEquivalences->equal(file1, k1, file2, k2))
+    {
+        diffList.assign(1, Diff(static_cast<int>(line1.size()), 0, 0));
+    }
+    else
+    {
+        fineDiff(k1, k2, line1, line2, diffList, granularity);
+    }
+}
+
+std::array<StyleList, 3> determineFineDiffStylePerLine(const Diff3Line& d3l,
+                                                       ILineProvider& lpA,
+                                                       ILineProvider& lpB,
+                                                       ILineProvider& lpC,
+                                                       FineDiffBuffers& buffers,
+                                                       FineDiffGranularity granularity,
+                                                       const LineEquivalences *lineEquivalences)
+{
+    auto textA = lineText(lpA, d3l.lineA);
+    auto textB = lineText(lpB, d3l.lineB);
+    auto textC = lineText(lpC, d3l.lineC);
+
+    auto& fineDiffAB = buffers.diffListAB;
+    auto& fineDiffAC = buffers.diffListAC;
+    auto& fineDiffBC = buffers.diffListBC;
+    fineDiffPair(lineEquivalences, 0, d3l.lineA, textA, 1, d3l.lineB, textB, fineDiffAB, granularity);
+    fineDiffPair(lineEquivalences, 0, d3l.lineA, textA, 2, d3l.lineC, textC, fineDiffAC, granularity);
+    fineDiffPair(lineEquivalences, 1, d3l.lineB, textB, 2, d3l.lineC, textC, fineDiffBC, granularity);
+
+    std::array<StyleList, 3> styles;
+
+    DiffListIterator itAB_A(fineDiffAB, 0);
+    DiffListIterator itAC_A(fineDiffAC, 0);
+    styles[0] = lineStyleFromFineDiffs(itAB_A, itAC_A, DiffStyle::A_B_SAME, DiffStyle::A_C_SAME);
+
+    DiffListIterator itAB_B(fineDiffAB, 1);
+    DiffListIterator itBC_B(fineDiffBC, 0);
+    styles[1] = lineStyleFromFineDiffs(itAB_B, itBC_B, DiffStyle::A_B_SAME, DiffStyle::B_C_SAME);
+
+    DiffListIterator itAC_C(fineDiffAC, 1);
+    DiffListIterator itBC_C(fineDiffBC, 1);
+    styles[2] = lineStyleFromFineDiffs(itAC_C, itBC_C, DiffStyle::A_C_SAME, DiffStyle::B_C_SAME);
+
+    return styles;
+}
+
+void determineFineDiffStyle(Diff3Table& diff3Table,
+                            ILineProvider& lpA,
+                            ILineProvider& lpB,
+                            ILineProvider& lpC,
+                            FineDiffGranularity granularity,
+                            WorkerPool& workerPool,
+                            const LineEquivalences *lineEquivalences)
+{
+    /* Many more chunks than workers keep the workers busy when the
+     * differences are concentrated in a few places */
+    size_t nrOfChunks = std::min<size_t>(diff3Table.size(), workerPool.concurrency() * 16);
+    if(nrOfChunks == 0)
+    {
+        return;
+    }
+
+    std::vector<FineDiffBuffers> buffers(workerPool.concurrency());
+    std::vector<std::vector<std::pair<size_t, std::array<StyleList, 3>>>> chunkStyles(nrOfChunks);
+
+    /* The styles of each chunk are collected separately and only added to
+     * the table at the end, because the table cannot be modified by several
+     * threads at once */
+    workerPool.run(nrOfChunks, [&](size_t chunk, unsigned worker)
+    {
+        size_t row = diff3Table.size() * chunk / nrOfChunks;
+        size_t end = diff3Table.size() * (chunk + 1) / nrOfChunks;
+        while(row < end)
+        {
+            auto d3l = diff3Table.get(row);
+            if(d3l.bAEqB && d3l.bAEqC && d3l.bBEqC)
+            {
+                /* Lines that are all equal have no style */
+                row = diff3Table.endOfEqualRun(row);
+                continue;
+            }
+            chunkStyles[chunk].emplace_back(row, determineFineDiffStylePerLine(d3l, lpA, lpB, lpC, buffers[worker],
+                                                                             granularity, lineEquivalences));
+            row++;
+        }
+    });
+
+    for(auto& styles: chunkStyles)
+    {
+        for(auto& [row, rowStyles]: styles)
+        {
+            auto d3l = diff3Table[row];
+            for(int i = 0; i < 3; i++)
+            {
+                if(!rowStyles[i].empty())
+                {
+                    d3l.style(i) = std::move(rowStyles[i]);
+                }
+            }
+        }
+    }
+}
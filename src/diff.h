@@ -0,0 +1,254 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ * Copyright (C) 2014  Joachim Eibl <joachim.eibl at gmx.de>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * This module contains the alignment algorithm taken from KDiff3.
+ *
+ * Authors: Maurice van der Pot, Joachim Eibl
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <utility>
+
+#include "common.h"
+#include "diff3table.h"
+#include "diffsource.h"
+#include "ilineprovider.h"
+#include "lineequivalences.h"
+#include "workerpool.h"
+
+/**
+ * Aligns the lines of the three input files using the diffs between each
+ * pair of them, so that lines that are equal end up in the same row.
+ *
+ * The alignment is built in a single pass over the three diff lists. Only
+ * the part of the alignment that can still change while processing the diff
+ * between B and C is kept in a linked list; everything before it is written
+ * to the result directly.
+ */
+Diff3Table calcDiff3LineList(const DiffList& diffList12,
+                             const DiffList& diffList13,
+                             const DiffList& diffList23);
+
+/**
+ * Checks that the lines of input file n occur in the diff3 line list in order
+ * and without gaps, starting at leftLine and ending at rightLine.
+ */
+void validateDiff3LineListForN(Diff3Table& diff3Table, int n, int leftLine, int rightLine);
+
+/**
+ * Moves lines up into earlier rows that have no line of their file, as long
+ * as the rows do not pass a line of that file, so that equal lines that the
+ * pairwise diffs put in separate rows end up in the same row. Rows that are
+ * left without any lines are removed. Lines are compared by their IDs in
+ * lineEquivalences.
+ */
+Diff3Table trimDiff3LineList(Diff3Table& diff3Table, const LineEquivalences& lineEquivalences);
+
+/**
+ * Produces the same table as trimDiff3LineList applied to calcDiff3LineList,
+ * but aligns and trims parts of the files on the worker pool. The files are
+ * split at rows in which all three lines are equal according to all three
+ * diff lists, because no line is moved past those. Where trimming could
+ * still move a line from one part into the previous one, those parts are
+ * trimmed again together.
+ */
+Diff3Table calcTrimmedDiff3LineList(const DiffList& diffList12,
+                                    const DiffList& diffList13,
+                                    const DiffList& diffList23,
+                                    const LineEquivalences& lineEquivalences,
+                                    WorkerPool& workerPool = WorkerPool::shared());
+
+/**
+ * Produces the same table as trimDiff3LineList applied to calcDiff3LineList,
+ * taking diffs from the sources as they become available. The sources can be
+ * filled while the table is built, for instance by diffs that run on other
+ * threads.
+ *
+ * Once the diffs that have been read cover at least minStretchLines lines of
+ * A, the stretch up to the last sync point in them is aligned and trimmed in
+ * parts on the worker pool, like the overload above does for complete diff
+ * lists. Only the diffs after that sync point are kept, so complete diff
+ * lists are never stored.
+ */
+Diff3Table calcTrimmedDiff3LineList(IDiffSource& diffs12,
+                                    IDiffSource& diffs13,
+                                    IDiffSource& diffs23,
+                                    const LineEquivalences& lineEquivalences,
+                                    WorkerPool& workerPool = WorkerPool::shared(),
+                                    int minStretchLines = 1 << 18);
+
+/**
+ * Builds a diff list from a sequence of equal and different stretches, so
+ * that diffs of parts of two lines can be put together.
+ */
+class DiffListBuilder
+{
+public:
+    void addEqual(int n)
+    {
+        if(n == 0)
+            return;
+
+        if(m_current.diff1 > 0 || m_current.diff2 > 0)
+        {
+            m_diffList.push_back(m_current);
+            m_current = Diff(0, 0, 0);
+        }
+        m_current.nofEquals += n;
+    }
+
+    void addDifferent(int n1, int n2)
+    {
+        m_current.diff1 += n1;
+        m_current.diff2 += n2;
+    }
+
+    DiffList finish()
+    {
+        if(m_current.nofEquals > 0 || m_current.diff1 > 0 || m_current.diff2 > 0)
+        {
+            m_diffList.push_back(m_current);
+        }
+        return std::move(m_diffList);
+    }
+
+private:
+    DiffList m_diffList;
+    Diff m_current = Diff(0, 0, 0);
+};
+
+/**
+ * Calculates the character-level differences between two lines. After a
+ * difference it resynchronizes at the nearest character that occurs in both
+ * lines, looking at most maxSearchRange characters ahead in line2. With match
+ * set to 2 a character only counts as a resync point if it is close to the
+ * same position in both lines or is followed by another equal character.
+ */
+DiffList calcDiff(std::string_view line1, std::string_view line2, int match, int maxSearchRange);
+void calcDiff(std::string_view line1, std::string_view line2, int match, int maxSearchRange, DiffList& diffList);
+
+/**
+ * The units in which the fine diff compares lines.
+ */
+enum class FineDiffGranularity
+{
+    CHARACTER,
+    WORD
+};
+
+/**
+ * Calculates the character-level differences between two aligned lines and
+ * turns short stretches of equal characters into differences, so that the
+ * result is not a confusing mix of equal and different characters. Line
+ * numbers k1 and k2 are -1 if the row has no line for that file. Long lines
+ * are diffed with calcLongLineDiff. With WORD granularity lines are diffed
+ * with calcWordDiff instead.
+ */
+DiffList fineDiff(int k1, int k2, std::string_view line1, std::string_view line2,
+                  FineDiffGranularity granularity = FineDiffGranularity::CHARACTER);
+void fineDiff(int k1, int k2, std::string_view line1, std::string_view line2, DiffList& diffList,
+              FineDiffGranularity granularity = FineDiffGranularity::CHARACTER);
+
+/**
+ * Walks over the characters of one of the two lines of a fine diff, in runs
+ * of characters that are either equal to or different from the other line.
+ */
+class DiffListIterator
+{
+public:
+    DiffListIterator(const DiffList& diffList, int whichFile);
+
+    bool atEnd();
+
+    /**
+     * Returns whether the next run of characters is equal and its length.
+     */
+    std::pair<bool, int> getNextRun();
+
+    void advance(int n);
+
+private:
+    int& diffField(Diff& d);
+    void updateHead();
+
+    const DiffList& m_diffList;
+    size_t m_next = 0;
+    int m_whichFile;
+    Diff m_head = Diff(0, 0, 0);
+};
+
+/**
+ * Combines the fine diffs of a line against the lines of the other two files
+ * into the style of that line.
+ */
+StyleList lineStyleFromFineDiffs(DiffListIterator& it1,
+                                 DiffListIterator& it2,
+                                 DiffStyle sameInIt1,
+                                 DiffStyle sameInIt2);
+
+/**
+ * The fine diffs of the three pairs of lines in a row, which can be reused
+ * for the next row to avoid allocating them again.
+ */
+struct FineDiffBuffers
+{
+    DiffList diffListAB;
+    DiffList diffListAC;
+    DiffList diffListBC;
+};
+
+/**
+ * Determines the styles of the lines of A, B and C in a single row. If
+ * lineEquivalences is specified, pairs of lines with the same ID are known to
+ * be equal without comparing them.
+ */
+std::array<StyleList, 3> determineFineDiffStylePerLine(const Diff3Line& d3l,
+                                                       ILineProvider& lpA,
+                                                       ILineProvider& lpB,
+                                                       ILineProvider& lpC);
+std::array<StyleList, 3> determineFineDiffStylePerLine(const Diff3Line& d3l,
+                                                       ILineProvider& lpA,
+                                                       ILineProvider& lpB,
+                                                       ILineProvider& lpC,
+                                                       FineDiffBuffers& buffers,
+                                                       FineDiffGranularity granularity = FineDiffGranularity::CHARACTER,
+                                                       const LineEquivalences *lineEquivalences = nullptr);
+
+/**
+ * Determines the styles of all rows of the table, for when every style is
+ * needed anyway. The table is split into chunks that are handled by the
+ * workers of the pool. Rows in which all lines are equal are skipped.
+ *
+ * The line providers are read from several threads, so all of their lines
+ * must have been indexed first.
+ */
+void determineFineDiffStyle(Diff3Table& diff3Table,
+                            ILineProvider& lpA,
+                            ILineProvider& lpB,
+                            ILineProvider& lpC,
+                            FineDiffGranularity granularity = FineDiffGranularity::CHARACTER,
+                            WorkerPool& workerPool = WorkerPool::shared(),
+                            const LineEquivalences *lineEquivalences = nullptr);
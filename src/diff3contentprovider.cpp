@@ -0,0 +1,92 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include "diff3contentprovider.h"
+
+Diff3ContentProvider::Diff3ContentProvider(int contentWidth, int contentHeight, Diff3Table& diff3Table, int fileIndex, ILineProvider& lp,
+                                           FineDiffCache& fineDiffCache):
+    m_contentWidth(contentWidth),
+    m_contentHeight(contentHeight),
+    m_diff3Table(diff3Table),
+    m_fileIndex(fileIndex),
+    m_lp(lp),
+    m_fineDiffCache(fineDiffCache)
+{
+}
+
+std::optional<std::string> Diff3ContentProvider::get(int contentLine)
+{
+    assert(contentLine >= 0);
+
+    int fileLine;
+    if(contentLine >= m_contentHeight)
+    {
+        fileLine = -1;
+    }
+    else
+    {
+        fileLine = m_diff3Table.line(contentLine, m_fileIndex);
+    }
+
+    if(fileLine == -1)
+    {
+        return std::nullopt;
+    }
+
+    auto text = m_lp.get(fileLine);
+    if(text.empty())
+    {
+        return std::nullopt;
+    }
+    return std::string(text[0]);
+}
+
+StyleList Diff3ContentProvider::getFormat(int contentLine)
+{
+    if(contentLine < m_contentHeight)
+    {
+        return m_fineDiffCache.getStyle(contentLine, m_fileIndex);
+    }
+    else
+    {
+        return StyleList();
+    }
+}
+
+int Diff3ContentProvider::getContentWidth()
+{
+    return m_contentWidth;
+}
+
+int Diff3ContentProvider::getContentHeight()
+{
+    return m_contentHeight;
+}
+
+void Diff3ContentProvider::connectLineChangeObserver([[maybe_unused]] std::function<void(LineNumberRange)> observer)
+{
+    /* no need to do anything for content that doesn't change */
+}
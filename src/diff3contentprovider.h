@@ -0,0 +1,61 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include "common.h"
+#include "diff3table.h"
+#include "finediffcache.h"
+#include "iformattedcontentprovider.h"
+#include "ilineprovider.h"
+
+/**
+ * Diff3ContentProvider provides an IFormattedContentProvider interface for the
+ * lines in a Diff3Table belonging to a single file. Which file that is is
+ * selected when the Diff3ContentProvider is created.
+ *
+ * The styles of the lines are taken from a FineDiffCache, which only
+ * calculates them for the lines that are actually shown.
+ */
+class Diff3ContentProvider: public IFormattedContentProvider
+{
+public:
+    Diff3ContentProvider(int contentWidth, int contentHeight, Diff3Table& diff3Table, int fileIndex, ILineProvider& lp,
+                         FineDiffCache& fineDiffCache);
+
+    std::optional<std::string> get(int contentLine) override;
+    StyleList getFormat(int contentLine) override;
+    int getContentWidth() override;
+    int getContentHeight() override;
+    void connectLineChangeObserver(std::function<void(LineNumberRange)> observer) override;
+
+private:
+    int m_contentWidth;
+    int m_contentHeight;
+    Diff3Table& m_diff3Table;
+    int m_fileIndex;
+    ILineProvider& m_lp;
+    FineDiffCache& m_fineDiffCache;
+};
@@ -0,0 +1,348 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "diff3table.h"
+
+namespace
+{
+
+template<typename T>
+void writeVector(std::ostream& output, const std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    uint64_t size = values.size();
+    output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+    output.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+/**
+ * A segment as it is written, with every byte defined so that nothing of
+ * the memory it was written from ends up in the output.
+ */
+struct StoredSegment
+{
+    uint64_t firstRow;
+    uint64_t firstStoredRow;
+    int32_t firstLines[3];
+    uint8_t isEqualRun;
+    uint8_t unused[3];
+};
+static_assert(sizeof(StoredSegment) == 32, "StoredSegment must not contain padding");
+
+/**
+ * Returns the number of bytes left in the input, so that a size read from it
+ * can be checked before anything is allocated for it.
+ */
+uint64_t remainingBytes(std::istream& input)
+{
+    auto position = input.tellg();
+    input.seekg(0, std::ios::end);
+    auto end = input.tellg();
+    input.seekg(position);
+    if(position == std::istream::pos_type(-1) || end == std::istream::pos_type(-1) || !input)
+    {
+        return 0;
+    }
+    return static_cast<uint64_t>(end - position);
+}
+
+template<typename T>
+bool readVector(std::istream& input, std::vector<T>& values)
+{
+    static_assert(std::is_trivially_copyable<T>::value);
+    uint64_t size;
+    if(!input.read(reinterpret_cast<char *>(&size), sizeof(size)) ||
+       size > remainingBytes(input) / sizeof(T))
+    {
+        return false;
+    }
+    values.resize(size);
+    return static_cast<bool>(input.read(reinterpret_cast<char *>(values.data()), size * sizeof(T)));
+}
+
+}
+
+void Diff3Table::reserve(size_t nrOfStoredRows)
+{
+    for(auto& column: m_lines)
+    {
+        column.reserve(nrOfStoredRows);
+    }
+    m_equal.reserve(nrOfStoredRows);
+}
+
+void Diff3Table::push_back(const Diff3Line& d3l)
+{
+    if(d3l.bAEqB && d3l.bAEqC && d3l.bBEqC)
+    {
+        bool continuesRun = false;
+        if(!m_segments.empty() && m_segments.back().isEqualRun)
+        {
+            auto& run = m_segments.back();
+            int offset = static_cast<int>(m_size - run.firstRow);
+            continuesRun = run.firstLines[0] + offset == d3l.lineA &&
+                           run.firstLines[1] + offset == d3l.lineB &&
+                           run.firstLines[2] + offset == d3l.lineC;
+        }
+
+        if(!continuesRun)
+        {
+            m_segments.push_back(Segment{m_size, true, {d3l.lineA, d3l.lineB, d3l.lineC}, 0});
+        }
+    }
+    else
+    {
+        if(m_segments.empty() || m_segments.back().isEqualRun)
+        {
+            m_segments.push_back(Segment{m_size, false, {-1, -1, -1}, m_equal.size()});
+        }
+
+        m_lines[0].push_back(d3l.lineA);
+        m_lines[1].push_back(d3l.lineB);
+        m_lines[2].push_back(d3l.lineC);
+        m_equal.push_back((d3l.bAEqB ? equalityMask(DiffSelection::A_vs_B) : 0) |
+                          (d3l.bAEqC ? equalityMask(DiffSelection::A_vs_C) : 0) |
+                          (d3l.bBEqC ? equalityMask(DiffSelection::B_vs_C) : 0));
+    }
+    m_size++;
+}
+
+void Diff3Table::append(const Diff3Table& other)
+{
+    assert(other.m_styles.empty());
+
+    for(size_t segment = 0; segment < other.m_segments.size(); segment++)
+    {
+        auto& s = other.m_segments[segment];
+        size_t nrOfRows = other.endOfSegment(segment) - s.firstRow;
+        if(s.isEqualRun)
+        {
+            /* The first row starts or extends a run that the others follow */
+            push_back(Diff3Line{ s.firstLines[0], s.firstLines[1], s.firstLines[2], true, true, true });
+            m_size += nrOfRows - 1;
+        }
+        else
+        {
+            if(m_segments.empty() || m_segments.back().isEqualRun)
+            {
+                m_segments.push_back(Segment{m_size, false, {-1, -1, -1}, m_equal.size()});
+            }
+
+            for(int i = 0; i < 3; i++)
+            {
+                auto first = other.m_lines[i].begin() + s.firstStoredRow;
+                m_lines[i].insert(m_lines[i].end(), first, first + nrOfRows);
+            }
+            auto first = other.m_equal.begin() + s.firstStoredRow;
+            m_equal.insert(m_equal.end(), first, first + nrOfRows);
+            m_size += nrOfRows;
+        }
+    }
+}
+
+Diff3Line Diff3Table::get(size_t index) const
+{
+    assert(index < size());
+
+    auto segment = findSegment(index);
+
+    Diff3Line d3l;
+    d3l.lineA = line(index, segment, 0);
+    d3l.lineB = line(index, segment, 1);
+    d3l.lineC = line(index, segment, 2);
+    d3l.bAEqB = equal(index, segment, DiffSelection::A_vs_B);
+    d3l.bAEqC = equal(index, segment, DiffSelection::A_vs_C);
+    d3l.bBEqC = equal(index, segment, DiffSelection::B_vs_C);
+    return d3l;
+}
+
+const StyleList& Diff3Table::style(size_t index, int i) const
+{
+    static const StyleList noStyle;
+
+    assert(i >= 0 && i < 3);
+    auto it = m_styles.find(index);
+    return (it == m_styles.end()) ? noStyle : it->second[i];
+}
+
+size_t Diff3Table::endOfEqualRun(size_t index) const
+{
+    assert(index < size());
+
+    auto segment = findSegment(index);
+    return m_segments[segment].isEqualRun ? endOfSegment(segment) : index + 1;
+}
+
+void Diff3Table::write(std::ostream& output) const
+{
+    uint64_t size = m_size;
+    output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+
+    std::vector<StoredSegment> storedSegments(m_segments.size(), StoredSegment{});
+    for(size_t i = 0; i < m_segments.size(); i++)
+    {
+        auto& segment = m_segments[i];
+        auto& stored = storedSegments[i];
+        stored.firstRow = segment.firstRow;
+        stored.firstStoredRow = segment.firstStoredRow;
+        std::copy(std::begin(segment.firstLines), std::end(segment.firstLines), stored.firstLines);
+        stored.isEqualRun = segment.isEqualRun ? 1 : 0;
+    }
+    writeVector(output, storedSegments);
+    for(auto& column: m_lines)
+    {
+        writeVector(output, column);
+    }
+    writeVector(output, m_equal);
+}
+
+bool Diff3Table::read(std::istream& input, Diff3Table& table)
+{
+    uint64_t size;
+    if(!input.read(reinterpret_cast<char *>(&size), sizeof(size)))
+    {
+        return false;
+    }
+    table = Diff3Table();
+    table.m_size = size;
+
+    std::vector<StoredSegment> storedSegments;
+    if(!readVector(input, storedSegments))
+    {
+        return false;
+    }
+    table.m_segments.reserve(storedSegments.size());
+    for(auto& stored: storedSegments)
+    {
+        if(stored.isEqualRun > 1)
+        {
+            return false;
+        }
+        table.m_segments.push_back(Segment{ stored.firstRow, stored.isEqualRun != 0,
+                                            { stored.firstLines[0], stored.firstLines[1], stored.firstLines[2] },
+                                            stored.firstStoredRow });
+    }
+
+    bool complete = true;
+    for(auto& column: table.m_lines)
+    {
+        complete = complete && readVector(input, column);
+    }
+    return complete && readVector(input, table.m_equal) && table.isConsistent();
+}
+
+bool Diff3Table::isConsistent() const
+{
+    size_t nrOfStoredRows = m_equal.size();
+    for(auto& column: m_lines)
+    {
+        if(column.size() != nrOfStoredRows ||
+           std::any_of(column.begin(), column.end(), [](int line) { return line < -1; }))
+        {
+            return false;
+        }
+    }
+
+    if(m_segments.empty() != (m_size == 0) || (!m_segments.empty() && m_segments[0].firstRow != 0))
+    {
+        return false;
+    }
+
+    /* The stored rows are those of the segments that are not equal runs, in
+     * the same order */
+    size_t storedRow = 0;
+    for(size_t segment = 0; segment < m_segments.size(); segment++)
+    {
+        auto& s = m_segments[segment];
+        size_t end = endOfSegment(segment);
+        if(end <= s.firstRow || end > m_size)
+        {
+            return false;
+        }
+
+        size_t nrOfRows = end - s.firstRow;
+        if(s.isEqualRun)
+        {
+            for(int line: s.firstLines)
+            {
+                if(line < 0 || nrOfRows > static_cast<size_t>(INT_MAX - line))
+                {
+                    return false;
+                }
+            }
+        }
+        else
+        {
+            if(s.firstStoredRow != storedRow || nrOfRows > nrOfStoredRows - storedRow)
+            {
+                return false;
+            }
+            storedRow += nrOfRows;
+        }
+    }
+    return storedRow == nrOfStoredRows;
+}
+
+size_t Diff3Table::findSegment(size_t index) const
+{
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), index,
+                               [](size_t index, const Segment& segment) { return index < segment.firstRow; });
+    assert(it != m_segments.begin());
+    return std::distance(m_segments.begin(), it) - 1;
+}
+
+size_t Diff3Table::endOfSegment(size_t segment) const
+{
+    return (segment + 1 < m_segments.size()) ? m_segments[segment + 1].firstRow : m_size;
+}
+
+int Diff3Table::line(size_t index, size_t segment, int i) const
+{
+    assert(i >= 0 && i < 3);
+
+    auto& s = m_segments[segment];
+    if(s.isEqualRun)
+    {
+        return s.firstLines[i] + static_cast<int>(index - s.firstRow);
+    }
+    return m_lines[i][s.firstStoredRow + (index - s.firstRow)];
+}
+
+bool Diff3Table::equal(size_t index, size_t segment, DiffSelection diffSel) const
+{
+    auto& s = m_segments[segment];
+    if(s.isEqualRun)
+    {
+        return true;
+    }
+    return (m_equal[s.firstStoredRow + (index - s.firstRow)] & equalityMask(diffSel)) != 0;
+}
@@ -0,0 +1,246 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * The alignment of the lines of the three input files.
+ *
+ * Most rows of an alignment are part of long runs in which the lines of all
+ * three files are equal, so the table consists of segments. A segment is
+ * either such a run, which is stored as nothing more than the line numbers
+ * of its first row, or a block of other rows. The rows of those blocks are
+ * stored in a column per line number and a column with one bit per equality.
+ * Finding the row at an index is a binary search over the segments, so the
+ * memory needed and the cost of iterating over segments scale with the
+ * number of differences instead of with the size of the files.
+ *
+ * Only rows in which the lines differ get a fine-diff style, so styles are
+ * kept in a side table that only has entries for the rows a style was set for.
+ */
+class Diff3Table
+{
+private:
+    struct Segment
+    {
+        /** The index of the first row in the segment */
+        size_t firstRow;
+        /** Whether all lines are equal in the rows of this segment */
+        bool isEqualRun;
+        /** The line numbers in the first row if this is an equal run */
+        int firstLines[3];
+        /** The index in the columns of the first row if this is not an equal run */
+        size_t firstStoredRow;
+    };
+
+public:
+    /**
+     * Refers to a single row of the table and provides the same accessors as
+     * Diff3Line. Line numbers and equalities cannot be changed after a row
+     * has been added, but styles can.
+     */
+    class Row
+    {
+    public:
+        Row(Diff3Table& table, size_t index, size_t segment):
+            m_table(table),
+            m_index(index),
+            m_segment(segment)
+        {
+        }
+
+        int line(int i) const
+        {
+            return m_table.line(m_index, m_segment, i);
+        }
+
+        bool equal(DiffSelection diffSel) const
+        {
+            return m_table.equal(m_index, m_segment, diffSel);
+        }
+
+        StyleList& style(int i)
+        {
+            assert(i >= 0 && i < 3);
+            return m_table.m_styles[m_index][i];
+        }
+
+    private:
+        Diff3Table& m_table;
+        size_t m_index;
+        size_t m_segment;
+    };
+
+    /**
+     * Iterates over the rows of the table without searching for the segment
+     * of each row.
+     */
+    class Iterator
+    {
+    public:
+        Iterator(Diff3Table& table, size_t index, size_t segment):
+            m_table(table),
+            m_index(index),
+            m_segment(segment)
+        {
+        }
+
+        Row operator*() const
+        {
+            return Row(m_table, m_index, m_segment);
+        }
+
+        Iterator& operator++()
+        {
+            m_index++;
+            if(m_segment + 1 < m_table.m_segments.size() &&
+               m_table.m_segments[m_segment + 1].firstRow == m_index)
+            {
+                m_segment++;
+            }
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return m_index != other.m_index;
+        }
+
+    private:
+        Diff3Table& m_table;
+        size_t m_index;
+        size_t m_segment;
+    };
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Reserves room for the specified number of rows that are not part of a
+     * run of equal rows.
+     */
+    void reserve(size_t nrOfStoredRows);
+
+    void push_back(const Diff3Line& d3l);
+
+    /**
+     * Appends the rows of another table, which must not have styles yet. A
+     * run of equal rows at the start of the other table extends a run at the
+     * end of this one if their line numbers follow on, as if the rows had
+     * been added one by one.
+     */
+    void append(const Diff3Table& other);
+
+    Row operator[](size_t index)
+    {
+        assert(index < size());
+        return Row(*this, index, findSegment(index));
+    }
+
+    Iterator begin()
+    {
+        return Iterator(*this, 0, 0);
+    }
+
+    Iterator end()
+    {
+        return Iterator(*this, size(), m_segments.size());
+    }
+
+    /**
+     * Returns a copy of the specified row.
+     */
+    Diff3Line get(size_t index) const;
+
+    /**
+     * Returns line i of the specified row.
+     */
+    int line(size_t index, int i) const
+    {
+        assert(index < size());
+        return line(index, findSegment(index), i);
+    }
+
+    /**
+     * Returns the style of line i in the specified row without adding it to
+     * the side table. Rows without a style return an empty list.
+     */
+    const StyleList& style(size_t index, int i) const;
+
+    /**
+     * Returns the index of the row after the run of equal rows that the
+     * specified row is part of, or the index of the next row if it is not
+     * part of such a run.
+     */
+    size_t endOfEqualRun(size_t index) const;
+
+    /**
+     * Writes the rows in a binary form that read() turns back into a table
+     * by reading the segments and columns in bulk, without adding the rows
+     * one by one. Styles are not written.
+     */
+    void write(std::ostream& output) const;
+
+    /**
+     * Reads a table that was written by write() on the same kind of machine.
+     * Returns false if the input ends early or does not describe a valid
+     * table.
+     */
+    static bool read(std::istream& input, Diff3Table& table);
+
+private:
+    static uint8_t equalityMask(DiffSelection diffSel)
+    {
+        return 1 << static_cast<int>(diffSel);
+    }
+
+    /**
+     * Returns whether the segments cover all rows and refer to the stored
+     * rows in order, which read() checks before a table is used.
+     */
+    bool isConsistent() const;
+
+    size_t findSegment(size_t index) const;
+    size_t endOfSegment(size_t segment) const;
+    int line(size_t index, size_t segment, int i) const;
+    bool equal(size_t index, size_t segment, DiffSelection diffSel) const;
+
+    size_t m_size = 0;
+    std::vector<Segment> m_segments;
+    std::vector<int> m_lines[3];
+    std::vector<uint8_t> m_equal;
+    std::unordered_map<size_t, std::array<StyleList, 3>> m_styles;
+};
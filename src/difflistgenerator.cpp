@@ -24,98 +24,276 @@
  * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
  */
 
+#include <algorithm>
+#include <array>
 #include <cassert>
+#include <cstdarg>
+#include <cstdint>
+#include <condition_variable>
+#include <cstdio>
 #include <exception>
+#include <functional>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 
+#include "bytecompare.h"
 #include "common.h"
+#include "diff.h"
 #include "difflistgenerator.h"
+#include "diffsource.h"
+#include "workerpool.h"
 
 #include "gnudiff.h"
 #include "ilineprovider.h"
 //import myassert;
 
+static bool progressOutput = true;
 
-struct HashedLine
+void setProgressOutput(bool enabled)
 {
-private:
-    ILineProvider& m_lp;
-    int m_lineNumber;
+    progressOutput = enabled;
+}
 
-public:
-    HashedLine(ILineProvider& lp, int lineNumber):
-        m_lp(lp),
-        m_lineNumber(lineNumber)
+static void progress(const char *format, ...)
+{
+    if(progressOutput)
     {
+        va_list args;
+        va_start(args, format);
+        vprintf(format, args);
+        va_end(args);
     }
+}
 
-    const std::string_view getLine() const
+static int countLines(std::string_view text)
+{
+    int count = std::count(text.begin(), text.end(), '\n');
+    if(!text.empty() && text.back() != '\n')
     {
-        return m_lp.get(m_lineNumber)[0];
+        count++;
     }
+    return count;
+}
 
-    bool operator==(const HashedLine& other) const
+CommonEnds findCommonEnds(const std::vector<std::string_view>& contents, const std::vector<int>& files)
+{
+    CommonEnds ends;
+    auto first = contents[files[0]];
+
+    size_t prefix = first.size();
+    size_t shortest = first.size();
+    for(auto file: files)
     {
-        return getLine() == other.getLine();
+        prefix = std::min(prefix, commonPrefixLength(first, contents[file]));
+        shortest = std::min(shortest, contents[file].size());
     }
-};
 
-namespace std
+    /* Only complete lines can be left out, so the prefix ends after the last
+     * newline in it. */
+    auto lastNewline = first.substr(0, prefix).rfind('\n');
+    ends.prefixBytes = (lastNewline == std::string_view::npos) ? 0 : lastNewline + 1;
+    ends.prefixLines = countLines(first.substr(0, ends.prefixBytes));
+
+    /* The suffix may not overlap with the prefix in any of the files */
+    size_t suffix = shortest - ends.prefixBytes;
+    for(auto file: files)
+    {
+        suffix = std::min(suffix, commonSuffixLength(first, contents[file]));
+    }
+
+    /* The suffix must also start at the beginning of a line in every file */
+    bool startsAtLineStart = true;
+    for(auto file: files)
+    {
+        auto& content = contents[file];
+        size_t suffixStart = content.size() - suffix;
+        if(suffixStart != ends.prefixBytes && content[suffixStart - 1] != '\n')
+        {
+            startsAtLineStart = false;
+        }
+    }
+    if(!startsAtLineStart)
+    {
+        auto firstNewline = first.substr(first.size() - suffix).find('\n');
+        suffix = (firstNewline == std::string_view::npos) ? 0 : suffix - (firstNewline + 1);
+    }
+    ends.suffixBytes = suffix;
+    ends.suffixLines = countLines(first.substr(first.size() - suffix));
+
+    return ends;
+}
+
+/**
+ * The marks that gnudiff starts from when it decides which lines to discard
+ * before diffing, for the lines between the common ends of every file
+ * against every other file: 1 if a line does not occur in the other file
+ * and 2 if it occurs there many times.
+ */
+using DiscardMarks = std::array<std::array<std::vector<char>, MAX_NR_OF_FILES>, MAX_NR_OF_FILES>;
+
+/**
+ * Sets the discard marks of file against otherFile in the same way as
+ * gnudiff's discard_confusing_lines, but from the number of times each line
+ * occurs in otherFile that was counted while hashing.
+ */
+static void markDiscardableLines(const std::vector<LineId>& ids,
+                                 const std::vector<std::array<uint16_t, MAX_NR_OF_FILES>>& counts,
+                                 int otherFile,
+                                 const CommonEnds& ends,
+                                 std::vector<char>& marks)
 {
-    template <>
-    class hash<HashedLine>
+    size_t nrOfLines = ids.size() - ends.prefixLines - ends.suffixLines;
+
+    /* MANY is about the square root of the number of lines, so the 16 bit
+     * counts only reach it in files of more than 2^34 lines */
+    size_t many = 5;
+    size_t tem = nrOfLines / 64;
+    while((tem = tem >> 2) > 0)
+    {
+        many *= 2;
+    }
+
+    marks.assign(nrOfLines, 0);
+    for(size_t i = 0; i < nrOfLines; i++)
     {
-    public:
-        std::uint64_t operator()(const HashedLine& hashedLine) const
+        /* gnudiff never discards lines of class 0 */
+        auto id = ids[ends.prefixLines + i];
+        if(id == 0)
         {
-            return std::hash<std::string_view>()(hashedLine.getLine());
+            continue;
         }
-    };
+        auto count = counts[id][otherFile];
+        if(count == 0)
+        {
+            marks[i] = 1;
+        }
+        else if(count > many)
+        {
+            marks[i] = 2;
+        }
+    }
+}
+
+/**
+ * Passes the ID of every line of text to addId, together with whether the
+ * line is new to hashmap. A new line gets the next unused ID.
+ */
+template<typename AddId>
+static void hashLines(std::string_view text, std::unordered_map<std::string_view, lin>& hashmap, AddId addId)
+{
+    while(!text.empty())
+    {
+        auto lineLength = text.find('\n');
+        lineLength = (lineLength == std::string_view::npos) ? text.size() : lineLength + 1;
+
+        auto [it, inserted] = hashmap.try_emplace(text.substr(0, lineLength), hashmap.size());
+        addId(it->second, inserted);
+
+        text.remove_prefix(lineLength);
+    }
 }
 
-std::vector<std::vector<lin>> createLineEquivalenceLists(const std::vector<ILineProvider*>& lineProviders, lin *p_equivMax)
+/**
+ * Assigns an equivalence number to every line of the specified files. Files
+ * that are not specified are left alone.
+ *
+ * The lines in the common ends are the same in all of these files, so they
+ * are only hashed in the first one and their numbers are copied to the
+ * others. Lines therefore have the same number if and only if they are
+ * equal, wherever they are.
+ *
+ * If discardMarks is specified, the lines between the common ends are
+ * counted while they are hashed and the marks are set for every pair of the
+ * specified files. gnudiff then does not have to count lines per
+ * equivalence number itself, which takes memory in proportion to the number
+ * of different lines for every diff.
+ */
+static void createLineEquivalenceLists(const std::vector<std::string_view>& contents,
+                                       const std::vector<int>& files,
+                                       const CommonEnds& ends,
+                                       LineEquivalences& lineEquivalences,
+                                       lin *p_equivMax,
+                                       DiscardMarks *discardMarks = nullptr)
 {
-    std::vector<std::vector<lin>> equivs(lineProviders.size());
-    std::unordered_map<HashedLine, lin> hashmap;
+    std::unordered_map<std::string_view, lin> hashmap;
 
-    for(size_t lpIndex = 0; lpIndex < lineProviders.size(); lpIndex++)
+    /* The number of lines with each equivalence number in every file, which
+     * saturates like the counts in gnudiff. gnudiff does not see the common
+     * ends, so they are not counted. */
+    std::vector<std::array<uint16_t, MAX_NR_OF_FILES>> counts;
+
+    for(auto fileIndex: files)
     {
-        printf("Hashing lines of file %lu\n", lpIndex);
-        assert(lineProviders[lpIndex] != nullptr);
+        progress("Hashing lines of file %d\n", fileIndex);
+
+        auto& ids = lineEquivalences.ids(fileIndex);
+        ids.assign(ends.prefixLines, 0);
 
-        int i = 0;
-        while(lineProviders[lpIndex]->get(i).size() != 0)
+        auto middle = contents[fileIndex].substr(ends.prefixBytes,
+                                                 contents[fileIndex].size() - ends.prefixBytes - ends.suffixBytes);
+        hashLines(middle, hashmap, [&](lin id, bool inserted)
         {
-            lin equivid;
-            HashedLine l = HashedLine(*(lineProviders[lpIndex]), i);
-            auto it = hashmap.find(l);
-            if(it == hashmap.end())
+            ids.push_back(id);
+            if(discardMarks != nullptr)
             {
-                equivid = hashmap[l] = hashmap.size();
+                if(inserted)
+                {
+                    counts.emplace_back();
+                }
+                auto& count = counts[id][fileIndex];
+                count += (count < UINT16_MAX);
             }
-            else
+        });
+
+        ids.resize(ids.size() + ends.suffixLines);
+    }
+
+    auto& first = contents[files[0]];
+    std::vector<lin> prefixIds;
+    std::vector<lin> suffixIds;
+    hashLines(first.substr(0, ends.prefixBytes), hashmap, [&prefixIds](lin id, bool) { prefixIds.push_back(id); });
+    hashLines(first.substr(first.size() - ends.suffixBytes), hashmap,
+              [&suffixIds](lin id, bool) { suffixIds.push_back(id); });
+    assert(prefixIds.size() == static_cast<size_t>(ends.prefixLines));
+    assert(suffixIds.size() == static_cast<size_t>(ends.suffixLines));
+
+    *p_equivMax = hashmap.size();
+
+    for(auto fileIndex: files)
+    {
+        auto& ids = lineEquivalences.ids(fileIndex);
+        std::copy(prefixIds.begin(), prefixIds.end(), ids.begin());
+        std::copy(suffixIds.begin(), suffixIds.end(), ids.end() - ends.suffixLines);
+    }
+
+    if(discardMarks != nullptr)
+    {
+        for(auto fileIndex: files)
+        {
+            for(auto otherFileIndex: files)
             {
-                equivid = it->second;
+                if(otherFileIndex != fileIndex)
+                {
+                    markDiscardableLines(lineEquivalences.ids(fileIndex), counts, otherFileIndex, ends,
+                                         (*discardMarks)[fileIndex][otherFileIndex]);
+                }
             }
-            equivs[lpIndex].push_back(equivid);
-            i++;
         }
     }
-
-    *p_equivMax = hashmap.size();
-    return equivs;
 }
 
-struct DiffListContext
+struct HunkContext
 {
     int currentLine0;
     int currentLine1;
-    DiffList diffList;
+    const std::function<void(const Diff&)>* addDiff;
 };
 
-extern "C" void addHunkToDiffList(int first0, int last0, int first1, int last1, void *pContext)
+extern "C" void addHunk(int first0, int last0, int first1, int last1, void *pContext)
 {
-    auto dlContext = static_cast<DiffListContext *>(pContext);
+    auto hunkContext = static_cast<HunkContext *>(pContext);
 
     first0--;
     last0--;
@@ -123,74 +301,317 @@ extern "C" void addHunkToDiffList(int first0, int last0, int first1, int last1,
     last1--;
 
     Diff d = Diff(0, 0, 0);
-    d.nofEquals = first0 - dlContext->currentLine0;
-    assert(d.nofEquals == first1 - dlContext->currentLine1);
+    d.nofEquals = first0 - hunkContext->currentLine0;
+    assert(d.nofEquals == first1 - hunkContext->currentLine1);
     d.diff1 = last0 + 1 - first0;
     d.diff2 = last1 + 1 - first1;
 
-    dlContext->currentLine0 += d.nofEquals + d.diff1;
-    dlContext->currentLine1 += d.nofEquals + d.diff2;
+    hunkContext->currentLine0 += d.nofEquals + d.diff1;
+    hunkContext->currentLine1 += d.nofEquals + d.diff2;
 
-    dlContext->diffList.push_back(d);
+    (*hunkContext->addDiff)(d);
 }
 
-DiffList diffPair(std::vector<lin> source0, std::vector<lin> source1, lin equivMax)
+/**
+ * Diffs two files given the equivalence numbers of all of their lines and
+ * the discard marks of each against the other, which are used up. Only the
+ * lines between the common ends are passed to gnudiff. The diffs are passed
+ * to addDiff as soon as gnudiff reports them.
+ */
+static void diffPair(std::vector<lin>& source0, std::vector<lin>& source1, lin equivMax, const CommonEnds& ends,
+                     std::vector<char>& discards0, std::vector<char>& discards1,
+                     const std::function<void(const Diff&)>& addDiff)
 {
     comparison cmp;
+    lin endLines = ends.prefixLines + ends.suffixLines;
 
-    cmp.file[0].buffered_lines = source0.size();
-    cmp.file[0].prefix_lines = 0;
-    cmp.file[0].equivs = &source0[0];
+    cmp.file[0].buffered_lines = source0.size() - endLines;
+    cmp.file[0].prefix_lines = ends.prefixLines;
+    cmp.file[0].equivs = source0.data() + ends.prefixLines;
     cmp.file[0].equiv_max = equivMax;
+    cmp.file[0].discards = discards0.data();
 
-    cmp.file[1].buffered_lines = source1.size();
-    cmp.file[1].prefix_lines = 0;
-    cmp.file[1].equivs = &source1[0];
+    cmp.file[1].buffered_lines = source1.size() - endLines;
+    cmp.file[1].prefix_lines = ends.prefixLines;
+    cmp.file[1].equivs = source1.data() + ends.prefixLines;
     cmp.file[1].equiv_max = equivMax;
+    cmp.file[1].discards = discards1.data();
+
+    HunkContext hunkContext;
+    hunkContext.currentLine0 = 0;
+    hunkContext.currentLine1 = 0;
+    hunkContext.addDiff = &addDiff;
 
-    DiffListContext dlContext;
-    dlContext.currentLine0 = 0;
-    dlContext.currentLine1 = 0;
+    setHunkCallback(&addHunk, &hunkContext);
 
-    setHunkCallback(&addHunkToDiffList, &dlContext);
+    diff_2_files(&cmp);
 
-    int ret = diff_2_files(&cmp);
+    /* The marks are no longer needed */
+    std::vector<char>().swap(discards0);
+    std::vector<char>().swap(discards1);
 
     // TODO: check if we can use size_t everywhere instead of int
-    int remainingLines1 = static_cast<int>(source0.size()) - dlContext.currentLine0;
-    int remainingLines2 = static_cast<int>(source1.size()) - dlContext.currentLine1;
+    int size0 = static_cast<int>(source0.size());
+    int size1 = static_cast<int>(source1.size());
+    int remainingLines1 = size0 - hunkContext.currentLine0;
+    int remainingLines2 = size1 - hunkContext.currentLine1;
     assert(remainingLines1 == remainingLines2); // Remaining lines not the same for the two files
     if(remainingLines1 > 0)
     {
-        dlContext.diffList.push_back(Diff(remainingLines1, 0, 0));
+        addDiff(Diff(remainingLines1, 0, 0));
     }
+}
+
+/**
+ * Diffs two files like diffPair and returns the complete diff list.
+ */
+static DiffList diffPair(std::vector<lin>& source0, std::vector<lin>& source1, lin equivMax, const CommonEnds& ends,
+                         std::vector<char>& discards0, std::vector<char>& discards1)
+{
+    DiffList diffList;
+    diffPair(source0, source1, equivMax, ends, discards0, discards1,
+             [&diffList](const Diff& d) { diffList.push_back(d); });
 
-    verifyDiffList(dlContext.diffList, static_cast<int>(source0.size()), static_cast<int>(source1.size()));
+    verifyDiffList(diffList, static_cast<int>(source0.size()), static_cast<int>(source1.size()));
+
+    return diffList;
+}
 
-    return dlContext.diffList;
+/**
+ * Returns the input files that take part in any of the comparisons.
+ */
+static std::vector<int> filesToDiff(const std::vector<std::pair<int, int>>& comparisons)
+{
+    std::vector<int> files;
+    for(auto [first, second]: comparisons)
+    {
+        for(auto file: { first, second })
+        {
+            if(std::find(files.begin(), files.end(), file) == files.end())
+            {
+                files.push_back(file);
+            }
+        }
+    }
+    return files;
 }
 
-std::vector<DiffList> generateDiffLists(const std::vector<ILineProvider*>& lineProviders)
+/**
+ * Diffs the specified pairs of files. Only the files that take part in one of
+ * the comparisons are hashed.
+ */
+static std::vector<DiffList> diffPairs(const std::vector<std::string_view>& contents,
+                                       const std::vector<std::pair<int, int>>& comparisons,
+                                       LineEquivalences& lineEquivalences)
 {
+    auto files = filesToDiff(comparisons);
+    auto ends = findCommonEnds(contents, files);
+    progress("Skipping %d identical lines at the start and %d at the end\n", ends.prefixLines, ends.suffixLines);
+
     lin equivMax;
-    auto equivs = createLineEquivalenceLists(lineProviders, &equivMax);
+    DiscardMarks discardMarks;
+    createLineEquivalenceLists(contents, files, ends, lineEquivalences, &equivMax, &discardMarks);
 
     std::vector<DiffList> dls;
-    int comparisons[3][2] = {
-        { 0, 1 },
-        { 0, 2 },
-        { 1, 2 }
-    };
-
-    for(auto pair: comparisons)
+    for(auto [first, second]: comparisons)
     {
-        printf("Diffing pair of files %d vs %d\n", pair[0], pair[1]);
-        dls.push_back(diffPair(equivs[pair[0]], equivs[pair[1]], equivMax));
+        progress("Diffing pair of files %d vs %d\n", first, second);
+        dls.push_back(diffPair(lineEquivalences.ids(first), lineEquivalences.ids(second), equivMax, ends,
+                               discardMarks[first][second], discardMarks[second][first]));
     }
 
     return dls;
 }
 
+/**
+ * Returns the diff list of a file against an identical copy of itself.
+ */
+static DiffList unchangedDiffList(std::string_view content)
+{
+    DiffList diffList;
+    int lines = countLines(content);
+    if(lines > 0)
+    {
+        diffList.push_back(Diff(lines, 0, 0));
+    }
+    return diffList;
+}
+
+/**
+ * Returns the diff list of B vs A given the diff list of A vs B.
+ */
+static DiffList mirroredDiffList(const DiffList& diffList)
+{
+    DiffList mirrored;
+    mirrored.reserve(diffList.size());
+    for(auto& d: diffList)
+    {
+        mirrored.push_back(Diff(d.nofEquals, d.diff2, d.diff1));
+    }
+    return mirrored;
+}
+
+static std::vector<std::string_view> getContents(const std::vector<ILineProvider*>& lineProviders)
+{
+    std::vector<std::string_view> contents;
+    for(auto lineProvider: lineProviders)
+    {
+        assert(lineProvider != nullptr);
+        contents.push_back(lineProvider->getContent());
+    }
+    return contents;
+}
+
+std::vector<DiffList> generateDiffLists(const std::vector<ILineProvider*>& lineProviders,
+                                        LineEquivalences& lineEquivalences)
+{
+    auto contents = getContents(lineProviders);
+
+    /* Comparing the sizes first makes these checks cheap for files that differ */
+    bool AEqB = contents[0] == contents[1];
+    bool AEqC = contents[0] == contents[2];
+    bool BEqC = contents[1] == contents[2];
+
+    /* When two of the files are identical, a single diff provides all three
+     * diff lists and the lines of one of them get the same IDs as the other. */
+    if(AEqB && AEqC)
+    {
+        progress("All input files are identical\n");
+        lin equivMax;
+        createLineEquivalenceLists(contents, { 0 }, CommonEnds(), lineEquivalences, &equivMax);
+        lineEquivalences.ids(1) = lineEquivalences.ids(0);
+        lineEquivalences.ids(2) = lineEquivalences.ids(0);
+        auto diffList = unchangedDiffList(contents[0]);
+        return { diffList, diffList, diffList };
+    }
+    else if(AEqB)
+    {
+        progress("Files 0 and 1 are identical\n");
+        auto diffListAC = diffPairs(contents, { { 0, 2 } }, lineEquivalences)[0];
+        lineEquivalences.ids(1) = lineEquivalences.ids(0);
+        return { unchangedDiffList(contents[0]), diffListAC, diffListAC };
+    }
+    else if(AEqC)
+    {
+        progress("Files 0 and 2 are identical\n");
+        auto diffListAB = diffPairs(contents, { { 0, 1 } }, lineEquivalences)[0];
+        lineEquivalences.ids(2) = lineEquivalences.ids(0);
+        return { diffListAB, unchangedDiffList(contents[0]), mirroredDiffList(diffListAB) };
+    }
+    else if(BEqC)
+    {
+        progress("Files 1 and 2 are identical\n");
+        auto diffListAB = diffPairs(contents, { { 0, 1 } }, lineEquivalences)[0];
+        lineEquivalences.ids(2) = lineEquivalences.ids(1);
+        return { diffListAB, diffListAB, unchangedDiffList(contents[1]) };
+    }
+
+    return diffPairs(contents, { { 0, 1 }, { 0, 2 }, { 1, 2 } }, lineEquivalences);
+}
+
+/**
+ * Returns the pool that generateDiff3Table diffs on, with a worker for each
+ * pair of files and one for building the table. Its threads live as long as
+ * the program, so gnudiff's working memory on each of them is reused by
+ * every diff until releaseDiffMemory is called.
+ */
+static WorkerPool& diffPool()
+{
+    static WorkerPool pool(3);
+    return pool;
+}
+
+Diff3Table generateDiff3Table(const std::vector<ILineProvider*>& lineProviders,
+                              LineEquivalences& lineEquivalences)
+{
+    auto contents = getContents(lineProviders);
+
+    /* With identical files there is at most one diff to do, so there is
+     * nothing to overlap it with */
+    if(contents[0] == contents[1] || contents[0] == contents[2] || contents[1] == contents[2])
+    {
+        auto diffLists = generateDiffLists(lineProviders, lineEquivalences);
+        return calcTrimmedDiff3LineList(diffLists[0], diffLists[1], diffLists[2], lineEquivalences);
+    }
+
+    std::vector<std::pair<int, int>> comparisons = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+    auto files = filesToDiff(comparisons);
+    auto ends = findCommonEnds(contents, files);
+    progress("Skipping %d identical lines at the start and %d at the end\n", ends.prefixLines, ends.suffixLines);
+
+    lin equivMax;
+    DiscardMarks discardMarks;
+    createLineEquivalenceLists(contents, files, ends, lineEquivalences, &equivMax, &discardMarks);
+
+    /* Each pair is diffed by a worker of its own, because a diff that waits
+     * for room in its queue must not keep the others from running. The
+     * last task builds the table in parts on the shared worker pool from
+     * every stretch of diffs that ends at a sync point, while the diffs
+     * continue. */
+    for(auto [first, second]: comparisons)
+    {
+        progress("Diffing pair of files %d vs %d\n", first, second);
+    }
+
+    std::array<DiffQueue, 3> queues;
+    Diff3Table diff3Table;
+    diffPool().run(comparisons.size() + 1, [&](size_t task, unsigned)
+    {
+        if(task == comparisons.size())
+        {
+            diff3Table = calcTrimmedDiff3LineList(queues[0], queues[1], queues[2], lineEquivalences);
+            return;
+        }
+
+        auto [first, second] = comparisons[task];
+        DiffQueue& queue = queues[task];
+        diffPair(lineEquivalences.ids(first), lineEquivalences.ids(second), equivMax, ends,
+                 discardMarks[first][second], discardMarks[second][first],
+                 [&queue](const Diff& d) { queue.push(d); });
+        queue.close();
+    });
+
+    return diff3Table;
+}
+
+void releaseDiffMemory()
+{
+    /* Each worker must release the memory of its own thread, so every task
+     * waits until all of them have been taken to make sure no worker takes
+     * two */
+    auto& pool = diffPool();
+    std::mutex mutex;
+    std::condition_variable allTaken;
+    unsigned nrOfTasksTaken = 0;
+    pool.run(pool.concurrency(), [&](size_t, unsigned)
+    {
+        arena_release();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if(++nrOfTasksTaken == pool.concurrency())
+        {
+            allTaken.notify_all();
+        }
+        allTaken.wait(lock, [&] { return nrOfTasksTaken == pool.concurrency(); });
+    });
+}
+
+int findTrivialMergeResult(const std::vector<ILineProvider*>& lineProviders)
+{
+    auto contents = getContents(lineProviders);
+
+    /* A is the common ancestor of B and C */
+    if(contents[0] == contents[1] || contents[1] == contents[2])
+    {
+        return 2;
+    }
+    else if(contents[0] == contents[2])
+    {
+        return 1;
+    }
+    return -1;
+}
+
 void verifyDiffList(DiffList& diffList, int size1, int size2)
 {
     int l1 = 0;
@@ -205,4 +626,3 @@ void verifyDiffList(DiffList& diffList, int size1, int size2)
     assert(l1 == size1);
     assert(l2 == size2);
 }
-
@@ -25,11 +25,76 @@
  */
 #pragma once
 
+#include <string_view>
+#include <vector>
+
 #include "common.h"
+#include "diff3table.h"
 #include "ilineprovider.h"
+#include "lineequivalences.h"
 
 const uint MAX_NR_OF_FILES = 3;
 
-std::vector<DiffList> generateDiffLists(const std::vector<ILineProvider *>& lineProviders);
+/**
+ * The lines at the start and at the end that are the same in all input files.
+ * These lines can only ever be equal, so they are not diffed and are only
+ * hashed in one of the files.
+ */
+struct CommonEnds
+{
+    size_t prefixBytes = 0;
+    size_t suffixBytes = 0;
+    int prefixLines = 0;
+    int suffixLines = 0;
+};
+
+/**
+ * Finds the common ends of the specified files. Both ends consist of
+ * complete lines and they do not overlap in any of the files.
+ */
+CommonEnds findCommonEnds(const std::vector<std::string_view>& contents, const std::vector<int>& files);
+
+/**
+ * Diffs each pair of input files. The IDs that were used to compare the lines
+ * are stored in lineEquivalences, for comparing lines after the diff.
+ */
+std::vector<DiffList> generateDiffLists(const std::vector<ILineProvider *>& lineProviders,
+                                        LineEquivalences& lineEquivalences);
+
+/**
+ * Diffs each pair of input files and aligns the lines of all three in a
+ * trimmed diff3 table. The pairs are diffed concurrently and their diffs
+ * are streamed into the table as they are found, so the complete diff lists
+ * are never stored. Stretches of the diffs are aligned in parts on the
+ * shared worker pool. The IDs that were used to compare the lines are
+ * stored in lineEquivalences.
+ *
+ * The pairs are diffed on threads that are kept for later calls, together
+ * with gnudiff's working memory on them.
+ */
+Diff3Table generateDiff3Table(const std::vector<ILineProvider *>& lineProviders,
+                              LineEquivalences& lineEquivalences);
+
+/**
+ * Releases gnudiff's working memory on the calling thread and on the threads
+ * that generateDiff3Table diffs on. Call it when no more diffs will be done.
+ */
+void releaseDiffMemory();
+
+/**
+ * Checks if the merge result can be determined without diffing, which is the
+ * case when at least two of the input files are identical.
+ *
+ * Returns: the index of the input file that is the merge result or -1 if the
+ *          merge is not trivial.
+ */
+int findTrivialMergeResult(const std::vector<ILineProvider *>& lineProviders);
+
+/**
+ * Enables or disables the progress messages that the functions above print
+ * to stdout. They are enabled by default.
+ */
+void setProgressOutput(bool enabled);
+
 void verifyDiffList(DiffList& diffList, int size1, int size2);
 
@@ -0,0 +1,105 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cassert>
+#include <utility>
+
+#include "diffsource.h"
+
+DiffListSource::DiffListSource(const DiffList& diffList):
+    m_diffList(diffList)
+{
+}
+
+bool DiffListSource::next(Diff& d)
+{
+    if(m_index == m_diffList.size())
+    {
+        return false;
+    }
+    d = m_diffList[m_index++];
+    return true;
+}
+
+DiffQueue::DiffQueue(size_t batchSize, size_t maxBatches):
+    m_batchSize(batchSize),
+    m_maxBatches(maxBatches)
+{
+    assert(batchSize > 0);
+    assert(maxBatches > 0);
+    m_producerBatch.reserve(m_batchSize);
+}
+
+void DiffQueue::push(const Diff& d)
+{
+    m_producerBatch.push_back(d);
+    if(m_producerBatch.size() == m_batchSize)
+    {
+        pushBatch();
+    }
+}
+
+void DiffQueue::close()
+{
+    if(!m_producerBatch.empty())
+    {
+        pushBatch();
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    m_notEmpty.notify_one();
+}
+
+void DiffQueue::pushBatch()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notFull.wait(lock, [this] { return m_batches.size() < m_maxBatches; });
+    m_batches.push_back(std::move(m_producerBatch));
+    m_notEmpty.notify_one();
+    lock.unlock();
+
+    m_producerBatch = std::vector<Diff>();
+    m_producerBatch.reserve(m_batchSize);
+}
+
+bool DiffQueue::next(Diff& d)
+{
+    if(m_consumerIndex == m_consumerBatch.size())
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_batches.empty() || m_closed; });
+        if(m_batches.empty())
+        {
+            return false;
+        }
+        m_consumerBatch = std::move(m_batches.front());
+        m_batches.pop_front();
+        m_notFull.notify_one();
+        m_consumerIndex = 0;
+    }
+    d = m_consumerBatch[m_consumerIndex++];
+    return true;
+}
@@ -0,0 +1,116 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * IDiffSource provides the diffs of a pair of files one at a time and in
+ * order, so they can be processed before all of them are known.
+ */
+class IDiffSource
+{
+public:
+    virtual ~IDiffSource() = default;
+
+    /**
+     * Stores the next diff in d. Returns false if there are no more diffs.
+     */
+    virtual bool next(Diff& d) = 0;
+};
+
+/**
+ * Provides the diffs of a diff list that is already complete.
+ */
+class DiffListSource: public IDiffSource
+{
+public:
+    explicit DiffListSource(const DiffList& diffList);
+
+    bool next(Diff& d) override;
+
+private:
+    const DiffList& m_diffList;
+    size_t m_index = 0;
+};
+
+/**
+ * Passes diffs from a thread that produces them to a thread that consumes
+ * them.
+ *
+ * Diffs are handed over in batches to keep the locking overhead low. The
+ * number of batches that can be waiting is limited, so a producer that is
+ * ahead of the consumer waits instead of building up a complete diff list.
+ */
+class DiffQueue: public IDiffSource
+{
+public:
+    explicit DiffQueue(size_t batchSize = 1024, size_t maxBatches = 16);
+
+    DiffQueue(const DiffQueue&) = delete;
+    DiffQueue& operator=(const DiffQueue&) = delete;
+
+    /**
+     * Adds a diff. Blocks while the queue is full.
+     */
+    void push(const Diff& d);
+
+    /**
+     * Marks the end of the diffs, after which the consumer is given the
+     * ones that are still buffered.
+     */
+    void close();
+
+    /**
+     * Blocks until a diff is available or the queue is closed.
+     */
+    bool next(Diff& d) override;
+
+private:
+    void pushBatch();
+
+    const size_t m_batchSize;
+    const size_t m_maxBatches;
+
+    /** Only used by the producer */
+    std::vector<Diff> m_producerBatch;
+
+    /** Only used by the consumer */
+    std::vector<Diff> m_consumerBatch;
+    size_t m_consumerIndex = 0;
+
+    /** Protects the members below */
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<std::vector<Diff>> m_batches;
+    bool m_closed = false;
+};
@@ -0,0 +1,114 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cassert>
+#include <utility>
+
+#include "fenwicktree.h"
+
+FenwickTree::FenwickTree(const std::vector<int>& counts):
+    m_counts(counts)
+{
+    std::vector<int> tree(counts.size() + 1, 0);
+    for(size_t i = 1; i < tree.size(); i++)
+    {
+        assert(counts[i - 1] >= 0);
+        tree[i] += counts[i - 1];
+        size_t parent = i + (i & -i);
+        if(parent < tree.size())
+        {
+            tree[parent] += tree[i];
+        }
+    }
+    m_tree = ChunkedVector<int>(std::move(tree));
+
+    m_highestStep = 1;
+    while(m_highestStep * 2 <= counts.size())
+    {
+        m_highestStep *= 2;
+    }
+}
+
+size_t FenwickTree::size() const
+{
+    return m_counts.size();
+}
+
+int FenwickTree::get(size_t index) const
+{
+    assert(index < m_counts.size());
+    return m_counts[index];
+}
+
+void FenwickTree::set(size_t index, int count)
+{
+    assert(index < m_counts.size());
+    assert(count >= 0);
+
+    int delta = count - m_counts[index];
+    m_counts.modify(index) = count;
+    for(size_t i = index + 1; i < m_tree.size(); i += (i & -i))
+    {
+        m_tree.modify(i) += delta;
+    }
+}
+
+int FenwickTree::prefixSum(size_t index) const
+{
+    assert(index <= m_counts.size());
+
+    int sum = 0;
+    for(size_t i = index; i > 0; i -= (i & -i))
+    {
+        sum += m_tree[i];
+    }
+    return sum;
+}
+
+int FenwickTree::total() const
+{
+    return prefixSum(m_counts.size());
+}
+
+size_t FenwickTree::find(int position, int& offset) const
+{
+    assert(position >= 0);
+
+    /* Descend to the largest number of elements whose counts add up to no
+     * more than position; the element after those contains it */
+    size_t index = 0;
+    for(size_t step = m_highestStep; step > 0; step /= 2)
+    {
+        if(index + step < m_tree.size() && m_tree[index + step] <= position)
+        {
+            index += step;
+            position -= m_tree[index];
+        }
+    }
+
+    offset = position;
+    return index;
+}
@@ -0,0 +1,81 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "chunkedvector.h"
+
+/**
+ * A Fenwick tree (binary indexed tree) over a sequence of non-negative
+ * counts.
+ *
+ * It provides the sum of the counts before any element, finds the element
+ * that contains a position in the concatenation of all elements and changes
+ * the count of a single element, each in O(log n).
+ *
+ * Copies share the counts, so copying takes O(n / ChunkedVector::CHUNK_SIZE).
+ */
+class FenwickTree
+{
+public:
+    FenwickTree() = default;
+
+    /**
+     * Builds the tree in O(n).
+     */
+    explicit FenwickTree(const std::vector<int>& counts);
+
+    size_t size() const;
+    int get(size_t index) const;
+    void set(size_t index, int count);
+
+    /**
+     * Returns the sum of the counts of the elements before index.
+     */
+    int prefixSum(size_t index) const;
+
+    int total() const;
+
+    /**
+     * Returns the index of the element that contains the specified position
+     * and stores the position relative to the start of that element in
+     * offset. Elements with a count of 0 contain no positions. Returns size()
+     * if the position is not before total().
+     */
+    size_t find(int position, int& offset) const;
+
+private:
+    ChunkedVector<int> m_counts;
+
+    /** Element i holds the sum of the counts of the i & -i elements up to i,
+     *  counting from 1 */
+    ChunkedVector<int> m_tree;
+
+    /** The highest power of two that is not larger than the size */
+    size_t m_highestStep = 0;
+};
@@ -0,0 +1,185 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+
+#include "diff.h"
+#include "finediffcache.h"
+
+FineDiffCache::FineDiffCache(const Diff3Table& diff3Table,
+                             ILineProvider& lpA,
+                             ILineProvider& lpB,
+                             ILineProvider& lpC,
+                             FineDiffGranularity granularity,
+                             size_t capacity,
+                             int prefetchDistance,
+                             const LineEquivalences *lineEquivalences):
+    m_diff3Table(diff3Table),
+    m_lpA(lpA),
+    m_lpB(lpB),
+    m_lpC(lpC),
+    m_granularity(granularity),
+    m_capacity(std::max<size_t>(capacity, 1)),
+    m_prefetchDistance(prefetchDistance),
+    m_lineEquivalences(lineEquivalences),
+    m_prefetchThread(&FineDiffCache::prefetchLoop, this)
+{
+}
+
+FineDiffCache::~FineDiffCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_prefetchRequested.notify_one();
+    m_prefetchThread.join();
+}
+
+StyleList FineDiffCache::getStyle(int row, int i)
+{
+    assert(row >= 0 && static_cast<size_t>(row) < m_diff3Table.size());
+    assert(i >= 0 && i < 3);
+
+    /* Rows in which all lines are equal have no style */
+    if(!needsFineDiff(row))
+    {
+        return StyleList();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if(auto styles = find(row))
+        {
+            return (*styles)[i];
+        }
+    }
+
+    /* Calculate the row without holding the lock, so the background thread
+     * can continue with other rows in the meantime */
+    auto styles = calculate(row);
+    StyleList style = styles[i];
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        insert(row, std::move(styles));
+    }
+    prefetch(row - m_prefetchDistance, row + m_prefetchDistance);
+
+    return style;
+}
+
+void FineDiffCache::prefetch(int firstRow, int lastRow)
+{
+    firstRow = std::max(firstRow, 0);
+    lastRow = std::min(lastRow, static_cast<int>(m_diff3Table.size()) - 1);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_prefetchFirst = firstRow;
+        m_prefetchLast = lastRow;
+    }
+    m_prefetchRequested.notify_one();
+}
+
+size_t FineDiffCache::size()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+bool FineDiffCache::needsFineDiff(int row) const
+{
+    auto d3l = m_diff3Table.get(row);
+    return !(d3l.bAEqB && d3l.bAEqC && d3l.bBEqC);
+}
+
+FineDiffCache::Styles FineDiffCache::calculate(int row)
+{
+    FineDiffBuffers buffers;
+    return determineFineDiffStylePerLine(m_diff3Table.get(row), m_lpA, m_lpB, m_lpC, buffers, m_granularity,
+                                         m_lineEquivalences);
+}
+
+const FineDiffCache::Styles* FineDiffCache::find(int row)
+{
+    auto it = m_index.find(row);
+    if(it == m_index.end())
+    {
+        return nullptr;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &it->second->second;
+}
+
+const FineDiffCache::Styles& FineDiffCache::insert(int row, Styles styles)
+{
+    /* Another thread may have calculated the same row in the meantime */
+    if(auto existing = find(row))
+    {
+        return *existing;
+    }
+
+    m_lru.emplace_front(row, std::move(styles));
+    m_index[row] = m_lru.begin();
+
+    if(m_lru.size() > m_capacity)
+    {
+        m_index.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+    return m_lru.front().second;
+}
+
+void FineDiffCache::prefetchLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_prefetchRequested.wait(lock, [this] { return m_stop || m_prefetchFirst <= m_prefetchLast; });
+        if(m_stop)
+        {
+            return;
+        }
+
+        int row = m_prefetchFirst++;
+        if(!needsFineDiff(row))
+        {
+            m_prefetchFirst = static_cast<int>(m_diff3Table.endOfEqualRun(row));
+            continue;
+        }
+        if(m_index.count(row) != 0)
+        {
+            continue;
+        }
+
+        lock.unlock();
+        auto styles = calculate(row);
+        lock.lock();
+
+        insert(row, std::move(styles));
+    }
+}
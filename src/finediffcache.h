@@ -0,0 +1,119 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include "common.h"
+#include "diff.h"
+#include "diff3table.h"
+#include "ilineprovider.h"
+#include "lineequivalences.h"
+
+/**
+ * Determines the fine diff styles of the rows of a Diff3Table when they are
+ * first asked for instead of for all rows up front, so the time until the
+ * content can be shown does not depend on the cost of the fine diff.
+ *
+ * The styles of the most recently used rows are kept in a cache of limited
+ * size. Every row that has to be calculated because it was not in the cache
+ * also queues the rows around it, which a background thread calculates in
+ * advance of them being scrolled into view.
+ *
+ * The background thread reads lines from the line providers, so all of their
+ * lines must have been indexed (see ILineProvider::getLastLineNumber) before
+ * the cache is created. Lines with the same ID in lineEquivalences, if it is
+ * specified, are not compared.
+ */
+class FineDiffCache
+{
+public:
+    FineDiffCache(const Diff3Table& diff3Table,
+                  ILineProvider& lpA,
+                  ILineProvider& lpB,
+                  ILineProvider& lpC,
+                  FineDiffGranularity granularity = FineDiffGranularity::CHARACTER,
+                  size_t capacity = 4096,
+                  int prefetchDistance = 100,
+                  const LineEquivalences *lineEquivalences = nullptr);
+    ~FineDiffCache();
+
+    FineDiffCache(const FineDiffCache&) = delete;
+    FineDiffCache& operator=(const FineDiffCache&) = delete;
+
+    /**
+     * Returns the style of line i in the specified row, calculating it first
+     * if it is not in the cache.
+     */
+    StyleList getStyle(int row, int i);
+
+    /**
+     * Queues the specified rows to be calculated by the background thread.
+     * Rows that are already in the cache are skipped.
+     */
+    void prefetch(int firstRow, int lastRow);
+
+    size_t size();
+
+private:
+    using Styles = std::array<StyleList, 3>;
+    using LruList = std::list<std::pair<int, Styles>>;
+
+    bool needsFineDiff(int row) const;
+    Styles calculate(int row);
+    const Styles* find(int row);
+    const Styles& insert(int row, Styles styles);
+    void prefetchLoop();
+
+    const Diff3Table& m_diff3Table;
+    ILineProvider& m_lpA;
+    ILineProvider& m_lpB;
+    ILineProvider& m_lpC;
+    FineDiffGranularity m_granularity;
+    size_t m_capacity;
+    int m_prefetchDistance;
+    const LineEquivalences *m_lineEquivalences;
+
+    /** Protects all members below */
+    std::mutex m_mutex;
+
+    /** The cached rows, most recently used first */
+    LruList m_lru;
+    std::unordered_map<int, LruList::iterator> m_index;
+
+    /** The rows the background thread has been asked to calculate */
+    int m_prefetchFirst = 0;
+    int m_prefetchLast = -1;
+
+    bool m_stop = false;
+    std::condition_variable m_prefetchRequested;
+    std::thread m_prefetchThread;
+};
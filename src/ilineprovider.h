@@ -43,5 +43,18 @@ public:
     virtual std::vector<std::string_view> get(size_t line) = 0;
     //virtual std::vector<std::string_view> get(size_t firstLine, size_t lastLine) = 0;
     virtual size_t getLastLineNumber() = 0;
+
+    /**
+     * Returns all data the lines are taken from, so it can be compared in
+     * bulk without splitting it into lines first. The lines are views into
+     * it.
+     */
+    virtual std::string_view getContent() = 0;
+
+    /**
+     * Returns a file descriptor from which the content can be read at the
+     * same offsets, or -1 if there is none.
+     */
+    virtual int getFileDescriptor() = 0;
 };
 
@@ -0,0 +1,163 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <cassert>
+
+#include "indexset.h"
+
+static const size_t BITS_PER_WORD = 64;
+
+IndexSet::IndexSet(size_t size):
+    m_size(size)
+{
+    size_t bits = size;
+    do
+    {
+        size_t words = std::max<size_t>(1, (bits + BITS_PER_WORD - 1) / BITS_PER_WORD);
+        m_levels.emplace_back(words, 0);
+        bits = words;
+    }
+    while(bits > 1);
+}
+
+size_t IndexSet::size() const
+{
+    return m_size;
+}
+
+size_t IndexSet::count() const
+{
+    return m_count;
+}
+
+bool IndexSet::contains(size_t index) const
+{
+    assert(index < m_size);
+    return (m_levels[0][index / BITS_PER_WORD] >> (index % BITS_PER_WORD)) & 1;
+}
+
+void IndexSet::set(size_t index, bool isMember)
+{
+    assert(index < m_size);
+    if(contains(index) == isMember)
+    {
+        return;
+    }
+    m_count += isMember ? 1 : -1;
+
+    /* A word only changes the level above when it becomes empty or stops
+     * being empty */
+    for(auto& words: m_levels)
+    {
+        auto& word = words.modify(index / BITS_PER_WORD);
+        bool wasEmpty = (word == 0);
+        word ^= uint64_t(1) << (index % BITS_PER_WORD);
+        if(wasEmpty == (word == 0))
+        {
+            break;
+        }
+        index /= BITS_PER_WORD;
+    }
+}
+
+size_t IndexSet::findFrom(size_t index) const
+{
+    if(index >= m_size)
+    {
+        return npos;
+    }
+
+    /* Go up until a word has a bit at or after the position... */
+    size_t level = 0;
+    size_t position = index;
+    while(true)
+    {
+        auto& words = m_levels[level];
+        size_t word = position / BITS_PER_WORD;
+        if(word >= words.size())
+        {
+            return npos;
+        }
+        uint64_t bits = words[word] & (~uint64_t(0) << (position % BITS_PER_WORD));
+        if(bits != 0)
+        {
+            position = word * BITS_PER_WORD + __builtin_ctzll(bits);
+            break;
+        }
+        if(level + 1 == m_levels.size())
+        {
+            return npos;
+        }
+        level++;
+        position = word + 1;
+    }
+
+    /* ...and then down to the first member below it */
+    while(level > 0)
+    {
+        level--;
+        position = position * BITS_PER_WORD + __builtin_ctzll(m_levels[level][position]);
+    }
+    return position;
+}
+
+size_t IndexSet::findUpTo(size_t index) const
+{
+    if(m_size == 0)
+    {
+        return npos;
+    }
+
+    size_t level = 0;
+    size_t position = std::min(index, m_size - 1);
+    while(true)
+    {
+        auto& words = m_levels[level];
+        size_t word = position / BITS_PER_WORD;
+        size_t bit = position % BITS_PER_WORD;
+        uint64_t mask = (bit == BITS_PER_WORD - 1) ? ~uint64_t(0) : (uint64_t(2) << bit) - 1;
+        uint64_t bits = words[word] & mask;
+        if(bits != 0)
+        {
+            position = word * BITS_PER_WORD + (BITS_PER_WORD - 1 - __builtin_clzll(bits));
+            break;
+        }
+        if(word == 0)
+        {
+            return npos;
+        }
+        level++;
+        position = word - 1;
+    }
+
+    while(level > 0)
+    {
+        level--;
+        position = position * BITS_PER_WORD + (BITS_PER_WORD - 1 - __builtin_clzll(m_levels[level][position]));
+    }
+    return position;
+}
@@ -0,0 +1,77 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "chunkedvector.h"
+
+/**
+ * A set of indices below a fixed size that finds the next or previous member
+ * from any index in O(log64 n).
+ *
+ * The members are bits in 64-bit words. Every word has a bit in a level
+ * above that tells whether it has any members, up to a level of a single
+ * word, so a search skips 64 empty words at a time on the level above and
+ * 4096 on the one above that.
+ *
+ * Copies share the words, so copying takes O(n / 64 / ChunkedVector::CHUNK_SIZE).
+ */
+class IndexSet
+{
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    explicit IndexSet(size_t size = 0);
+
+    size_t size() const;
+    size_t count() const;
+
+    bool contains(size_t index) const;
+    void set(size_t index, bool isMember);
+
+    /**
+     * Returns the lowest member that is not lower than index, or npos if
+     * there is none.
+     */
+    size_t findFrom(size_t index) const;
+
+    /**
+     * Returns the highest member that is not higher than index, or npos if
+     * there is none.
+     */
+    size_t findUpTo(size_t index) const;
+
+private:
+    size_t m_size;
+    size_t m_count = 0;
+
+    /** Level 0 holds the members, level n + 1 holds a bit for every word of
+     *  level n that is not zero */
+    std::vector<ChunkedVector<uint64_t>> m_levels;
+};
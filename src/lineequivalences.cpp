@@ -0,0 +1,53 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+
+#include "lineequivalences.h"
+
+static size_t nrOfLines(LineNumberRange lines)
+{
+    return (lines.firstLine == -1) ? 0 : lines.lastLine - lines.firstLine + 1;
+}
+
+bool LineEquivalences::equal(int file1, LineNumberRange lines1, int file2, LineNumberRange lines2) const
+{
+    size_t count = nrOfLines(lines1);
+    if(count != nrOfLines(lines2))
+    {
+        return false;
+    }
+    if(count == 0)
+    {
+        return true;
+    }
+
+    assert(static_cast<size_t>(lines1.lastLine) < m_ids[file1].size());
+    assert(static_cast<size_t>(lines2.lastLine) < m_ids[file2].size());
+    auto first1 = m_ids[file1].begin() + lines1.firstLine;
+    auto first2 = m_ids[file2].begin() + lines2.firstLine;
+    return std::equal(first1, first1 + count, first2);
+}
@@ -0,0 +1,82 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "common.h"
+
+/** The same type as gnudiff's lin, so the IDs can be diffed directly */
+using LineId = ptrdiff_t;
+
+/**
+ * The equivalence IDs that were assigned to the lines of the input files for
+ * diffing them, so that once the files have been diffed lines can be compared
+ * without reading them again.
+ *
+ * Lines with the same ID are equal and lines with different IDs are
+ * different.
+ */
+class LineEquivalences
+{
+public:
+    LineEquivalences() = default;
+
+    explicit LineEquivalences(std::array<std::vector<LineId>, 3> ids):
+        m_ids(std::move(ids))
+    {
+    }
+
+    /**
+     * Returns the IDs of all lines of file i, so they can be filled in while
+     * the files are hashed.
+     */
+    std::vector<LineId>& ids(int i)
+    {
+        assert(i >= 0 && i < 3);
+        return m_ids[i];
+    }
+
+    bool equal(int file1, int line1, int file2, int line2) const
+    {
+        assert(line1 >= 0 && static_cast<size_t>(line1) < m_ids[file1].size());
+        assert(line2 >= 0 && static_cast<size_t>(line2) < m_ids[file2].size());
+        return m_ids[file1][line1] == m_ids[file2][line2];
+    }
+
+    /**
+     * Checks if two ranges of lines have the same number of lines and if
+     * those lines are equal. A range with a first line of -1 has no lines.
+     */
+    bool equal(int file1, LineNumberRange lines1, int file2, LineNumberRange lines2) const;
+
+private:
+    std::array<std::vector<LineId>, 3> m_ids;
+};
@@ -0,0 +1,76 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2014  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cstdio>
+
+#include "linenumbercontentprovider.h"
+
+LineNumberContentProvider::LineNumberContentProvider(int contentWidth, int contentHeight, Diff3Table& diff3Table, int fileIndex):
+    m_contentWidth(contentWidth),
+    m_contentHeight(contentHeight),
+    m_diff3Table(diff3Table),
+    m_fileIndex(fileIndex)
+{
+}
+
+std::optional<std::string> LineNumberContentProvider::get(int contentLine)
+{
+    assert(contentLine >= 0);
+
+    int fileLine;
+    if(contentLine >= m_contentHeight)
+    {
+        fileLine = -1;
+    }
+    else
+    {
+        fileLine = m_diff3Table.line(contentLine, m_fileIndex);
+    }
+
+    if(fileLine == -1)
+    {
+        return std::nullopt;
+    }
+
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%0*d", m_contentWidth, fileLine);
+    return std::string(buffer);
+}
+
+int LineNumberContentProvider::getContentWidth()
+{
+    return m_contentWidth;
+}
+
+int LineNumberContentProvider::getContentHeight()
+{
+    return m_contentHeight;
+}
+
+void LineNumberContentProvider::connectLineChangeObserver([[maybe_unused]] std::function<void(LineNumberRange)> observer)
+{
+    /* no need to do anything for content that doesn't change */
+}
@@ -0,0 +1,271 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "bytecompare.h"
+#include "diff.h"
+#include "longlinediff.h"
+
+/* Chunks are 256 bytes on average and never shorter than minChunkSize or
+ * longer than maxChunkSize */
+static const size_t minChunkSize = 64;
+static const size_t maxChunkSize = 2048;
+static const uint64_t boundaryMask = 0xFFull << 56;
+
+/* Stretches between aligned chunks that are longer than this are not diffed
+ * character by character */
+static const size_t maxStretchSize = 4096;
+
+/* The total number of bytes per line that is diffed character by character */
+static const size_t maxCharacterDiffBytes = 256 * 1024;
+
+static const int maxSearchLength = 500;
+
+static constexpr uint64_t splitMix64(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static constexpr std::array<uint64_t, 256> makeGearTable()
+{
+    std::array<uint64_t, 256> table{};
+    uint64_t state = 0;
+    for(auto& entry: table)
+    {
+        entry = splitMix64(state);
+    }
+    return table;
+}
+
+static constexpr std::array<uint64_t, 256> gearTable = makeGearTable();
+
+struct Chunk
+{
+    size_t offset;
+    size_t size;
+    size_t hash;
+};
+
+/**
+ * Cuts a line into chunks with a gear hash. Every byte shifts the hash one
+ * bit further, so the top bits only depend on the last 64 bytes.
+ */
+static std::vector<Chunk> cutIntoChunks(std::string_view line)
+{
+    std::vector<Chunk> chunks;
+    chunks.reserve(line.size() / 256 + 1);
+
+    size_t start = 0;
+    while(start < line.size())
+    {
+        size_t end = std::min(start + minChunkSize, line.size());
+        size_t maxEnd = std::min(start + maxChunkSize, line.size());
+        uint64_t hash = 0;
+        while(end < maxEnd)
+        {
+            hash = (hash << 1) + gearTable[static_cast<unsigned char>(line[end])];
+            end++;
+            if((hash & boundaryMask) == 0)
+            {
+                break;
+            }
+        }
+
+        chunks.push_back(Chunk{start, end - start, std::hash<std::string_view>()(line.substr(start, end - start))});
+        start = end;
+    }
+
+    return chunks;
+}
+
+/**
+ * Finds pairs of chunks that occur exactly once in both lines and returns the
+ * longest sequence of them that is in the same order in both lines.
+ */
+static std::vector<std::pair<size_t, size_t>> findAnchors(const std::vector<Chunk>& chunks1,
+                                                          const std::vector<Chunk>& chunks2)
+{
+    struct Occurrences
+    {
+        int count1 = 0;
+        int count2 = 0;
+        size_t index1 = 0;
+        size_t index2 = 0;
+    };
+
+    std::unordered_map<size_t, Occurrences> occurrences;
+    occurrences.reserve(chunks1.size() + chunks2.size());
+    for(size_t i = 0; i < chunks1.size(); i++)
+    {
+        auto& o = occurrences[chunks1[i].hash];
+        o.count1++;
+        o.index1 = i;
+    }
+    for(size_t i = 0; i < chunks2.size(); i++)
+    {
+        auto& o = occurrences[chunks2[i].hash];
+        o.count2++;
+        o.index2 = i;
+    }
+
+    /* Candidates in the order of the first line */
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for(size_t i = 0; i < chunks1.size(); i++)
+    {
+        auto& o = occurrences[chunks1[i].hash];
+        if(o.count1 == 1 && o.count2 == 1)
+        {
+            candidates.emplace_back(i, o.index2);
+        }
+    }
+
+    /* Longest increasing subsequence of the positions in the second line */
+    std::vector<size_t> tails;
+    std::vector<size_t> predecessors(candidates.size());
+    for(size_t c = 0; c < candidates.size(); c++)
+    {
+        auto it = std::lower_bound(tails.begin(), tails.end(), candidates[c].second,
+                                   [&](size_t tail, size_t index2) { return candidates[tail].second < index2; });
+        predecessors[c] = (it == tails.begin()) ? SIZE_MAX : *(it - 1);
+        if(it == tails.end())
+        {
+            tails.push_back(c);
+        }
+        else
+        {
+            *it = c;
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> anchors;
+    for(size_t c = tails.empty() ? SIZE_MAX : tails.back(); c != SIZE_MAX; c = predecessors[c])
+    {
+        anchors.push_back(candidates[c]);
+    }
+    std::reverse(anchors.begin(), anchors.end());
+    return anchors;
+}
+
+DiffList calcLongLineDiff(std::string_view line1, std::string_view line2)
+{
+    auto chunks1 = cutIntoChunks(line1);
+    auto chunks2 = cutIntoChunks(line2);
+    auto anchors = findAnchors(chunks1, chunks2);
+
+    /* The end of both lines is an anchor as well */
+    anchors.emplace_back(chunks1.size(), chunks2.size());
+
+    auto offset1 = [&](size_t i) { return (i == chunks1.size()) ? line1.size() : chunks1[i].offset; };
+    auto offset2 = [&](size_t i) { return (i == chunks2.size()) ? line2.size() : chunks2[i].offset; };
+    auto chunksEqual = [&](size_t i1, size_t i2)
+    {
+        return chunks1[i1].hash == chunks2[i2].hash &&
+               line1.substr(chunks1[i1].offset, chunks1[i1].size) == line2.substr(chunks2[i2].offset, chunks2[i2].size);
+    };
+
+    DiffListBuilder builder;
+    size_t characterDiffBytes = 0;
+    size_t i1 = 0;
+    size_t i2 = 0;
+    for(auto [anchor1, anchor2]: anchors)
+    {
+        /* Extend the equal chunks after the previous anchor and before this one */
+        size_t start1 = i1;
+        while(i1 < anchor1 && i2 < anchor2 && chunksEqual(i1, i2))
+        {
+            i1++;
+            i2++;
+        }
+        builder.addEqual(static_cast<int>(offset1(i1) - offset1(start1)));
+
+        size_t end1 = anchor1;
+        size_t end2 = anchor2;
+        while(end1 > i1 && end2 > i2 && chunksEqual(end1 - 1, end2 - 1))
+        {
+            end1--;
+            end2--;
+        }
+
+        /* Diff the stretch in between by character if it is not too large.
+         * Chunk boundaries are not where the differences are, so the equal
+         * bytes at either end of the stretch are taken out first. */
+        auto stretch1 = line1.substr(offset1(i1), offset1(end1) - offset1(i1));
+        auto stretch2 = line2.substr(offset2(i2), offset2(end2) - offset2(i2));
+        size_t prefix = commonPrefixLength(stretch1, stretch2);
+        stretch1.remove_prefix(prefix);
+        stretch2.remove_prefix(prefix);
+        size_t suffix = commonSuffixLength(stretch1, stretch2);
+        stretch1.remove_suffix(suffix);
+        stretch2.remove_suffix(suffix);
+
+        builder.addEqual(static_cast<int>(prefix));
+        size_t stretchSize = stretch1.size() + stretch2.size();
+        if(stretch1.empty() || stretch2.empty() ||
+           stretchSize > maxStretchSize ||
+           characterDiffBytes + stretchSize > maxCharacterDiffBytes)
+        {
+            builder.addDifferent(static_cast<int>(stretch1.size()), static_cast<int>(stretch2.size()));
+        }
+        else
+        {
+            characterDiffBytes += stretchSize;
+            for(auto& d: calcDiff(stretch1, stretch2, 2, maxSearchLength))
+            {
+                builder.addEqual(d.nofEquals);
+                builder.addDifferent(d.diff1, d.diff2);
+            }
+        }
+        builder.addEqual(static_cast<int>(suffix));
+
+        /* The equal chunks before the anchor and the anchor itself */
+        builder.addEqual(static_cast<int>(offset1(anchor1) - offset1(end1)));
+        if(anchor1 < chunks1.size())
+        {
+            /* Unless the hashes of different chunks happen to be the same */
+            if(chunksEqual(anchor1, anchor2))
+            {
+                builder.addEqual(static_cast<int>(chunks1[anchor1].size));
+            }
+            else
+            {
+                builder.addDifferent(static_cast<int>(chunks1[anchor1].size), static_cast<int>(chunks2[anchor2].size));
+            }
+        }
+        i1 = anchor1 + 1;
+        i2 = anchor2 + 1;
+    }
+
+    return builder.finish();
+}
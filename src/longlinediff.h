@@ -0,0 +1,51 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <string_view>
+
+#include "common.h"
+
+/**
+ * Lines of at least this many bytes are diffed by calcLongLineDiff instead of
+ * calcDiff.
+ */
+const size_t LONG_LINE_THRESHOLD = 4096;
+
+/**
+ * Calculates the character-level differences between two long lines, such
+ * as minified sources or encoded data, in time and memory that grow linearly
+ * with their length.
+ *
+ * Both lines are cut into chunks at positions that only depend on the bytes
+ * just before them, so an edit only changes the chunks around it. Chunks
+ * that occur once in both lines serve as anchors, the longest sequence of
+ * anchors that is in the same order in both lines is aligned and the equal
+ * chunks next to them are aligned as well. Only the stretches in between are
+ * diffed character by character, up to a fixed number of bytes per line;
+ * beyond that stretches are marked as different as a whole.
+ */
+DiffList calcLongLineDiff(std::string_view line1, std::string_view line2);
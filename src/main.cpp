@@ -63,12 +63,23 @@
  */
 
 #include <iostream>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include "cxxopts.hpp"
 
+#include "contentmapper.h"
+#include "diff.h"
 #include "difflistgenerator.h"
+#include "mergeresultwriter.h"
+#include "mergestate.h"
 #include "mmappedfilelineprovider.h"
+#include "resolutionjournal.h"
 
+/* Exit statuses of a batch merge. Errors exit with -1, like in interactive
+ * mode. */
+static const int EXIT_MERGED = 0;
+static const int EXIT_CONFLICTS = 1;
 
 int main(int argc, char *argv[])
 {
@@ -76,6 +87,9 @@ int main(int argc, char *argv[])
 
     std::vector<std::string> inputFileNames;
     std::string outputFileName;
+    bool batch = false;
+    /* Only the user interface uses it, which is not built yet */
+    [[maybe_unused]] FineDiffGranularity fineDiffGranularity = FineDiffGranularity::CHARACTER;
 
     try
     {
@@ -84,8 +98,14 @@ int main(int argc, char *argv[])
         options.add_options()
             ("o,output", "The output file of the merge", cxxopts::value<std::string>())
             ("infiles", "Input files", cxxopts::value<std::vector<std::string>>())
+            ("fine-diff", "Highlight differences within lines per character (char) or per word (word)",
+             cxxopts::value<std::string>()->default_value("char"))
+            ("batch", "Merge without user interaction. Differences that cannot be resolved automatically are written "
+                      "with conflict markers and make the exit status 1 instead of 0")
             ("h,help", "Print this help message and exit")
         ;
+        options.parse_positional({ "infiles" });
+        options.positional_help("<base file> <file 2> <file 3>");
 
         auto result = options.parse(argc, argv);
 
@@ -103,6 +123,18 @@ int main(int argc, char *argv[])
         }
         inputFileNames = result["infiles"].as<std::vector<std::string>>();
         outputFileName = result["output"].as<std::string>();
+        batch = result.count("batch") != 0;
+
+        auto fineDiff = result["fine-diff"].as<std::string>();
+        if(fineDiff == "word")
+        {
+            fineDiffGranularity = FineDiffGranularity::WORD;
+        }
+        else if(fineDiff != "char")
+        {
+            std::cerr << "Unknown fine diff mode '" << fineDiff << "', use char or word\n";
+            exit(-1);
+        }
     }
     catch(cxxopts::exceptions::parsing e)
     {
@@ -110,10 +142,16 @@ int main(int argc, char *argv[])
         exit(-1);
     }
 
-    std::cout << "Input file 1: " << inputFileNames[0] << "\n";
-    std::cout << "Input file 2: " << inputFileNames[1] << "\n";
-    std::cout << "Input file 3: " << inputFileNames[2] << "\n";
-    std::cout << "Output file : " << outputFileName << "\n";
+    /* A batch merge only reports through its exit status and errors */
+    setProgressOutput(!batch);
+
+    if(!batch)
+    {
+        std::cout << "Input file 1: " << inputFileNames[0] << "\n";
+        std::cout << "Input file 2: " << inputFileNames[1] << "\n";
+        std::cout << "Input file 3: " << inputFileNames[2] << "\n";
+        std::cout << "Output file : " << outputFileName << "\n";
+    }
 
     const int count = 3;
 
@@ -123,30 +161,76 @@ int main(int argc, char *argv[])
     lps[2] = std::make_unique<MmappedFileLineProvider>(inputFileNames[2]);
     std::vector<ILineProvider*> lpsVector{lps[0].get(), lps[1].get(), lps[2].get()};
 
-    auto diffLists = generateDiffLists(lpsVector);
-#if 0
-    auto diffList12 = diffLists[0];
-    auto diffList13 = diffLists[1];
-    auto diffList23 = diffLists[2];
+    /* If the merge result is one of the input files, there is nothing to
+     * resolve and no need to diff at all. */
+    int trivialMergeResult = findTrivialMergeResult(lpsVector);
+    if(trivialMergeResult != -1)
+    {
+        if(!batch)
+        {
+            std::cout << "Merge is trivial, writing input file " << trivialMergeResult + 1 << " to the output file\n";
+        }
+        try
+        {
+            saveInputFile(outputFileName, lpsVector, trivialMergeResult);
+        }
+        catch(std::runtime_error& e)
+        {
+            std::cerr << "Failed to write " << outputFileName << ": " << e.what() << "\n";
+            exit(-1);
+        }
+        exit(EXIT_MERGED);
+    }
 
-    writefln("diff.calcDiff3LineList");
-    auto diff3LineList = diff.calcDiff3LineList(diffList12, diffList13, diffList23);
+    Diff3Table diff3LineList;
+    LineEquivalences lineEquivalences;
+    ContentMapper contentMapper;
 
-    /* Now that we no longer need them, clear the difflists to free up memory */
-    diffList12.clear();
-    diffList13.clear();
-    diffList23.clear();
+    /* An interactive merge of input files that have not changed resumes
+     * where it was left off instead of diffing them again */
+    std::string stateFileName = outputFileName + ".tdiff3-state";
+    std::string journalFileName = outputFileName + ".tdiff3-journal";
+    uint64_t stateId = 0;
+    bool resumed = !batch && loadMergeState(stateFileName, inputFileNames, diff3LineList, contentMapper, stateId);
+    if(resumed)
+    {
+        auto nrOfActions = ResolutionJournal::replay(journalFileName, stateId, contentMapper);
+        std::cout << "Resuming the merge after " << nrOfActions << " earlier actions\n";
+    }
+    else
+    {
+        diff3LineList = generateDiff3Table(lpsVector, lineEquivalences);
 
-    writefln("validateDiff3LineListForN");
-    validateDiff3LineListForN(diff3LineList, 0, 0, lps[0].getLastLineNumber());
-    validateDiff3LineListForN(diff3LineList, 1, 0, lps[1].getLastLineNumber());
-    validateDiff3LineListForN(diff3LineList, 2, 0, lps[2].getLastLineNumber());
+        /* No more diffs will be done, so release gnudiff's working memory */
+        releaseDiffMemory();
 
-    writefln("trimDiff3LineList");
-    trimDiff3LineList(diff3LineList, lps[0], lps[1], lps[2]);
-    //printDiff3List(diff3LineList, lps[0], lps[1], lps[2]);
+        contentMapper.determineMergeResultSections(diff3LineList);
+        contentMapper.automaticallyResolveDifferences(diff3LineList, &lineEquivalences);
+    }
 
-    determineFineDiffStyle(diff3LineList, lps[0], lps[1], lps[2]);
+    if(batch)
+    {
+        /* Only what the merge result depends on is calculated, so no fine
+         * diffs and no content widths */
+        size_t conflicts = 0;
+        try
+        {
+            conflicts = saveMergeResult(outputFileName, contentMapper, lpsVector, inputFileNames);
+        }
+        catch(std::runtime_error& e)
+        {
+            std::cerr << "Failed to write " << outputFileName << ": " << e.what() << "\n";
+            exit(-1);
+        }
+        exit(conflicts == 0 ? EXIT_MERGED : EXIT_CONFLICTS);
+    }
+
+    std::cout << "validateDiff3LineListForN\n";
+    validateDiff3LineListForN(diff3LineList, 0, 0, lps[0]->getLastLineNumber());
+    validateDiff3LineListForN(diff3LineList, 1, 0, lps[1]->getLastLineNumber());
+    validateDiff3LineListForN(diff3LineList, 2, 0, lps[2]->getLastLineNumber());
+
+#if 0
     //printDiff3List(diff3LineList, lps[0], lps[1], lps[2]);
 
     writefln("Cleaning up");
@@ -159,25 +243,49 @@ int main(int argc, char *argv[])
     int lineNumberWidth = to!int(trunc(log10(nrOfLines))) + 1;
     writefln("nr of lines in d3la is %d\n", nrOfLines);
 
+    /* Fine diff styles are only calculated for the lines that are shown. A
+     * resumed merge has no line equivalences, so it compares the text. */
+    auto fineDiffCache = new FineDiffCache(d3la, lps[0], lps[1], lps[2], fineDiffGranularity, 4096, 100,
+                                           resumed ? nullptr : &lineEquivalences);
+
     IFormattedContentProvider[3] cps;
-    cps[0] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 0, lps[0]);
-    cps[1] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 1, lps[1]);
-    cps[2] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 2, lps[2]);
+    cps[0] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 0, lps[0], fineDiffCache);
+    cps[1] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 1, lps[1], fineDiffCache);
+    cps[2] = new Diff3ContentProvider(nrOfColumns, nrOfLines, d3la, 2, lps[2], fineDiffCache);
 
     IContentProvider[3] lnps;
     lnps[0] = new LineNumberContentProvider(lineNumberWidth, nrOfLines, d3la, 0);
     lnps[1] = new LineNumberContentProvider(lineNumberWidth, nrOfLines, d3la, 1);
     lnps[2] = new LineNumberContentProvider(lineNumberWidth, nrOfLines, d3la, 2);
 
-    auto contentMapper = new ContentMapper();
-    contentMapper.determineMergeResultSections(d3la);
-    contentMapper.automaticallyResolveDifferences(d3la);
-
     auto mergeResultContentProvider = new MergeResultContentProvider(contentMapper, lps[0], lps[1], lps[2], outputFileName);
 
+    /* Only a session that can be interrupted stores what is needed to
+     * resume it */
+    std::unique_ptr<ResolutionJournal> journal;
+    try
+    {
+        if(!resumed)
+        {
+            stateId = saveMergeState(stateFileName, inputFileNames, diff3LineList, contentMapper);
+        }
+        journal = std::make_unique<ResolutionJournal>(journalFileName, stateId);
+        contentMapper.setActionListener(journal.get());
+    }
+    catch(std::runtime_error& e)
+    {
+        std::cerr << "The merge cannot be resumed if tdiff3 stops: " << e.what() << "\n";
+    }
+
     auto ui = new Ui(cps, lnps, mergeResultContentProvider, contentMapper);
     ui.handleResize();
     ui.mainLoop();
+
+    /* The user quit normally, so there is nothing left to resume */
+    contentMapper.setActionListener(nullptr);
+    journal.reset();
+    remove(journalFileName.c_str());
+    remove(stateFileName.c_str());
 #endif
 }
 
@@ -0,0 +1,748 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mergeresultwriter.h"
+
+namespace
+{
+
+/**
+ * Passes fragments on, after joining those that are adjacent in the same
+ * input file.
+ */
+class FragmentCollector
+{
+public:
+    FragmentCollector(const std::vector<ILineProvider*>& lineProviders,
+                      const std::function<void(const OutputFragment&)>& fragmentHandler):
+        m_lineProviders(lineProviders),
+        m_fragmentHandler(fragmentHandler)
+    {
+        for(auto lineProvider: lineProviders)
+        {
+            m_contents.push_back(lineProvider->getContent());
+        }
+    }
+
+    void writeText(std::string_view text)
+    {
+        if(!text.empty())
+        {
+            add(OutputFragment{ -1, 0, text });
+        }
+    }
+
+    void writeInputLines(LineSource lineSource, LineNumberRange lineNumbers)
+    {
+        if(lineNumbers.firstLine == -1)
+        {
+            return;
+        }
+
+        auto input = static_cast<int>(lineSource);
+        auto first = m_lineProviders[input]->get(lineNumbers.firstLine);
+        auto last = m_lineProviders[input]->get(lineNumbers.lastLine);
+        assert(!first.empty() && !last.empty());
+
+        const char *start = first.front().data();
+        const char *end = last.back().data() + last.back().size();
+        add(OutputFragment{ input,
+                            static_cast<size_t>(start - m_contents[input].data()),
+                            std::string_view(start, end - start) });
+    }
+
+    /**
+     * Markers start on a line of their own, even after a last line of a file
+     * that has no line ending.
+     */
+    void writeMarker(std::string_view marker, const std::string& label)
+    {
+        if(!m_endsWithNewline)
+        {
+            writeText("\n");
+        }
+        writeText(marker);
+        if(!label.empty())
+        {
+            writeText(" ");
+            writeText(label);
+        }
+        writeText("\n");
+    }
+
+    void finish()
+    {
+        if(!m_pending.text.empty())
+        {
+            m_fragmentHandler(m_pending);
+            m_pending.text = std::string_view();
+        }
+    }
+
+private:
+    void add(const OutputFragment& fragment)
+    {
+        m_endsWithNewline = (fragment.text.back() == '\n');
+
+        if(fragment.input != -1 &&
+           fragment.input == m_pending.input &&
+           m_pending.offset + m_pending.text.size() == fragment.offset)
+        {
+            m_pending.text = std::string_view(m_pending.text.data(), m_pending.text.size() + fragment.text.size());
+            return;
+        }
+
+        finish();
+        m_pending = fragment;
+    }
+
+    const std::vector<ILineProvider*>& m_lineProviders;
+    const std::function<void(const OutputFragment&)>& m_fragmentHandler;
+    std::vector<std::string_view> m_contents;
+    OutputFragment m_pending{ -1, 0, std::string_view() };
+    bool m_endsWithNewline = true;
+};
+
+void writeEditedSection(FragmentCollector& collector, const MergeResultSection& section)
+{
+    for(int i = 0; i < section.getOutputSize(); i++)
+    {
+        auto lineInfo = section.getLineInfo(i);
+
+        /* Lines without a source only exist to show in the merge result
+         * pane that a section is empty */
+        if(lineInfo.lineNumber == -1)
+        {
+            continue;
+        }
+
+        if(lineInfo.state == LineState::EDITED)
+        {
+            collector.writeText(section.getEditedLine(lineInfo.lineNumber));
+        }
+        else
+        {
+            assert(lineInfo.state == LineState::ORIGINAL);
+            collector.writeInputLines(lineInfo.source, LineNumberRange(lineInfo.lineNumber, lineInfo.lineNumber));
+        }
+    }
+}
+
+/**
+ * The lines of an unedited section come from its sources in runs that end
+ * at the last line of a source, so they are written a run at a time.
+ */
+void writeUneditedSection(FragmentCollector& collector, const MergeResultSection& section)
+{
+    int i = 0;
+    while(i < section.getOutputSize())
+    {
+        auto lineInfo = section.getLineInfo(i);
+        assert(lineInfo.state == LineState::ORIGINAL);
+
+        if(lineInfo.lineNumber == -1)
+        {
+            i++;
+            continue;
+        }
+
+        auto lineNumbers = section.getLineNumberRange(lineInfo.source);
+        collector.writeInputLines(lineInfo.source, LineNumberRange(lineInfo.lineNumber, lineNumbers.lastLine));
+        i += lineNumbers.lastLine - lineInfo.lineNumber + 1;
+    }
+}
+
+class StreamWriter
+{
+public:
+    explicit StreamWriter(std::ostream& output):
+        m_output(output)
+    {
+    }
+
+    void operator()(const OutputFragment& fragment)
+    {
+        m_output.write(fragment.text.data(), fragment.text.size());
+    }
+
+private:
+    std::ostream& m_output;
+};
+
+}
+
+size_t forEachOutputFragment(const ContentMapper& contentMapper,
+                             const std::vector<ILineProvider*>& lineProviders,
+                             const std::vector<std::string>& labels,
+                             const std::function<void(const OutputFragment&)>& fragmentHandler)
+{
+    assert(lineProviders.size() == 3);
+    assert(labels.size() == 3);
+
+    FragmentCollector collector(lineProviders, fragmentHandler);
+    size_t conflicts = 0;
+
+    for(size_t sectionIndex = 0; sectionIndex < contentMapper.getNumberOfSections(); sectionIndex++)
+    {
+        auto& section = contentMapper.getSection(sectionIndex);
+
+        if(section.isEdited())
+        {
+            writeEditedSection(collector, section);
+        }
+        else if(!section.isSolved())
+        {
+            collector.writeMarker("<<<<<<<", labels[1]);
+            collector.writeInputLines(LineSource::B, section.getLineNumberRange(LineSource::B));
+            collector.writeMarker("|||||||", labels[0]);
+            collector.writeInputLines(LineSource::A, section.getLineNumberRange(LineSource::A));
+            collector.writeMarker("=======", "");
+            collector.writeInputLines(LineSource::C, section.getLineNumberRange(LineSource::C));
+            collector.writeMarker(">>>>>>>", labels[2]);
+            conflicts++;
+        }
+        else
+        {
+            writeUneditedSection(collector, section);
+        }
+    }
+
+    collector.finish();
+    return conflicts;
+}
+
+size_t writeMergeResult(std::ostream& output,
+                        const ContentMapper& contentMapper,
+                        const std::vector<ILineProvider*>& lineProviders,
+                        const std::vector<std::string>& labels)
+{
+    return forEachOutputFragment(contentMapper, lineProviders, labels, StreamWriter(output));
+}
+
+size_t writeMergeResult(int fd,
+                        const ContentMapper& contentMapper,
+                        const std::vector<ILineProvider*>& lineProviders,
+                        const std::vector<std::string>& labels)
+{
+    FragmentWriter writer(fd, lineProviders);
+    auto conflicts = forEachOutputFragment(contentMapper, lineProviders, labels,
+                                           [&writer](const OutputFragment& fragment) { writer.write(fragment); });
+    writer.flush();
+    return conflicts;
+}
+
+namespace
+{
+
+/**
+ * A part of the merge result that is written separately, at a known offset
+ */
+struct Segment
+{
+    off_t outputOffset;
+    std::vector<OutputFragment> fragments;
+};
+
+/** Smaller segments are not worth the overhead of writing them separately */
+const size_t MIN_SEGMENT_SIZE = 4 * 1024 * 1024;
+
+/**
+ * Splits the merge result into segments of about the same size. Fragments of
+ * input files are split where a segment ends, so that a few large unchanged
+ * stretches of a file are still written in parallel.
+ */
+std::vector<Segment> splitIntoSegments(const std::vector<OutputFragment>& fragments,
+                                       size_t outputSize,
+                                       size_t maxNrOfSegments)
+{
+    size_t nrOfSegments = std::max<size_t>(1, std::min(maxNrOfSegments, outputSize / MIN_SEGMENT_SIZE));
+    size_t segmentSize = (outputSize + nrOfSegments - 1) / nrOfSegments;
+
+    std::vector<Segment> segments{ Segment{ 0, {} } };
+    size_t offset = 0;
+    for(auto fragment: fragments)
+    {
+        while(true)
+        {
+            size_t segmentEnd = static_cast<size_t>(segments.back().outputOffset) + segmentSize;
+            if(offset >= segmentEnd)
+            {
+                segments.push_back(Segment{ static_cast<off_t>(offset), {} });
+                continue;
+            }
+            if(fragment.input == -1 || offset + fragment.text.size() <= segmentEnd)
+            {
+                break;
+            }
+
+            size_t head = segmentEnd - offset;
+            segments.back().fragments.push_back(OutputFragment{ fragment.input, fragment.offset, fragment.text.substr(0, head) });
+            fragment.offset += head;
+            fragment.text.remove_prefix(head);
+            offset += head;
+        }
+        segments.back().fragments.push_back(fragment);
+        offset += fragment.text.size();
+    }
+    return segments;
+}
+
+/**
+ * Creates a file next to the output file that replaces it once it is
+ * complete, with the permissions the output file has or would get.
+ */
+int createTemporaryFile(const std::string& outputFileName, std::string& temporaryFileName)
+{
+    mode_t mode;
+    struct stat statbuf;
+    if(stat(outputFileName.c_str(), &statbuf) == 0)
+    {
+        mode = statbuf.st_mode & 07777;
+    }
+    else
+    {
+        mode_t mask = umask(0);
+        umask(mask);
+        mode = 0666 & ~mask;
+    }
+
+    std::vector<char> name(outputFileName.begin(), outputFileName.end());
+    std::string suffix = ".tdiff3-XXXXXX";
+    name.insert(name.end(), suffix.begin(), suffix.end());
+    name.push_back('\0');
+
+    int fd = mkstemp(name.data());
+    if(fd == -1)
+    {
+        throw std::runtime_error("Failed to create temporary file");
+    }
+    temporaryFileName = name.data();
+    fchmod(fd, mode);
+    return fd;
+}
+
+/**
+ * Returns the file that a name refers to after following all symbolic
+ * links, so that the file is saved instead of the links being replaced.
+ */
+std::string resolveSymbolicLinks(const std::string& fileName)
+{
+    std::unique_ptr<char, void (*)(void *)> resolved(realpath(fileName.c_str(), nullptr), free);
+    return resolved ? std::string(resolved.get()) : fileName;
+}
+
+bool isInputFile(const struct stat& statbuf, const std::vector<ILineProvider*>& lineProviders)
+{
+    for(auto lineProvider: lineProviders)
+    {
+        struct stat inputStatbuf;
+        int fd = lineProvider->getFileDescriptor();
+        if(fd != -1 && fstat(fd, &inputStatbuf) == 0 &&
+           inputStatbuf.st_dev == statbuf.st_dev && inputStatbuf.st_ino == statbuf.st_ino)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Copies a complete temporary file over the content of the output file.
+ */
+void copyIntoFile(int fd, const std::string& outputFileName, size_t size)
+{
+    int outputFd = open(outputFileName.c_str(), O_WRONLY);
+    if(outputFd == -1)
+    {
+        throw std::runtime_error("Failed to open output file");
+    }
+    try
+    {
+        loff_t inputOffset = 0;
+        loff_t outputOffset = 0;
+        bool copyFileRange = true;
+        std::vector<char> buffer;
+        while(static_cast<size_t>(outputOffset) < size)
+        {
+            size_t remaining = size - static_cast<size_t>(outputOffset);
+            ssize_t copied = -1;
+            if(copyFileRange)
+            {
+                copied = copy_file_range(fd, &inputOffset, outputFd, &outputOffset, remaining, 0);
+                if(copied == -1 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+                {
+                    copyFileRange = false;
+                    continue;
+                }
+            }
+            else
+            {
+                buffer.resize(std::min<size_t>(remaining, 1024 * 1024));
+                copied = pread(fd, buffer.data(), buffer.size(), inputOffset);
+                if(copied > 0)
+                {
+                    copied = pwrite(outputFd, buffer.data(), static_cast<size_t>(copied), outputOffset);
+                }
+                if(copied > 0)
+                {
+                    inputOffset += copied;
+                    outputOffset += copied;
+                }
+            }
+            if(copied == -1 && errno == EINTR)
+            {
+                continue;
+            }
+            if(copied <= 0)
+            {
+                throw std::runtime_error("Failed to write merge result");
+            }
+        }
+        if(ftruncate(outputFd, static_cast<off_t>(size)) == -1)
+        {
+            throw std::runtime_error("Failed to set the size of the output file");
+        }
+        if(fsync(outputFd) == -1)
+        {
+            throw std::runtime_error("Failed to flush the output file to disk");
+        }
+    }
+    catch(...)
+    {
+        close(outputFd);
+        throw;
+    }
+    if(close(outputFd) == -1)
+    {
+        throw std::runtime_error("Failed to close output file");
+    }
+}
+
+void writeFragments(int fd,
+                    const std::vector<OutputFragment>& fragments,
+                    const std::vector<ILineProvider*>& lineProviders,
+                    off_t outputOffset,
+                    SaveProgress *progress)
+{
+    FragmentWriter writer(fd, lineProviders, outputOffset);
+    for(auto& fragment: fragments)
+    {
+        if(progress != nullptr)
+        {
+            if(progress->cancelled)
+            {
+                throw SaveCancelled();
+            }
+            progress->bytesWritten += fragment.text.size();
+        }
+        writer.write(fragment);
+    }
+    writer.flush();
+}
+
+void writeSegments(int fd,
+                   const std::vector<Segment>& segments,
+                   const std::vector<ILineProvider*>& lineProviders,
+                   WorkerPool& workerPool,
+                   SaveProgress *progress)
+{
+    /* Workers cannot throw, so the first error of every segment is kept
+     * until all of them are done */
+    std::vector<std::exception_ptr> errors(segments.size());
+    workerPool.run(segments.size(), [&](size_t segment, unsigned)
+    {
+        try
+        {
+            writeFragments(fd, segments[segment].fragments, lineProviders, segments[segment].outputOffset, progress);
+        }
+        catch(...)
+        {
+            errors[segment] = std::current_exception();
+        }
+    });
+
+    for(auto& error: errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void saveFragments(const std::string& outputFileName,
+                   const std::vector<OutputFragment>& fragments,
+                   size_t outputSize,
+                   const std::vector<ILineProvider*>& lineProviders,
+                   WorkerPool& workerPool,
+                   SaveProgress *progress)
+{
+    if(progress != nullptr)
+    {
+        progress->totalBytes = outputSize;
+    }
+
+    /* A symbolic link keeps pointing to the output file, so it is the file
+     * that the link points to that is replaced */
+    auto targetFileName = resolveSymbolicLinks(outputFileName);
+
+    struct stat statbuf;
+    bool exists = (stat(targetFileName.c_str(), &statbuf) == 0);
+    if(exists ? !S_ISREG(statbuf.st_mode) : (errno != ENOENT))
+    {
+        int fd = open(targetFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if(fd == -1)
+        {
+            throw std::runtime_error("Failed to open output file");
+        }
+        try
+        {
+            writeFragments(fd, fragments, lineProviders, -1, progress);
+        }
+        catch(...)
+        {
+            close(fd);
+            throw;
+        }
+        if(close(fd) == -1)
+        {
+            throw std::runtime_error("Failed to close output file");
+        }
+        return;
+    }
+
+    /* Replacing a file with other hard links would separate it from them,
+     * so once the merge result is complete it is copied over the file
+     * instead. That is not atomic, but a save that fails or is cancelled
+     * before then still leaves the file as it was. An input file cannot be
+     * overwritten while it is being read, so that is always replaced. */
+    bool overwrite = exists && statbuf.st_nlink > 1 && !isInputFile(statbuf, lineProviders);
+
+    auto segments = splitIntoSegments(fragments, outputSize, 4 * workerPool.concurrency());
+
+    std::string temporaryFileName;
+    int fd = createTemporaryFile(targetFileName, temporaryFileName);
+    try
+    {
+        if(ftruncate(fd, static_cast<off_t>(outputSize)) == -1)
+        {
+            throw std::runtime_error("Failed to set the size of the output file");
+        }
+        writeSegments(fd, segments, lineProviders, workerPool, progress);
+        if(overwrite)
+        {
+            copyIntoFile(fd, targetFileName, outputSize);
+            close(fd);
+            fd = -1;
+            unlink(temporaryFileName.c_str());
+            return;
+        }
+        if(fsync(fd) == -1)
+        {
+            throw std::runtime_error("Failed to flush the output file to disk");
+        }
+        if(close(fd) == -1)
+        {
+            fd = -1;
+            throw std::runtime_error("Failed to close output file");
+        }
+        fd = -1;
+        if(rename(temporaryFileName.c_str(), targetFileName.c_str()) == -1)
+        {
+            throw std::runtime_error("Failed to replace output file");
+        }
+    }
+    catch(...)
+    {
+        if(fd != -1)
+        {
+            close(fd);
+        }
+        unlink(temporaryFileName.c_str());
+        throw;
+    }
+}
+
+}
+
+size_t saveMergeResult(const std::string& outputFileName,
+                       const ContentMapper& contentMapper,
+                       const std::vector<ILineProvider*>& lineProviders,
+                       const std::vector<std::string>& labels,
+                       WorkerPool& workerPool,
+                       SaveProgress *progress)
+{
+    /* Listing the fragments only visits sections and edited lines, so it
+     * takes little time compared to writing them */
+    std::vector<OutputFragment> fragments;
+    size_t outputSize = 0;
+    auto conflicts = forEachOutputFragment(contentMapper, lineProviders, labels,
+                                           [&](const OutputFragment& fragment)
+                                           {
+                                               fragments.push_back(fragment);
+                                               outputSize += fragment.text.size();
+                                           });
+    saveFragments(outputFileName, fragments, outputSize, lineProviders, workerPool, progress);
+    return conflicts;
+}
+
+void saveInputFile(const std::string& outputFileName,
+                   const std::vector<ILineProvider*>& lineProviders,
+                   int input,
+                   WorkerPool& workerPool)
+{
+    auto content = lineProviders[input]->getContent();
+    std::vector<OutputFragment> fragments;
+    if(!content.empty())
+    {
+        fragments.push_back(OutputFragment{ input, 0, content });
+    }
+    saveFragments(outputFileName, fragments, content.size(), lineProviders, workerPool, nullptr);
+}
+
+FragmentWriter::FragmentWriter(int fd, const std::vector<ILineProvider*>& lineProviders, off_t outputOffset):
+    m_fd(fd),
+    m_outputOffset(outputOffset)
+{
+    for(auto lineProvider: lineProviders)
+    {
+        m_inputFds.push_back(lineProvider->getFileDescriptor());
+    }
+}
+
+void FragmentWriter::write(const OutputFragment& fragment)
+{
+    if(fragment.input != -1 && fragment.text.size() >= MIN_COPY_SIZE && m_copyFileRange)
+    {
+        flush();
+        if(copyFromInput(fragment))
+        {
+            return;
+        }
+    }
+
+    m_iovecs.push_back(iovec{ const_cast<char *>(fragment.text.data()), fragment.text.size() });
+    if(m_iovecs.size() == MAX_IOVECS)
+    {
+        flush();
+    }
+}
+
+void FragmentWriter::flush()
+{
+    auto iov = m_iovecs.begin();
+    while(iov != m_iovecs.end())
+    {
+        auto count = std::min<size_t>(m_iovecs.end() - iov, MAX_IOVECS);
+        ssize_t written = (m_outputOffset == -1) ?
+                          writev(m_fd, &*iov, static_cast<int>(count)) :
+                          pwritev(m_fd, &*iov, static_cast<int>(count), m_outputOffset);
+        if(written == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("Failed to write merge result");
+        }
+
+        if(m_outputOffset != -1)
+        {
+            m_outputOffset += written;
+        }
+
+        /* Continue after the part that was written */
+        auto remaining = static_cast<size_t>(written);
+        while(iov != m_iovecs.end() && remaining >= iov->iov_len)
+        {
+            remaining -= iov->iov_len;
+            ++iov;
+        }
+        if(remaining > 0)
+        {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + remaining;
+            iov->iov_len -= remaining;
+        }
+    }
+    m_iovecs.clear();
+}
+
+/**
+ * Returns false if nothing was copied because the kernel cannot copy
+ * between these files, in which case the fragment has to be written.
+ */
+bool FragmentWriter::copyFromInput(const OutputFragment& fragment)
+{
+    int inputFd = m_inputFds[fragment.input];
+    if(inputFd == -1)
+    {
+        return false;
+    }
+
+    auto offset = static_cast<loff_t>(fragment.offset);
+    size_t remaining = fragment.text.size();
+    while(remaining > 0)
+    {
+        ssize_t copied = copy_file_range(inputFd, &offset,
+                                         m_fd, (m_outputOffset == -1) ? nullptr : &m_outputOffset,
+                                         remaining, 0);
+        if(copied == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(remaining == fragment.text.size() &&
+               (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP || errno == EBADF))
+            {
+                /* E.g. the output is a pipe or on a file system that does
+                 * not support it, so it will not work for later fragments
+                 * either */
+                m_copyFileRange = false;
+                return false;
+            }
+            throw std::runtime_error("Failed to write merge result");
+        }
+        if(copied == 0)
+        {
+            throw std::runtime_error("Input file changed while writing merge result");
+        }
+        remaining -= static_cast<size_t>(copied);
+    }
+    return true;
+}
@@ -0,0 +1,183 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "contentmapper.h"
+#include "ilineprovider.h"
+#include "workerpool.h"
+
+/**
+ * A piece of the merge result. Consecutive lines of an input file form a
+ * single fragment, so that they can be copied in one go.
+ */
+struct OutputFragment
+{
+    /** The input file the text is part of, or -1 for edited lines and
+     *  conflict markers */
+    int input;
+
+    /** The offset of the text in the content of the input file */
+    size_t offset;
+
+    std::string_view text;
+};
+
+/**
+ * Splits the merge result into fragments, the way a save from the user
+ * interface would write it, except that unsolved differences do not prevent
+ * it. Each of those that has not been edited is written as the lines of B,
+ * A and C between conflict markers that carry the labels of the files.
+ *
+ * Sections are visited directly and unedited ones are not split into
+ * lines, so this takes time in the number of sections and edited lines.
+ *
+ * Returns the number of conflicts in the merge result.
+ */
+size_t forEachOutputFragment(const ContentMapper& contentMapper,
+                             const std::vector<ILineProvider*>& lineProviders,
+                             const std::vector<std::string>& labels,
+                             const std::function<void(const OutputFragment&)>& fragmentHandler);
+
+/**
+ * Writes the merge result to output. Returns the number of conflicts that
+ * were written.
+ */
+size_t writeMergeResult(std::ostream& output,
+                        const ContentMapper& contentMapper,
+                        const std::vector<ILineProvider*>& lineProviders,
+                        const std::vector<std::string>& labels);
+
+/**
+ * Writes the merge result to a file descriptor without copying it through
+ * user space buffers. Returns the number of conflicts that were written.
+ * Throws a std::runtime_error if writing fails.
+ */
+size_t writeMergeResult(int fd,
+                        const ContentMapper& contentMapper,
+                        const std::vector<ILineProvider*>& lineProviders,
+                        const std::vector<std::string>& labels);
+
+/**
+ * Allows another thread to follow a save and to cancel it.
+ */
+struct SaveProgress
+{
+    std::atomic<size_t> bytesWritten{0};
+
+    /** Set once the size of the merge result is known */
+    std::atomic<size_t> totalBytes{0};
+
+    std::atomic<bool> cancelled{false};
+};
+
+class SaveCancelled: public std::runtime_error
+{
+public:
+    SaveCancelled():
+        std::runtime_error("Save was cancelled")
+    {
+    }
+};
+
+/**
+ * Saves the merge result to a file, which is replaced atomically once the
+ * merge result is safely on disk. The merge result is split into segments
+ * of which the offsets in the file are known in advance, so that the
+ * workers can write them at the same time. Other outputs, like pipes, are
+ * written sequentially. Returns the number of conflicts that were written.
+ *
+ * Symbolic links to the file are followed, so they keep pointing to it. A
+ * file with other hard links is overwritten with the complete merge result
+ * instead of being replaced, so that it stays linked.
+ *
+ * Throws a std::runtime_error if saving fails and SaveCancelled if it is
+ * cancelled through progress, in which case the file is left as it was.
+ */
+size_t saveMergeResult(const std::string& outputFileName,
+                       const ContentMapper& contentMapper,
+                       const std::vector<ILineProvider*>& lineProviders,
+                       const std::vector<std::string>& labels,
+                       WorkerPool& workerPool = WorkerPool::shared(),
+                       SaveProgress *progress = nullptr);
+
+/**
+ * Saves one of the input files unchanged as the merge result, in the same
+ * way as saveMergeResult. The output file is replaced rather than
+ * overwritten, so it may be that input file itself.
+ *
+ * Throws a std::runtime_error if saving fails.
+ */
+void saveInputFile(const std::string& outputFileName,
+                   const std::vector<ILineProvider*>& lineProviders,
+                   int input,
+                   WorkerPool& workerPool = WorkerPool::shared());
+
+/**
+ * Writes fragments to a file descriptor. Large fragments of input files are
+ * copied by the kernel with copy_file_range, all others are gathered in
+ * iovecs that point to where the text already is and written with writev.
+ *
+ * If an output offset is specified, the fragments are written from there
+ * without using or changing the file position, so that several writers can
+ * write to the same file.
+ */
+class FragmentWriter
+{
+public:
+    FragmentWriter(int fd, const std::vector<ILineProvider*>& lineProviders, off_t outputOffset = -1);
+
+    void write(const OutputFragment& fragment);
+
+    /**
+     * Writes the fragments that have been gathered. Must be called after
+     * the last fragment.
+     */
+    void flush();
+
+private:
+    bool copyFromInput(const OutputFragment& fragment);
+
+    /** Smaller fragments are cheaper to gather than to copy separately */
+    static constexpr size_t MIN_COPY_SIZE = 64 * 1024;
+    static constexpr size_t MAX_IOVECS = 1024;
+
+    int m_fd;
+    loff_t m_outputOffset;
+    std::vector<int> m_inputFds;
+    bool m_copyFileRange = true;
+    std::vector<iovec> m_iovecs;
+};
@@ -0,0 +1,266 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mergestate.h"
+
+namespace
+{
+
+const char MAGIC[8] = { 't', 'd', 'i', 'f', 'f', '3', 'M', 'S' };
+const uint32_t VERSION = 2;
+
+/**
+ * What tells a file apart from another one, or from an earlier version of
+ * itself, without reading it.
+ */
+struct InputIdentity
+{
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    uint64_t modificationTime;
+
+    bool operator==(const InputIdentity& other) const
+    {
+        return device == other.device && inode == other.inode &&
+               size == other.size && modificationTime == other.modificationTime;
+    }
+};
+
+bool getInputIdentity(const std::string& fileName, InputIdentity& identity)
+{
+    struct stat statbuf;
+    if(stat(fileName.c_str(), &statbuf) == -1)
+    {
+        return false;
+    }
+    identity = InputIdentity{ static_cast<uint64_t>(statbuf.st_dev),
+                              static_cast<uint64_t>(statbuf.st_ino),
+                              static_cast<uint64_t>(statbuf.st_size),
+                              static_cast<uint64_t>(statbuf.st_mtim.tv_sec) * 1000000000 +
+                              static_cast<uint64_t>(statbuf.st_mtim.tv_nsec) };
+    return true;
+}
+
+/**
+ * A section as it is stored, i.e. the line number ranges of A, B, C and the
+ * diff3 table and the selected sources in the order they were selected.
+ */
+struct StoredSection
+{
+    int32_t lineNumbers[4][2];
+    uint8_t isDifference;
+    uint8_t nrOfSelectedSources;
+    uint8_t selectedSources[3];
+};
+
+template<typename T>
+void writeValue(std::ostream& output, const T& value)
+{
+    output.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template<typename T>
+bool readValue(std::istream& input, T& value)
+{
+    return static_cast<bool>(input.read(reinterpret_cast<char *>(&value), sizeof(value)));
+}
+
+StoredSection storeSection(const MergeResultSection& section)
+{
+    assert(!section.isEdited());
+
+    StoredSection stored;
+    memset(&stored, 0, sizeof(stored));
+    LineNumberRange ranges[4] = { section.getLineNumberRange(LineSource::A),
+                                  section.getLineNumberRange(LineSource::B),
+                                  section.getLineNumberRange(LineSource::C),
+                                  section.getDiff3LineNumberRange() };
+    for(int i = 0; i < 4; i++)
+    {
+        stored.lineNumbers[i][0] = ranges[i].firstLine;
+        stored.lineNumbers[i][1] = ranges[i].lastLine;
+    }
+    stored.isDifference = section.isDifference();
+    auto& selectedSources = section.getSelectedSources();
+    assert(selectedSources.size() <= 3);
+    stored.nrOfSelectedSources = static_cast<uint8_t>(selectedSources.size());
+    for(size_t i = 0; i < selectedSources.size() && i < 3; i++)
+    {
+        stored.selectedSources[i] = static_cast<uint8_t>(selectedSources[i]);
+    }
+    return stored;
+}
+
+bool restoreSection(const StoredSection& stored, MergeResultSections& sections)
+{
+    auto& n = stored.lineNumbers;
+    for(auto& range: n)
+    {
+        if((range[0] == -1) != (range[1] == -1) || range[0] < -1 || range[1] < range[0])
+        {
+            return false;
+        }
+    }
+    sections.emplace_back(stored.isDifference != 0,
+                          n[0][0], n[0][1], n[1][0], n[1][1], n[2][0], n[2][1], n[3][0], n[3][1]);
+    if(stored.nrOfSelectedSources > 3 || (stored.nrOfSelectedSources > 0 && !stored.isDifference))
+    {
+        return false;
+    }
+    for(int i = 0; i < stored.nrOfSelectedSources; i++)
+    {
+        if(stored.selectedSources[i] > static_cast<uint8_t>(LineSource::C))
+        {
+            return false;
+        }
+        sections.back().toggle(static_cast<LineSource>(stored.selectedSources[i]));
+    }
+    return true;
+}
+
+}
+
+uint64_t saveMergeState(const std::string& fileName,
+                        const std::vector<std::string>& inputFileNames,
+                        const Diff3Table& diff3Table,
+                        const ContentMapper& contentMapper)
+{
+    std::random_device random;
+    uint64_t stateId = (static_cast<uint64_t>(random()) << 32) | random();
+
+    std::string temporaryFileName = fileName + ".tmp";
+    {
+        std::ofstream output(temporaryFileName, std::ios::binary | std::ios::trunc);
+        output.write(MAGIC, sizeof(MAGIC));
+        writeValue(output, VERSION);
+        writeValue(output, stateId);
+        for(auto& inputFileName: inputFileNames)
+        {
+            InputIdentity identity;
+            if(!getInputIdentity(inputFileName, identity))
+            {
+                throw std::runtime_error("Failed to get the status of input file " + inputFileName);
+            }
+            writeValue(output, identity);
+        }
+
+        diff3Table.write(output);
+
+        writeValue(output, static_cast<uint64_t>(contentMapper.getNumberOfSections()));
+        for(size_t i = 0; i < contentMapper.getNumberOfSections(); i++)
+        {
+            writeValue(output, storeSection(contentMapper.getSection(i)));
+        }
+
+        output.close();
+        if(!output)
+        {
+            remove(temporaryFileName.c_str());
+            throw std::runtime_error("Failed to write merge state");
+        }
+    }
+
+    /* The state must be complete on disk before it replaces an older one */
+    int fd = open(temporaryFileName.c_str(), O_RDONLY);
+    bool synced = (fd != -1) && (fsync(fd) == 0);
+    if(fd != -1)
+    {
+        close(fd);
+    }
+    if(!synced || rename(temporaryFileName.c_str(), fileName.c_str()) == -1)
+    {
+        remove(temporaryFileName.c_str());
+        throw std::runtime_error("Failed to write merge state");
+    }
+    return stateId;
+}
+
+bool loadMergeState(const std::string& fileName,
+                    const std::vector<std::string>& inputFileNames,
+                    Diff3Table& diff3Table,
+                    ContentMapper& contentMapper,
+                    uint64_t& stateId)
+{
+    std::ifstream input(fileName, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    uint32_t version;
+    if(!input.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 ||
+       !readValue(input, version) || version != VERSION ||
+       !readValue(input, stateId))
+    {
+        return false;
+    }
+
+    for(auto& inputFileName: inputFileNames)
+    {
+        InputIdentity stored;
+        InputIdentity current;
+        if(!readValue(input, stored) || !getInputIdentity(inputFileName, current) || !(stored == current))
+        {
+            return false;
+        }
+    }
+
+    Diff3Table table;
+    uint64_t nrOfSections;
+    if(!Diff3Table::read(input, table) || !readValue(input, nrOfSections))
+    {
+        return false;
+    }
+
+    /* The sections must cover the rows of the table in order */
+    MergeResultSections sections;
+    int64_t nextRow = 0;
+    for(uint64_t i = 0; i < nrOfSections; i++)
+    {
+        StoredSection stored;
+        if(!readValue(input, stored) || stored.lineNumbers[3][0] != nextRow ||
+           !restoreSection(stored, sections))
+        {
+            return false;
+        }
+        nextRow = stored.lineNumbers[3][1] + 1;
+    }
+    if(static_cast<uint64_t>(nextRow) != table.size())
+    {
+        return false;
+    }
+
+    diff3Table = std::move(table);
+    contentMapper.setMergeResultSections(std::move(sections));
+    return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "contentmapper.h"
+#include "diff3table.h"
+
+/**
+ * The merge state is what diffing the input files and resolving differences
+ * automatically produce: the diff3 table and the merge result sections
+ * before the user changed anything. Storing it allows tdiff3 to resume a
+ * merge of the same input files without diffing them again, after which a
+ * resolution journal brings back what the user did.
+ */
+
+/**
+ * Writes the merge state to a file, which is replaced atomically once the
+ * state is on disk. Returns the ID of the state, which a resolution journal
+ * must have to be replayed on top of it. Throws a std::runtime_error if
+ * saving fails.
+ */
+uint64_t saveMergeState(const std::string& fileName,
+                        const std::vector<std::string>& inputFileNames,
+                        const Diff3Table& diff3Table,
+                        const ContentMapper& contentMapper);
+
+/**
+ * Reads a merge state that was saved for the same input files, which must
+ * not have changed since. Returns false if there is no such state.
+ */
+bool loadMergeState(const std::string& fileName,
+                    const std::vector<std::string>& inputFileNames,
+                    Diff3Table& diff3Table,
+                    ContentMapper& contentMapper,
+                    uint64_t& stateId);
@@ -114,7 +114,8 @@ private:
 };
 
 MmappedFileLineProvider::MmappedFileLineProvider(const std::string& filename):
-    m_file(std::make_unique<MemoryMap>(OpenedFile(filename.c_str(), O_RDONLY)))
+    m_openedFile(std::make_unique<OpenedFile>(filename.c_str(), O_RDONLY)),
+    m_file(std::make_unique<MemoryMap>(*m_openedFile))
 {
     m_fileLength = m_file->size();
     m_filename = filename;
@@ -184,7 +185,13 @@ void MmappedFileLineProvider::ensure_line_is_available(int index)
 
 size_t MmappedFileLineProvider::getLastLineNumber()
 {
-    assert(m_lineEnds.back() == m_fileLength);
+    /* Lines are no longer all indexed while diffing, so find the remaining
+     * line endings first */
+    while((m_lineEnds.empty() ? 0 : m_lineEnds.back()) < m_fileLength)
+    {
+        ensure_line_is_available(m_lineEnds.size());
+    }
+    assert(m_lineEnds.empty() || m_lineEnds.back() == m_fileLength);
     return m_lineEnds.size() - 1;
 }
 
@@ -208,6 +215,20 @@ std::vector<std::string_view> MmappedFileLineProvider::get(size_t i)
     return result;
 }
 
+std::string_view MmappedFileLineProvider::getContent()
+{
+    if(m_fileLength == 0)
+    {
+        return std::string_view();
+    }
+    return m_file->getView(0, m_fileLength);
+}
+
+int MmappedFileLineProvider::getFileDescriptor()
+{
+    return m_openedFile->fd();
+}
+
 #if 0
 std::vector<std::string_view> MmappedFileLineProvider::get(int firstLine, int lastLine)
 {
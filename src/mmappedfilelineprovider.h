@@ -41,6 +41,7 @@
 #include "ilineprovider.h"
 
 class MemoryMap;
+class OpenedFile;
 
 class MmappedFileLineProvider: public ILineProvider
 {
@@ -51,6 +52,8 @@ public:
     virtual size_t getLastLineNumber() override;
     int getMaxWidth();
     virtual std::vector<std::string_view> get(size_t i) override;
+    virtual std::string_view getContent() override;
+    virtual int getFileDescriptor() override;
     //std::vector<std::string_view> get(int firstLine, int lastLine);
 
 private:
@@ -61,6 +64,8 @@ private:
     static const int readahead = 10000;
     int m_maxWidth;
     std::vector<size_t> m_lineEnds;
+    /** Kept open so that the content can be copied without reading it */
+    std::unique_ptr<OpenedFile> m_openedFile;
     std::unique_ptr<MemoryMap> m_file;
     ulong m_fileLength;
     std::string m_filename;
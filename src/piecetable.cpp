@@ -0,0 +1,205 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cassert>
+#include <utility>
+
+#include "piecetable.h"
+
+struct PieceTable::Piece
+{
+    bool isOriginal;
+    int start;
+    int count;
+
+    /** Higher than that of the nodes below, which keeps the tree balanced */
+    uint32_t priority;
+
+    /** The lines added by the edit that created the piece, shared by all
+     *  pieces that the edit's lines have been split into */
+    std::shared_ptr<const std::vector<std::string>> addedLines;
+};
+
+struct PieceTable::Node: Piece
+{
+    NodePtr left;
+    NodePtr right;
+
+    /** The number of lines and pieces in the subtree of this node */
+    int subtreeLines;
+    int subtreePieces;
+};
+
+PieceTable::PieceTable(int originalLineCount):
+    m_randomState(0x9e3779b9)
+{
+    assert(originalLineCount >= 0);
+    if(originalLineCount > 0)
+    {
+        m_root = makeNode(Piece{ true, 0, originalLineCount, nextPriority(), nullptr }, nullptr, nullptr);
+    }
+}
+
+int PieceTable::size() const
+{
+    return lines(m_root);
+}
+
+int PieceTable::getNumberOfPieces() const
+{
+    return pieces(m_root);
+}
+
+PieceTable::Line PieceTable::getLine(int lineNumber) const
+{
+    assert(lineNumber >= 0 && lineNumber < size());
+
+    const Node* node = m_root.get();
+    while(true)
+    {
+        int leftLines = lines(node->left);
+        if(lineNumber < leftLines)
+        {
+            node = node->left.get();
+        }
+        else if(lineNumber < leftLines + node->count)
+        {
+            int index = node->start + lineNumber - leftLines;
+            if(node->isOriginal)
+            {
+                return Line{ true, index, std::string_view() };
+            }
+            return Line{ false, -1, (*node->addedLines)[index] };
+        }
+        else
+        {
+            lineNumber -= leftLines + node->count;
+            node = node->right.get();
+        }
+    }
+}
+
+void PieceTable::replace(int firstLine, int lineCount, const std::vector<std::string>& lines)
+{
+    assert(firstLine >= 0 && lineCount >= 0 && firstLine + lineCount <= size());
+
+    auto [before, rest] = split(m_root, firstLine);
+    auto after = split(rest, lineCount).second;
+
+    NodePtr added;
+    if(!lines.empty())
+    {
+        auto addedLines = std::make_shared<const std::vector<std::string>>(lines);
+        added = makeNode(Piece{ false, 0, static_cast<int>(lines.size()), nextPriority(), std::move(addedLines) },
+                         nullptr, nullptr);
+    }
+
+    m_root = merge(merge(before, added), after);
+}
+
+int PieceTable::lines(const NodePtr& node)
+{
+    return node ? node->subtreeLines : 0;
+}
+
+int PieceTable::pieces(const NodePtr& node)
+{
+    return node ? node->subtreePieces : 0;
+}
+
+PieceTable::NodePtr PieceTable::makeNode(const Piece& piece, NodePtr left, NodePtr right)
+{
+    assert(piece.count > 0);
+    int subtreeLines = lines(left) + piece.count + lines(right);
+    int subtreePieces = pieces(left) + 1 + pieces(right);
+    return std::make_shared<const Node>(Node{ piece, std::move(left), std::move(right), subtreeLines, subtreePieces });
+}
+
+/**
+ * Returns a tree with the lines before lineNumber and one with the others,
+ * splitting the piece that contains lineNumber if needed.
+ */
+std::pair<PieceTable::NodePtr, PieceTable::NodePtr> PieceTable::split(const NodePtr& node, int lineNumber)
+{
+    if(!node)
+    {
+        return { nullptr, nullptr };
+    }
+
+    int leftLines = lines(node->left);
+    if(lineNumber <= leftLines)
+    {
+        auto [left, right] = split(node->left, lineNumber);
+        return { left, makeNode(*node, right, node->right) };
+    }
+    else if(lineNumber >= leftLines + node->count)
+    {
+        auto [left, right] = split(node->right, lineNumber - leftLines - node->count);
+        return { makeNode(*node, node->left, left), right };
+    }
+    else
+    {
+        /* Both halves of the piece keep the priority, so each is still above
+         * the subtree it gets */
+        int offset = lineNumber - leftLines;
+        Piece head = *node;
+        head.count = offset;
+        Piece tail = *node;
+        tail.start += offset;
+        tail.count -= offset;
+        return { makeNode(head, node->left, nullptr), makeNode(tail, nullptr, node->right) };
+    }
+}
+
+PieceTable::NodePtr PieceTable::merge(const NodePtr& left, const NodePtr& right)
+{
+    if(!left)
+    {
+        return right;
+    }
+    if(!right)
+    {
+        return left;
+    }
+
+    if(left->priority > right->priority)
+    {
+        return makeNode(*left, left->left, merge(left->right, right));
+    }
+    else
+    {
+        return makeNode(*right, merge(left, right->left), right->right);
+    }
+}
+
+uint32_t PieceTable::nextPriority()
+{
+    /* xorshift32 */
+    m_randomState ^= m_randomState << 13;
+    m_randomState ^= m_randomState >> 17;
+    m_randomState ^= m_randomState << 5;
+    return m_randomState;
+}
@@ -0,0 +1,111 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * The lines of an edited text as a sequence of pieces, each of which refers
+ * either to consecutive lines of the original text or to consecutive lines
+ * that were added by edits.
+ *
+ * The lines added by an edit are stored with the piece that refers to them
+ * and are never changed, so replacing lines never touches the text of other
+ * lines. The pieces are kept in a balanced tree (a treap ordered by
+ * position) in which every node knows the number of lines below it, so both
+ * finding a line and replacing lines take O(log n) in the number of pieces,
+ * independent of the number of lines.
+ *
+ * Nodes are never changed once created. An edit creates new nodes for the
+ * path to the changed pieces and shares all others with the previous
+ * version, so copying a piece table takes O(1) and a copy keeps its content
+ * while the original is edited. As nothing that is shared is ever changed, a
+ * copy can even be read by another thread while the original is edited.
+ */
+class PieceTable
+{
+public:
+    /**
+     * Where the text of a line is stored.
+     */
+    struct Line
+    {
+        /** Whether the line is one of the original ones or an added one */
+        bool isOriginal;
+
+        /** The line number in the original text (only if isOriginal) */
+        int index;
+
+        /** The text of an added line (only if not isOriginal), which
+         *  remains valid for as long as a copy of the piece table that
+         *  contains the line exists */
+        std::string_view text;
+    };
+
+    /**
+     * Creates a piece table that consists of the specified number of
+     * original lines.
+     */
+    explicit PieceTable(int originalLineCount);
+
+    /**
+     * Returns the number of lines.
+     */
+    int size() const;
+
+    Line getLine(int lineNumber) const;
+
+    /**
+     * Replaces lineCount lines starting at firstLine by the specified lines.
+     */
+    void replace(int firstLine, int lineCount, const std::vector<std::string>& lines);
+
+    /**
+     * Returns the number of pieces, which is what the time of all other
+     * operations depends on.
+     */
+    int getNumberOfPieces() const;
+
+private:
+    struct Piece;
+    struct Node;
+    using NodePtr = std::shared_ptr<const Node>;
+
+    static int lines(const NodePtr& node);
+    static int pieces(const NodePtr& node);
+    static NodePtr makeNode(const Piece& piece, NodePtr left, NodePtr right);
+    static std::pair<NodePtr, NodePtr> split(const NodePtr& node, int lineNumber);
+    static NodePtr merge(const NodePtr& left, const NodePtr& right);
+
+    uint32_t nextPriority();
+
+    NodePtr m_root;
+    uint32_t m_randomState;
+};
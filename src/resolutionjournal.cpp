@@ -0,0 +1,339 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "resolutionjournal.h"
+
+namespace
+{
+
+const char MAGIC[8] = { 't', 'd', 'i', 'f', 'f', '3', 'R', 'J' };
+
+enum class ActionType: uint8_t
+{
+    TOGGLE,
+    MODIFICATION,
+    UNDO,
+    REDO
+};
+
+/** Every record starts with the size and checksum of what follows */
+struct RecordHeader
+{
+    uint32_t payloadSize;
+    uint32_t checksum;
+};
+
+/* FNV-1a */
+uint32_t checksum(const char *data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+template<typename T>
+void appendValue(std::vector<char>& payload, const T& value)
+{
+    auto bytes = reinterpret_cast<const char *>(&value);
+    payload.insert(payload.end(), bytes, bytes + sizeof(value));
+}
+
+/**
+ * Reads the values of a payload, remembering if it was too short.
+ */
+class PayloadReader
+{
+public:
+    PayloadReader(const char *data, size_t size):
+        m_data(data),
+        m_remaining(size)
+    {
+    }
+
+    template<typename T>
+    T read()
+    {
+        T value{};
+        if(m_remaining < sizeof(value))
+        {
+            m_valid = false;
+            m_remaining = 0;
+            return value;
+        }
+        memcpy(&value, m_data, sizeof(value));
+        m_data += sizeof(value);
+        m_remaining -= sizeof(value);
+        return value;
+    }
+
+    std::string readString(uint32_t size)
+    {
+        if(m_remaining < size)
+        {
+            m_valid = false;
+            m_remaining = 0;
+            return std::string();
+        }
+        std::string text(m_data, size);
+        m_data += size;
+        m_remaining -= size;
+        return text;
+    }
+
+    /** Whether all values so far could be read */
+    bool isValid() const
+    {
+        return m_valid;
+    }
+
+    /** Whether all values could be read and nothing is left */
+    bool isComplete() const
+    {
+        return m_valid && m_remaining == 0;
+    }
+
+private:
+    const char *m_data;
+    size_t m_remaining;
+    bool m_valid = true;
+};
+
+/**
+ * Does the action of a record to the content mapper. Returns false if the
+ * record is not a valid action for the content mapper's current state.
+ */
+bool replayAction(PayloadReader& reader, ContentMapper& contentMapper)
+{
+    auto type = static_cast<ActionType>(reader.read<uint8_t>());
+    switch(type)
+    {
+    case ActionType::TOGGLE:
+    {
+        auto sectionIndex = reader.read<uint64_t>();
+        auto lineSource = reader.read<uint8_t>();
+        if(!reader.isComplete() ||
+           sectionIndex >= contentMapper.getNumberOfSections() ||
+           !contentMapper.getSection(sectionIndex).isDifference() ||
+           lineSource > static_cast<uint8_t>(LineSource::C))
+        {
+            return false;
+        }
+        contentMapper.toggleSectionSource(sectionIndex, static_cast<LineSource>(lineSource));
+        return true;
+    }
+    case ActionType::MODIFICATION:
+    {
+        Modification modification;
+        modification.firstLine = reader.read<int32_t>();
+        modification.originalLineCount = reader.read<int32_t>();
+        auto nrOfLines = reader.read<uint32_t>();
+        for(uint32_t i = 0; i < nrOfLines && reader.isValid(); i++)
+        {
+            modification.lines.push_back(reader.readString(reader.read<uint32_t>()));
+        }
+        if(!reader.isComplete() || modification.lines.size() != nrOfLines ||
+           modification.firstLine < 0 || modification.firstLine >= contentMapper.getContentHeight() ||
+           modification.originalLineCount < 0)
+        {
+            return false;
+        }
+        contentMapper.applyModification(std::move(modification));
+        return true;
+    }
+    case ActionType::UNDO:
+        return reader.isComplete() && contentMapper.undo();
+    case ActionType::REDO:
+        return reader.isComplete() && contentMapper.redo();
+    }
+    return false;
+}
+
+}
+
+ResolutionJournal::ResolutionJournal(const std::string& fileName, uint64_t stateId):
+    m_fd(open(fileName.c_str(), O_RDWR | O_CREAT | O_APPEND, 0666))
+{
+    if(m_fd == -1)
+    {
+        throw std::runtime_error("Failed to open resolution journal");
+    }
+
+    char header[sizeof(MAGIC) + sizeof(stateId)];
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    memcpy(header + sizeof(MAGIC), &stateId, sizeof(stateId));
+
+    /* A journal for another state is started over */
+    char existingHeader[sizeof(header)];
+    if(pread(m_fd, existingHeader, sizeof(existingHeader), 0) != sizeof(existingHeader) ||
+       memcmp(existingHeader, header, sizeof(header)) != 0)
+    {
+        if(ftruncate(m_fd, 0) == -1 ||
+           write(m_fd, header, sizeof(header)) != sizeof(header) ||
+           fsync(m_fd) == -1)
+        {
+            close(m_fd);
+            throw std::runtime_error("Failed to write resolution journal");
+        }
+    }
+}
+
+ResolutionJournal::~ResolutionJournal()
+{
+    fsync(m_fd);
+    close(m_fd);
+}
+
+size_t ResolutionJournal::replay(const std::string& fileName, uint64_t stateId, ContentMapper& contentMapper)
+{
+    std::ifstream input(fileName, std::ios::binary);
+    std::vector<char> journal((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    size_t offset = sizeof(MAGIC) + sizeof(stateId);
+    if(journal.size() < offset ||
+       memcmp(journal.data(), MAGIC, sizeof(MAGIC)) != 0 ||
+       memcmp(journal.data() + sizeof(MAGIC), &stateId, sizeof(stateId)) != 0)
+    {
+        return 0;
+    }
+
+    size_t nrOfActions = 0;
+    while(offset + sizeof(RecordHeader) <= journal.size())
+    {
+        RecordHeader header;
+        memcpy(&header, journal.data() + offset, sizeof(header));
+        const char *payload = journal.data() + offset + sizeof(header);
+        if(header.payloadSize > journal.size() - offset - sizeof(header) ||
+           checksum(payload, header.payloadSize) != header.checksum)
+        {
+            break;
+        }
+
+        PayloadReader reader(payload, header.payloadSize);
+        if(!replayAction(reader, contentMapper))
+        {
+            break;
+        }
+        offset += sizeof(header) + header.payloadSize;
+        nrOfActions++;
+    }
+
+    /* Actions appended after a damaged record would never be replayed */
+    if(offset < journal.size() && truncate(fileName.c_str(), static_cast<off_t>(offset)) == -1)
+    {
+        throw std::runtime_error("Failed to cut off the damaged end of the resolution journal");
+    }
+    return nrOfActions;
+}
+
+void ResolutionJournal::sync()
+{
+    if(fsync(m_fd) == -1)
+    {
+        throw std::runtime_error("Failed to flush resolution journal");
+    }
+    m_unsyncedActions = 0;
+}
+
+void ResolutionJournal::sectionToggled(size_t sectionIndex, LineSource lineSource)
+{
+    std::vector<char> payload;
+    appendValue(payload, ActionType::TOGGLE);
+    appendValue(payload, static_cast<uint64_t>(sectionIndex));
+    appendValue(payload, static_cast<uint8_t>(lineSource));
+    append(payload);
+}
+
+void ResolutionJournal::modificationApplied(const Modification& modification)
+{
+    std::vector<char> payload;
+    appendValue(payload, ActionType::MODIFICATION);
+    appendValue(payload, static_cast<int32_t>(modification.firstLine));
+    appendValue(payload, static_cast<int32_t>(modification.originalLineCount));
+    appendValue(payload, static_cast<uint32_t>(modification.lines.size()));
+    for(auto& line: modification.lines)
+    {
+        appendValue(payload, static_cast<uint32_t>(line.size()));
+        payload.insert(payload.end(), line.begin(), line.end());
+    }
+    append(payload);
+}
+
+void ResolutionJournal::actionUndone()
+{
+    std::vector<char> payload;
+    appendValue(payload, ActionType::UNDO);
+    append(payload);
+}
+
+void ResolutionJournal::actionRedone()
+{
+    std::vector<char> payload;
+    appendValue(payload, ActionType::REDO);
+    append(payload);
+}
+
+/**
+ * Writes a record with a single write, so that the records of a journal
+ * are only ever cut off at the end.
+ */
+void ResolutionJournal::append(const std::vector<char>& payload)
+{
+    RecordHeader header{ static_cast<uint32_t>(payload.size()), checksum(payload.data(), payload.size()) };
+    std::vector<char> record(reinterpret_cast<const char *>(&header),
+                             reinterpret_cast<const char *>(&header) + sizeof(header));
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    size_t written = 0;
+    while(written < record.size())
+    {
+        ssize_t count = write(m_fd, record.data() + written, record.size() - written);
+        if(count == -1)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error("Failed to write resolution journal");
+        }
+        written += static_cast<size_t>(count);
+    }
+
+    if(++m_unsyncedActions == SYNC_INTERVAL)
+    {
+        sync();
+    }
+}
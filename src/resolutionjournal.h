@@ -0,0 +1,87 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "contentmapper.h"
+
+/**
+ * An append-only record of the actions on a merge result, so that they can
+ * be replayed on top of the merge state they were done on after tdiff3 was
+ * stopped.
+ *
+ * Every action is written as soon as it has been done, so it survives tdiff3
+ * itself crashing. Flushing actions to disk is far more expensive, so that
+ * is done for batches of actions. A record that was only written in part
+ * when the system went down is recognized by its checksum and dropped,
+ * together with everything after it.
+ */
+class ResolutionJournal: public IActionListener
+{
+public:
+    /**
+     * Opens a journal for actions on the merge state with the specified ID.
+     * Actions are appended after those of an existing journal for that
+     * state, which must have been replayed. Throws a std::runtime_error if
+     * the journal cannot be opened.
+     */
+    ResolutionJournal(const std::string& fileName, uint64_t stateId);
+    virtual ~ResolutionJournal();
+
+    ResolutionJournal(const ResolutionJournal&) = delete;
+    ResolutionJournal& operator=(const ResolutionJournal&) = delete;
+
+    /**
+     * Replays the actions of a journal for the merge state with the
+     * specified ID, which the content mapper must have just been given. A
+     * journal for another state is ignored. A damaged end of the journal is
+     * cut off, so that new actions follow the last valid one. Returns the
+     * number of actions that were replayed.
+     */
+    static size_t replay(const std::string& fileName, uint64_t stateId, ContentMapper& contentMapper);
+
+    /**
+     * Flushes all actions that have been written to disk.
+     */
+    void sync();
+
+    virtual void sectionToggled(size_t sectionIndex, LineSource lineSource) override;
+    virtual void modificationApplied(const Modification& modification) override;
+    virtual void actionUndone() override;
+    virtual void actionRedone() override;
+
+private:
+    void append(const std::vector<char>& payload);
+
+    /** The number of actions after which they are flushed to disk */
+    static constexpr unsigned SYNC_INTERVAL = 64;
+
+    int m_fd;
+    unsigned m_unsyncedActions = 0;
+};
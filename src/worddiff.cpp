@@ -0,0 +1,314 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+#if defined __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "diff.h"
+#include "worddiff.h"
+
+/* Lines that need more edits than this are not diffed token by token beyond
+ * their common start and end, which bounds the time and memory needed */
+static const int maxEditDistance = 512;
+
+static bool isWordCharacter(unsigned char c)
+{
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '_' || c >= 0x80;
+}
+
+static bool isSpaceCharacter(unsigned char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/**
+ * Classifies up to 64 bytes at once, setting bit i of wordMask or spaceMask
+ * if byte i is a word or whitespace character.
+ */
+static void classifyBlock(const char *p, size_t n, uint64_t& wordMask, uint64_t& spaceMask)
+{
+    wordMask = 0;
+    spaceMask = 0;
+    size_t i = 0;
+
+#if defined __SSE2__
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+
+        /* Bytes of 0x80 and above are negative when compared as signed */
+        __m128i word = _mm_cmplt_epi8(v, _mm_setzero_si128());
+        word = _mm_or_si128(word, _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                                _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1))));
+        word = _mm_or_si128(word, _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                                _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1))));
+        word = _mm_or_si128(word, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+
+        __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                                     _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')),
+                                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+
+        wordMask |= static_cast<uint64_t>(_mm_movemask_epi8(word) & 0xFFFF) << i;
+        spaceMask |= static_cast<uint64_t>(_mm_movemask_epi8(space) & 0xFFFF) << i;
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        auto c = static_cast<unsigned char>(p[i]);
+        wordMask |= static_cast<uint64_t>(isWordCharacter(c)) << i;
+        spaceMask |= static_cast<uint64_t>(isSpaceCharacter(c)) << i;
+    }
+}
+
+std::vector<size_t> findTokenStarts(std::string_view line)
+{
+    std::vector<size_t> starts;
+
+    /* Whether the byte before the current block is a word or space character */
+    uint64_t previousWord = 0;
+    uint64_t previousSpace = 0;
+
+    for(size_t offset = 0; offset < line.size(); offset += 64)
+    {
+        size_t n = std::min<size_t>(64, line.size() - offset);
+        uint64_t wordMask;
+        uint64_t spaceMask;
+        classifyBlock(line.data() + offset, n, wordMask, spaceMask);
+
+        /* A byte continues a token if it is of the same class as the byte
+         * before it and that class is word or space */
+        uint64_t continues = (wordMask & ((wordMask << 1) | previousWord)) |
+                             (spaceMask & ((spaceMask << 1) | previousSpace));
+        uint64_t validBytes = (n == 64) ? ~0ull : (1ull << n) - 1;
+        uint64_t startMask = ~continues & validBytes;
+
+        while(startMask != 0)
+        {
+            starts.push_back(offset + __builtin_ctzll(startMask));
+            startMask &= startMask - 1;
+        }
+
+        previousWord = (wordMask >> (n - 1)) & 1;
+        previousSpace = (spaceMask >> (n - 1)) & 1;
+    }
+
+    return starts;
+}
+
+namespace
+{
+
+struct Tokens
+{
+    std::vector<int> ids;
+    std::vector<size_t> starts;
+    size_t end;
+
+    size_t start(size_t index) const
+    {
+        return (index == starts.size()) ? end : starts[index];
+    }
+
+    size_t length(size_t from, size_t to) const
+    {
+        return start(to) - start(from);
+    }
+};
+
+}
+
+static Tokens tokenize(std::string_view line, std::unordered_map<std::string_view, int>& idsOfTokens)
+{
+    Tokens tokens;
+    tokens.starts = findTokenStarts(line);
+    tokens.end = line.size();
+    tokens.ids.reserve(tokens.starts.size());
+    for(size_t i = 0; i < tokens.starts.size(); i++)
+    {
+        auto token = line.substr(tokens.starts[i], tokens.length(i, i + 1));
+        auto [it, inserted] = idsOfTokens.try_emplace(token, static_cast<int>(idsOfTokens.size()));
+        tokens.ids.push_back(it->second);
+    }
+    return tokens;
+}
+
+/**
+ * Finds the shortest edit script between two token sequences with Myers'
+ * greedy algorithm and adds it to the builder. Returns false without adding
+ * anything if more than maxEditDistance edits are needed.
+ */
+static bool addShortestEditScript(const Tokens& tokens1, size_t first1, size_t last1,
+                                  const Tokens& tokens2, size_t first2, size_t last2,
+                                  DiffListBuilder& builder)
+{
+    int n = static_cast<int>(last1 - first1);
+    int m = static_cast<int>(last2 - first2);
+    int maxD = std::min(n + m, maxEditDistance);
+    int offset = maxD + 1;
+
+    /* The furthest x reached on every diagonal k = x - y, or -1 if the
+     * diagonal cannot be reached with the current number of edits */
+    std::vector<int> v(2 * offset + 1, -1);
+    std::vector<std::vector<int>> trace;
+
+    /* Returns the diagonal that the furthest point on diagonal k is reached
+     * from with one more edit, or offset if it cannot be reached */
+    auto previousDiagonal = [&](const std::vector<int>& vPrev, int k)
+    {
+        int xDown = vPrev[offset + k + 1];
+        int xRight = vPrev[offset + k - 1] == -1 ? -1 : vPrev[offset + k - 1] + 1;
+        bool downValid = xDown != -1 && xDown - k <= m;
+        bool rightValid = xRight != -1 && xRight <= n;
+        if(downValid && (!rightValid || xDown >= xRight))
+        {
+            return k + 1;
+        }
+        return rightValid ? k - 1 : offset;
+    };
+
+    int finalD = -1;
+    for(int d = 0; d <= maxD && finalD == -1; d++)
+    {
+        auto vPrev = v;
+        for(int k = -d; k <= d; k += 2)
+        {
+            int x;
+            if(d == 0)
+            {
+                x = 0;
+            }
+            else
+            {
+                int prevK = previousDiagonal(vPrev, k);
+                if(prevK == offset)
+                {
+                    v[offset + k] = -1;
+                    continue;
+                }
+                x = (prevK == k + 1) ? vPrev[offset + prevK] : vPrev[offset + prevK] + 1;
+            }
+
+            int y = x - k;
+            while(x < n && y < m && tokens1.ids[first1 + x] == tokens2.ids[first2 + y])
+            {
+                x++;
+                y++;
+            }
+            v[offset + k] = x;
+            if(x == n && y == m)
+            {
+                finalD = d;
+            }
+        }
+        trace.push_back(v);
+    }
+
+    if(finalD == -1)
+    {
+        return false;
+    }
+
+    /* Walk back from the end. Every edit is followed by a run of equal
+     * tokens, and there is a run of equal tokens before the first edit. */
+    struct Edit
+    {
+        int fromX;
+        int fromY;
+        int toX;
+        int toY;
+        int endX;
+    };
+    std::vector<Edit> edits;
+    int x = n;
+    int y = m;
+    for(int d = finalD; d > 0; d--)
+    {
+        int k = x - y;
+        int prevK = previousDiagonal(trace[d - 1], k);
+        int prevX = trace[d - 1][offset + prevK];
+        int prevY = prevX - prevK;
+        int toX = (prevK == k + 1) ? prevX : prevX + 1;
+        edits.push_back(Edit{prevX, prevY, toX, toX - k, x});
+        x = prevX;
+        y = prevY;
+    }
+
+    builder.addEqual(static_cast<int>(tokens1.length(first1, first1 + x)));
+    for(auto it = edits.rbegin(); it != edits.rend(); ++it)
+    {
+        builder.addDifferent(static_cast<int>(tokens1.length(first1 + it->fromX, first1 + it->toX)),
+                             static_cast<int>(tokens2.length(first2 + it->fromY, first2 + it->toY)));
+        builder.addEqual(static_cast<int>(tokens1.length(first1 + it->toX, first1 + it->endX)));
+    }
+
+    return true;
+}
+
+DiffList calcWordDiff(std::string_view line1, std::string_view line2)
+{
+    std::unordered_map<std::string_view, int> idsOfTokens;
+    auto tokens1 = tokenize(line1, idsOfTokens);
+    auto tokens2 = tokenize(line2, idsOfTokens);
+
+    /* Equal tokens at the start and at the end need no search */
+    size_t n1 = tokens1.ids.size();
+    size_t n2 = tokens2.ids.size();
+    size_t prefix = 0;
+    while(prefix < n1 && prefix < n2 && tokens1.ids[prefix] == tokens2.ids[prefix])
+    {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while(suffix < n1 - prefix && suffix < n2 - prefix &&
+          tokens1.ids[n1 - suffix - 1] == tokens2.ids[n2 - suffix - 1])
+    {
+        suffix++;
+    }
+
+    DiffListBuilder builder;
+    builder.addEqual(static_cast<int>(tokens1.length(0, prefix)));
+    if(!addShortestEditScript(tokens1, prefix, n1 - suffix, tokens2, prefix, n2 - suffix, builder))
+    {
+        builder.addDifferent(static_cast<int>(tokens1.length(prefix, n1 - suffix)),
+                             static_cast<int>(tokens2.length(prefix, n2 - suffix)));
+    }
+    builder.addEqual(static_cast<int>(tokens1.length(n1 - suffix, n1)));
+
+    DiffList diffList = builder.finish();
+    if(diffList.empty())
+    {
+        diffList.push_back(Diff(0, 0, 0));
+    }
+    return diffList;
+}
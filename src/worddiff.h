@@ -0,0 +1,47 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * Returns the offsets at which the tokens of a line start. A token is a run
+ * of word characters (letters, digits, underscores and all non-ASCII bytes),
+ * a run of whitespace or a single punctuation character.
+ */
+std::vector<size_t> findTokenStarts(std::string_view line);
+
+/**
+ * Calculates the differences between two lines token by token instead of
+ * character by character. The diff list still counts bytes, but equal and
+ * different stretches always consist of whole tokens, so a changed word is
+ * shown as one different stretch instead of a mix of equal and different
+ * characters.
+ */
+DiffList calcWordDiff(std::string_view line1, std::string_view line2);
@@ -0,0 +1,117 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+
+#include <algorithm>
+
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(unsigned nrOfThreads)
+{
+    for(unsigned worker = 0; worker < nrOfThreads; worker++)
+    {
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, worker);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_jobStarted.notify_all();
+    for(auto& thread: m_threads)
+    {
+        thread.join();
+    }
+}
+
+unsigned WorkerPool::concurrency() const
+{
+    return static_cast<unsigned>(m_threads.size()) + 1;
+}
+
+void WorkerPool::run(size_t nrOfTasks, const Task& task)
+{
+    std::lock_guard<std::mutex> jobLock(m_jobMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_nrOfTasks = nrOfTasks;
+        m_nextTask = 0;
+        m_busyWorkers = static_cast<unsigned>(m_threads.size());
+        m_jobNumber++;
+    }
+    m_jobStarted.notify_all();
+
+    /* The calling thread is the last worker */
+    runTasks(static_cast<unsigned>(m_threads.size()));
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_jobFinished.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void WorkerPool::workerLoop(unsigned worker)
+{
+    unsigned lastJobNumber = 0;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while(true)
+    {
+        m_jobStarted.wait(lock, [&] { return m_stop || m_jobNumber != lastJobNumber; });
+        if(m_stop)
+        {
+            return;
+        }
+        lastJobNumber = m_jobNumber;
+
+        lock.unlock();
+        runTasks(worker);
+        lock.lock();
+
+        if(--m_busyWorkers == 0)
+        {
+            m_jobFinished.notify_one();
+        }
+    }
+}
+
+void WorkerPool::runTasks(unsigned worker)
+{
+    size_t task;
+    while((task = m_nextTask++) < m_nrOfTasks)
+    {
+        (*m_task)(task, worker);
+    }
+}
+
+WorkerPool& WorkerPool::shared()
+{
+    static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+    return pool;
+}
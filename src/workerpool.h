@@ -0,0 +1,96 @@
+/*
+ * tdiff3 - a text-based 3-way diff/merge tool that can handle large files
+ * Copyright (C) 2023  Maurice van der Pot <griffon26@kfk4ever.com>
+ *
+ * This file is part of tdiff3.
+ *
+ * tdiff3 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * tdiff3 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with tdiff3; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/**
+ * Authors: Maurice van der Pot
+ * License: $(LINK2 http://www.gnu.org/licenses/gpl-2.0.txt, GNU GPL v2.0) or later.
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that carry out the tasks of one job at a time.
+ *
+ * A job consists of a number of tasks that are identified by their index.
+ * Threads take the next task as soon as they are done with the previous one,
+ * so tasks of different sizes are spread evenly. The thread that runs the
+ * job takes part as well.
+ *
+ * Every task is told which worker runs it, so a job can give each worker
+ * its own scratch buffers instead of allocating them per task.
+ */
+class WorkerPool
+{
+public:
+    using Task = std::function<void(size_t task, unsigned worker)>;
+
+    explicit WorkerPool(unsigned nrOfThreads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * Returns the number of workers that can run tasks at the same time,
+     * including the thread that runs the job. Worker indices passed to tasks
+     * are lower than this.
+     */
+    unsigned concurrency() const;
+
+    /**
+     * Runs tasks 0 to nrOfTasks - 1 and returns when all of them are done.
+     * Tasks must not run jobs on the same pool themselves.
+     */
+    void run(size_t nrOfTasks, const Task& task);
+
+    /**
+     * Returns the pool that is shared by all parallel stages, with a thread
+     * per core besides the one that uses it.
+     */
+    static WorkerPool& shared();
+
+private:
+    void workerLoop(unsigned worker);
+    void runTasks(unsigned worker);
+
+    std::vector<std::thread> m_threads;
+
+    /** Allows only one job at a time */
+    std::mutex m_jobMutex;
+
+    /** Protects the members below */
+    std::mutex m_mutex;
+    std::condition_variable m_jobStarted;
+    std::condition_variable m_jobFinished;
+    bool m_stop = false;
+    unsigned m_jobNumber = 0;
+    const Task* m_task = nullptr;
+    size_t m_nrOfTasks = 0;
+    unsigned m_busyWorkers = 0;
+
+    std::atomic<size_t> m_nextTask{0};
+};
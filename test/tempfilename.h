@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+
+/*
+ * Returns the name of a file in the temporary directory that no other test
+ * uses, so that tests can run in parallel.
+ */
+inline std::string tempFileName(const std::string& name)
+{
+    auto testInfo = testing::UnitTest::GetInstance()->current_test_info();
+    return testing::TempDir() + "tdiff3_" + testInfo->test_suite_name() + "_" + testInfo->name() + "_" +
+           std::to_string(getpid()) + "_" + name;
+}
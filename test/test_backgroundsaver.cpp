@@ -0,0 +1,121 @@
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/backgroundsaver.h"
+#include "tempfilename.h"
+#include "vectorlineprovider.h"
+
+static std::vector<std::string> numberedLines(const std::string& prefix, int count)
+{
+    std::vector<std::string> lines;
+    for(int i = 0; i < count; i++)
+    {
+        lines.push_back(prefix + std::to_string(i) + "\n");
+    }
+    return lines;
+}
+
+static std::string readFile(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+class TestBackgroundSaver: public testing::Test
+{
+protected:
+    TestBackgroundSaver():
+        lpA(numberedLines("line ", 100000)),
+        lpB(numberedLines("line ", 100000)),
+        lpC(numberedLines("line ", 100000)),
+        lineProviders{ &lpA, &lpB, &lpC },
+        labels{ "a", "b", "c" },
+        fileName(tempFileName("merge_result"))
+    {
+        Diff3Table diff3Table;
+        for(int i = 0; i < 100000; i++)
+        {
+            diff3Table.push_back(Diff3Line{ i, i, i, true, true, true });
+        }
+        contentMapper.determineMergeResultSections(diff3Table);
+    }
+
+    ~TestBackgroundSaver()
+    {
+        remove(fileName.c_str());
+    }
+
+    std::string mergeResult()
+    {
+        std::ostringstream output;
+        writeMergeResult(output, contentMapper, lineProviders, labels);
+        return output.str();
+    }
+
+    VectorLineProvider lpA, lpB, lpC;
+    std::vector<ILineProvider*> lineProviders;
+    std::vector<std::string> labels;
+    std::string fileName;
+    ContentMapper contentMapper;
+};
+
+TEST_F(TestBackgroundSaver, edits_after_a_save_is_requested_are_not_saved)
+{
+    BackgroundSaver saver(1);
+    ASSERT_EQ(saver.getStatus().state, BackgroundSaver::State::IDLE);
+
+    auto expected = mergeResult();
+    saver.save(contentMapper, fileName, lineProviders, labels);
+    for(int i = 0; i < 1000; i++)
+    {
+        contentMapper.applyModification(Modification{ i * 50, 1, { "edited\n" } });
+    }
+    saver.wait();
+
+    auto status = saver.getStatus();
+    ASSERT_EQ(status.state, BackgroundSaver::State::SAVED);
+    ASSERT_EQ(status.conflicts, 0u);
+    ASSERT_EQ(readFile(fileName), expected);
+}
+
+TEST_F(TestBackgroundSaver, a_later_save_supersedes_an_earlier_one)
+{
+    BackgroundSaver saver(1);
+
+    for(int i = 0; i < 20; i++)
+    {
+        contentMapper.applyModification(Modification{ i, 1, { "save " + std::to_string(i) + "\n" } });
+        saver.save(contentMapper, fileName, lineProviders, labels);
+    }
+    saver.wait();
+
+    ASSERT_EQ(saver.getStatus().state, BackgroundSaver::State::SAVED);
+    ASSERT_EQ(readFile(fileName), mergeResult());
+}
+
+TEST_F(TestBackgroundSaver, failures_are_reported)
+{
+    BackgroundSaver saver(1);
+
+    saver.save(contentMapper, testing::TempDir() + "no/such/directory/file", lineProviders, labels);
+    saver.wait();
+
+    auto status = saver.getStatus();
+    ASSERT_EQ(status.state, BackgroundSaver::State::FAILED);
+    ASSERT_FALSE(status.error.empty());
+}
+
+TEST_F(TestBackgroundSaver, destroying_the_saver_finishes_the_save)
+{
+    contentMapper.applyModification(Modification{ 0, 1, { "last save\n" } });
+    {
+        BackgroundSaver saver(1);
+        saver.save(contentMapper, fileName, lineProviders, labels);
+    }
+
+    ASSERT_EQ(readFile(fileName), mergeResult());
+}
@@ -0,0 +1,37 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../src/bytecompare.h"
+
+TEST(TestByteCompare, common_prefix)
+{
+    ASSERT_EQ(commonPrefixLength("", ""), 0u);
+    ASSERT_EQ(commonPrefixLength("abc", ""), 0u);
+    ASSERT_EQ(commonPrefixLength("abc", "abc"), 3u);
+    ASSERT_EQ(commonPrefixLength("abc", "abd"), 2u);
+    ASSERT_EQ(commonPrefixLength("abc", "abcdef"), 3u);
+    ASSERT_EQ(commonPrefixLength("0123456789abcdef", "0123456789abcdeX"), 15u);
+}
+
+TEST(TestByteCompare, common_suffix)
+{
+    ASSERT_EQ(commonSuffixLength("", ""), 0u);
+    ASSERT_EQ(commonSuffixLength("abc", ""), 0u);
+    ASSERT_EQ(commonSuffixLength("abc", "abc"), 3u);
+    ASSERT_EQ(commonSuffixLength("abc", "xbc"), 2u);
+    ASSERT_EQ(commonSuffixLength("def", "abcdef"), 3u);
+    ASSERT_EQ(commonSuffixLength("X123456789abcdef", "0123456789abcdef"), 15u);
+}
+
+TEST(TestByteCompare, mismatch_in_every_position_of_large_input)
+{
+    std::string a(10000, 'x');
+
+    for(size_t i = 0; i < a.size(); i += 7)
+    {
+        std::string b = a;
+        b[i] = 'y';
+        ASSERT_EQ(commonPrefixLength(a, b), i);
+        ASSERT_EQ(commonSuffixLength(a, b), a.size() - i - 1);
+    }
+}
@@ -0,0 +1,58 @@
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/chunkedvector.h"
+
+static std::vector<int> toVector(const ChunkedVector<int>& chunkedVector)
+{
+    std::vector<int> elements;
+    for(size_t i = 0; i < chunkedVector.size(); i++)
+    {
+        elements.push_back(chunkedVector[i]);
+    }
+    return elements;
+}
+
+TEST(TestChunkedVector, holds_the_elements_it_is_built_from)
+{
+    /* Not a multiple of the chunk size, so the last chunk is partial */
+    std::vector<int> elements;
+    for(int i = 0; i < 1000; i++)
+    {
+        elements.push_back(i * 3);
+    }
+
+    ChunkedVector<int> chunkedVector(elements);
+    ASSERT_EQ(chunkedVector.size(), elements.size());
+    ASSERT_EQ(toVector(chunkedVector), elements);
+
+    ASSERT_TRUE(ChunkedVector<int>().empty());
+    ASSERT_EQ(toVector(ChunkedVector<int>(5, 7)), std::vector<int>(5, 7));
+}
+
+TEST(TestChunkedVector, changes_after_copying_do_not_affect_the_other_copy)
+{
+    ChunkedVector<int> original(1000, 0);
+    auto copy = original;
+
+    original.modify(0) = 1;
+    original.modify(1) = 2;
+    copy.modify(999) = 3;
+    ASSERT_EQ(original[0], 1);
+    ASSERT_EQ(original[1], 2);
+    ASSERT_EQ(original[999], 0);
+    ASSERT_EQ(copy[0], 0);
+    ASSERT_EQ(copy[1], 0);
+    ASSERT_EQ(copy[999], 3);
+
+    /* A copy of a copy shares with both of them */
+    auto copyOfCopy = copy;
+    copy.modify(999) = 4;
+    ASSERT_EQ(copyOfCopy[999], 3);
+    ASSERT_EQ(original[999], 0);
+
+    original = copy;
+    original.modify(500) = 5;
+    ASSERT_EQ(original[999], 4);
+    ASSERT_EQ(copy[500], 0);
+}
@@ -0,0 +1,471 @@
+#include <tuple>
+
+#include "gtest/gtest.h"
+#include "../src/contentmapper.h"
+
+using SectionTuple = std::tuple<bool, int, int, int, int, int, int, int, int>;
+
+static std::vector<SectionTuple> toTuples(const MergeResultSections& sections)
+{
+    std::vector<SectionTuple> sectionTuples;
+    for(auto& section: sections)
+    {
+        auto a = section.getLineNumberRange(LineSource::A);
+        auto b = section.getLineNumberRange(LineSource::B);
+        auto c = section.getLineNumberRange(LineSource::C);
+        auto d3l = section.getDiff3LineNumberRange();
+        sectionTuples.emplace_back(section.isDifference(),
+                                   a.firstLine, a.lastLine,
+                                   b.firstLine, b.lastLine,
+                                   c.firstLine, c.lastLine,
+                                   d3l.firstLine, d3l.lastLine);
+    }
+    return sectionTuples;
+}
+
+static std::vector<SectionTuple> calculateSections(const std::vector<Diff3Line>& d3ls)
+{
+    Diff3Table diff3Table;
+    for(auto& d3l: d3ls)
+    {
+        diff3Table.push_back(d3l);
+    }
+    return toTuples(ContentMapper::calculateMergeResultSections(diff3Table));
+}
+
+TEST(TestContentMapper, single_one_line_non_difference_section)
+{
+    auto sections = calculateSections({ Diff3Line{ 1, 11, 21, true, true, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(false, 1, 1, 11, 11, 21, 21, 0, 0),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, single_multi_line_non_difference_section)
+{
+    auto sections = calculateSections({ Diff3Line{ 0, 10, 20, true, true, true },
+                                        Diff3Line{ 1, 11, 21, true, true, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(false, 0, 1, 10, 11, 20, 21, 0, 1),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, single_multi_line_difference_section)
+{
+    auto sections = calculateSections({ Diff3Line{ 0, 10, 20, false, true, true },
+                                        Diff3Line{ 1, 11, 21, false, true, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, 0, 1, 10, 11, 20, 21, 0, 1),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, differently_differing_sections)
+{
+    auto sections = calculateSections({ Diff3Line{ 0, 10, 20, false, true, true },
+                                        Diff3Line{ 1, 11, 21, false, true, true },
+                                        Diff3Line{ 2, 12, 22, true, false, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, 0, 1, 10, 11, 20, 21, 0, 1),
+        SectionTuple(true, 2, 2, 12, 12, 22, 22, 2, 2),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, difference_and_non_difference_section)
+{
+    auto sections = calculateSections({ Diff3Line{ 0, 10, 20, false, true, true },
+                                        Diff3Line{ 1, 11, 21, false, true, true },
+                                        Diff3Line{ 2, 12, 22, true, true, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, 0, 1, 10, 11, 20, 21, 0, 1),
+        SectionTuple(false, 2, 2, 12, 12, 22, 22, 2, 2),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, difference_sections_with_gaps)
+{
+    auto sections = calculateSections({ Diff3Line{ 0, 10, 20, false, true, true },
+                                        Diff3Line{ -1, 11, 21, false, true, true },
+                                        Diff3Line{ 2, 12, 22, true, false, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, 0, 0, 10, 11, 20, 21, 0, 1),
+        SectionTuple(true, 2, 2, 12, 12, 22, 22, 2, 2),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, difference_sections_without_lines_in_one_of_the_files)
+{
+    auto sections = calculateSections({ Diff3Line{ -1, 10, 20, false, true, true },
+                                        Diff3Line{ -1, 11, 21, false, true, true },
+                                        Diff3Line{ 2, 12, 22, true, false, true } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, -1, -1, 10, 11, 20, 21, 0, 1),
+        SectionTuple(true, 2, 2, 12, 12, 22, 22, 2, 2),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, difference_section_with_lines_of_a_file_only_in_later_rows)
+{
+    auto sections = calculateSections({ Diff3Line{ 1, -1, -1, false, false, false },
+                                        Diff3Line{ -1, 1, -1, false, false, false },
+                                        Diff3Line{ -1, 2, 1, false, false, false } });
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(true, 1, 1, 1, 2, 1, 1, 0, 2),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, adjacent_equal_runs_form_one_section)
+{
+    std::vector<Diff3Line> d3ls;
+    for(int i = 0; i < 1000; i++)
+    {
+        d3ls.push_back(Diff3Line{ i, i, i, true, true, true });
+    }
+    /* The lines of B skip one, which starts a new run but not a new section */
+    for(int i = 1000; i < 2000; i++)
+    {
+        d3ls.push_back(Diff3Line{ i, i + 1, i, true, true, true });
+    }
+    d3ls.push_back(Diff3Line{ 2000, -1, 2000, false, true, false });
+    d3ls.push_back(Diff3Line{ 2001, 2001, 2001, true, true, true });
+
+    auto sections = calculateSections(d3ls);
+
+    std::vector<SectionTuple> expected = {
+        SectionTuple(false, 0, 1999, 0, 2000, 0, 1999, 0, 1999),
+        SectionTuple(true, 2000, 2000, -1, -1, 2000, 2000, 2000, 2000),
+        SectionTuple(false, 2001, 2001, 2001, 2001, 2001, 2001, 2001, 2001),
+    };
+    ASSERT_EQ(sections, expected);
+}
+
+TEST(TestContentMapper, differences_are_resolved_automatically_where_possible)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, false, true, false });
+    diff3Table.push_back(Diff3Line{ 1, 1, 1, true, false, false });
+    diff3Table.push_back(Diff3Line{ 2, 2, 2, false, false, true });
+    diff3Table.push_back(Diff3Line{ 3, 3, 3, false, false, false });
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    contentMapper.automaticallyResolveDifferences(diff3Table);
+
+    ASSERT_EQ(contentMapper.getNumberOfSections(), 4u);
+    ASSERT_EQ(contentMapper.getSection(0).getLineInfo(0).source, LineSource::B);
+    ASSERT_EQ(contentMapper.getSection(1).getLineInfo(0).source, LineSource::C);
+    ASSERT_EQ(contentMapper.getSection(2).getLineInfo(0).source, LineSource::C);
+    ASSERT_FALSE(contentMapper.getSection(3).isSolved());
+    ASSERT_EQ(contentMapper.getSection(3).getLineInfo(0).state, LineState::UNSELECTED);
+}
+
+TEST(TestContentMapper, differences_are_resolved_with_line_equivalences_if_rows_do_not_line_up)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, true, true, true });
+    diff3Table.push_back(Diff3Line{ 1, -1, -1, false, false, false });
+    diff3Table.push_back(Diff3Line{ -1, 1, -1, false, false, false });
+    diff3Table.push_back(Diff3Line{ -1, -1, 1, false, false, false });
+    diff3Table.push_back(Diff3Line{ 2, 2, 2, true, true, true });
+    diff3Table.push_back(Diff3Line{ -1, 3, -1, false, false, false });
+    diff3Table.push_back(Diff3Line{ 3, 4, 3, true, true, true });
+    diff3Table.push_back(Diff3Line{ 4, 5, 4, false, false, false });
+
+    /* Line 1 of A and C is the same, line 3 of B was added and the last
+     * lines of all three files differ */
+    LineEquivalences lineEquivalences;
+    lineEquivalences.ids(0) = { 10, 20, 30, 40, 50 };
+    lineEquivalences.ids(1) = { 10, 21, 30, 60, 40, 51 };
+    lineEquivalences.ids(2) = { 10, 20, 30, 40, 52 };
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    contentMapper.automaticallyResolveDifferences(diff3Table, &lineEquivalences);
+
+    ASSERT_EQ(contentMapper.getNumberOfSections(), 6u);
+    ASSERT_EQ(contentMapper.getSection(1).getLineInfo(0).source, LineSource::B);
+    ASSERT_EQ(contentMapper.getSection(3).getLineInfo(0).source, LineSource::B);
+    ASSERT_FALSE(contentMapper.getSection(5).isSolved());
+
+    ContentMapper withoutLineEquivalences;
+    withoutLineEquivalences.determineMergeResultSections(diff3Table);
+    withoutLineEquivalences.automaticallyResolveDifferences(diff3Table);
+
+    ASSERT_FALSE(withoutLineEquivalences.getSection(1).isSolved());
+    ASSERT_FALSE(withoutLineEquivalences.getSection(3).isSolved());
+}
+
+TEST(TestContentMapper, merge_result_lines_are_found_in_their_sections)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, true, true, true });
+    diff3Table.push_back(Diff3Line{ 1, 1, 1, true, true, true });
+    diff3Table.push_back(Diff3Line{ 2, 2, -1, true, false, false });
+    diff3Table.push_back(Diff3Line{ 3, 3, -1, true, false, false });
+    diff3Table.push_back(Diff3Line{ 4, 4, 2, true, true, true });
+    diff3Table.push_back(Diff3Line{ 5, 5, 3, false, false, false });
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+
+    /* Two equal lines, a section without lines of C that is shown as a
+     * conflict, one equal line and another conflict */
+    ASSERT_EQ(contentMapper.getContentHeight(), 5);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(1).lineNumber, 1);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(2).state, LineState::UNSELECTED);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(3).lineNumber, 2);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(5).state, LineState::NONE);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(-1).state, LineState::NONE);
+
+    contentMapper.toggleSectionSource(1, LineSource::A);
+    contentMapper.toggleSectionSource(3, LineSource::B);
+    contentMapper.toggleSectionSource(3, LineSource::C);
+
+    ASSERT_EQ(contentMapper.getContentHeight(), 7);
+    auto lineInfo = contentMapper.getMergeResultLineInfo(3);
+    ASSERT_EQ(lineInfo.source, LineSource::A);
+    ASSERT_EQ(lineInfo.lineNumber, 3);
+    lineInfo = contentMapper.getMergeResultLineInfo(6);
+    ASSERT_EQ(lineInfo.source, LineSource::C);
+    ASSERT_EQ(lineInfo.lineNumber, 3);
+
+    auto sectionInfo = contentMapper.getSectionInfo(3);
+    ASSERT_EQ(sectionInfo.mergeResultPaneLineNumbers.firstLine, 5);
+    ASSERT_EQ(sectionInfo.mergeResultPaneLineNumbers.lastLine, 6);
+    ASSERT_EQ(sectionInfo.inputPaneLineNumbers.firstLine, 5);
+    ASSERT_TRUE(sectionInfo.isDifference);
+
+    /* Deselecting everything makes it an unresolved conflict again */
+    contentMapper.toggleSectionSource(1, LineSource::A);
+    ASSERT_EQ(contentMapper.getContentHeight(), 6);
+    ASSERT_EQ(contentMapper.getMergeResultLineInfo(2).state, LineState::UNSELECTED);
+}
+
+TEST(TestContentMapper, unsolved_differences_are_found_in_both_directions)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, false, false, false });
+    diff3Table.push_back(Diff3Line{ 1, 1, 1, true, true, true });
+    diff3Table.push_back(Diff3Line{ 2, 2, 2, true, false, false });
+    diff3Table.push_back(Diff3Line{ 3, 3, 3, true, true, true });
+    diff3Table.push_back(Diff3Line{ 4, 4, 4, false, false, false });
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    contentMapper.automaticallyResolveDifferences(diff3Table);
+
+    ASSERT_EQ(contentMapper.findNextDifference(-1), 0);
+    ASSERT_EQ(contentMapper.findNextDifference(0), 2);
+    ASSERT_EQ(contentMapper.findPreviousDifference(4), 2);
+    ASSERT_EQ(contentMapper.findPreviousDifference(0), -1);
+
+    /* Section 2 was resolved automatically */
+    ASSERT_EQ(contentMapper.findNextUnsolvedDifference(0), 4);
+    ASSERT_EQ(contentMapper.findPreviousUnsolvedDifference(4), 0);
+    ASSERT_FALSE(contentMapper.allDifferencesSolved());
+
+    contentMapper.toggleSectionSource(0, LineSource::A);
+    ASSERT_EQ(contentMapper.findPreviousUnsolvedDifference(4), -1);
+    ASSERT_EQ(contentMapper.findNextUnsolvedDifference(-1), 4);
+
+    contentMapper.toggleSectionSource(4, LineSource::B);
+    ASSERT_EQ(contentMapper.findNextUnsolvedDifference(-1), -1);
+    ASSERT_TRUE(contentMapper.allDifferencesSolved());
+
+    contentMapper.toggleSectionSource(4, LineSource::B);
+    ASSERT_EQ(contentMapper.findNextUnsolvedDifference(0), 4);
+    ASSERT_FALSE(contentMapper.allDifferencesSolved());
+}
+
+static std::vector<std::string> mergeResult(const ContentMapper& contentMapper)
+{
+    std::vector<std::string> lines;
+    for(int i = 0; i < contentMapper.getContentHeight(); i++)
+    {
+        auto lineInfo = contentMapper.getMergeResultLineInfo(i);
+        switch(lineInfo.state)
+        {
+        case LineState::ORIGINAL:
+            lines.push_back("ABC"[static_cast<int>(lineInfo.source)] + std::to_string(lineInfo.lineNumber));
+            break;
+        case LineState::EDITED:
+            if(lineInfo.lineNumber == -1)
+            {
+                lines.push_back("<no source line>");
+            }
+            else
+            {
+                lines.emplace_back(contentMapper.getEditedLine(lineInfo.sectionIndex, lineInfo.lineNumber));
+            }
+            break;
+        case LineState::UNSELECTED:
+            lines.push_back("<unresolved>");
+            break;
+        case LineState::NONE:
+            lines.push_back("<none>");
+            break;
+        }
+    }
+    return lines;
+}
+
+TEST(TestContentMapper, modifications_edit_the_merge_result)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, true, true, true });
+    diff3Table.push_back(Diff3Line{ 1, 1, 1, true, true, true });
+    diff3Table.push_back(Diff3Line{ 2, 2, 2, false, false, false });
+    diff3Table.push_back(Diff3Line{ 3, 3, 3, true, true, true });
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    ASSERT_EQ(mergeResult(contentMapper), (std::vector<std::string>{ "C0", "C1", "<unresolved>", "C3" }));
+
+    contentMapper.applyModification(Modification{ 1, 0, { "x", "y" } });
+    ASSERT_EQ(mergeResult(contentMapper), (std::vector<std::string>{ "C0", "x", "y", "C1", "<unresolved>", "C3" }));
+
+    /* Replacing the last line of the first section and the conflict removes
+     * the conflict's line from the second section */
+    contentMapper.applyModification(Modification{ 3, 2, { "z" } });
+    ASSERT_EQ(mergeResult(contentMapper), (std::vector<std::string>{ "C0", "x", "y", "z", "<no source line>", "C3" }));
+    ASSERT_EQ(contentMapper.getSectionInfo(1).mergeResultPaneLineNumbers.firstLine, 4);
+
+    /* Choosing a source discards the edits of that section */
+    contentMapper.toggleSectionSource(1, LineSource::A);
+    ASSERT_EQ(mergeResult(contentMapper), (std::vector<std::string>{ "C0", "x", "y", "z", "A2", "C3" }));
+}
+
+TEST(TestContentMapper, toggles_and_modifications_are_undone_and_redone)
+{
+    Diff3Table diff3Table;
+    diff3Table.push_back(Diff3Line{ 0, 0, 0, true, true, true });
+    diff3Table.push_back(Diff3Line{ 1, 1, 1, false, false, false });
+    diff3Table.push_back(Diff3Line{ 2, 2, 2, true, true, true });
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    auto initial = mergeResult(contentMapper);
+    ASSERT_FALSE(contentMapper.undo());
+
+    contentMapper.toggleSectionSource(1, LineSource::B);
+    auto toggled = mergeResult(contentMapper);
+    contentMapper.applyModification(Modification{ 0, 2, { "x" } });
+    auto modified = mergeResult(contentMapper);
+    ASSERT_EQ(modified, (std::vector<std::string>{ "x", "<no source line>", "C2" }));
+    ASSERT_EQ(contentMapper.getHistorySize(), 2u);
+
+    ASSERT_TRUE(contentMapper.undo());
+    ASSERT_EQ(mergeResult(contentMapper), toggled);
+    ASSERT_TRUE(contentMapper.undo());
+    ASSERT_EQ(mergeResult(contentMapper), initial);
+    ASSERT_FALSE(contentMapper.allDifferencesSolved());
+    ASSERT_FALSE(contentMapper.undo());
+
+    ASSERT_TRUE(contentMapper.redo());
+    ASSERT_EQ(mergeResult(contentMapper), toggled);
+    ASSERT_TRUE(contentMapper.allDifferencesSolved());
+    ASSERT_TRUE(contentMapper.redo());
+    ASSERT_EQ(mergeResult(contentMapper), modified);
+    ASSERT_FALSE(contentMapper.redo());
+
+    /* A new action discards the undone ones */
+    contentMapper.undo();
+    contentMapper.toggleSectionSource(1, LineSource::A);
+    ASSERT_EQ(contentMapper.getHistoryPosition(), 2u);
+    ASSERT_EQ(contentMapper.getHistorySize(), 2u);
+    ASSERT_FALSE(contentMapper.redo());
+    ASSERT_EQ(mergeResult(contentMapper), (std::vector<std::string>{ "C0", "B1", "A1", "C2" }));
+}
+
+TEST(TestContentMapper, any_history_position_can_be_reached)
+{
+    Diff3Table diff3Table;
+    for(int i = 0; i < 20; i++)
+    {
+        bool equal = i % 3 != 1;
+        diff3Table.push_back(Diff3Line{ i, i, i, equal, equal, equal });
+    }
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    std::vector<std::vector<std::string>> results{ mergeResult(contentMapper) };
+
+    unsigned seed = 1;
+    auto random = [&seed](int n) { seed = seed * 1103515245 + 12345; return static_cast<int>((seed >> 16) % n); };
+    for(int action = 0; action < 50; action++)
+    {
+        if(random(2) == 0)
+        {
+            /* Every other section is a difference */
+            size_t sectionIndex = static_cast<size_t>(2 * random(static_cast<int>(contentMapper.getNumberOfSections() / 2)) + 1);
+            ASSERT_TRUE(contentMapper.getSection(sectionIndex).isDifference());
+            contentMapper.toggleSectionSource(sectionIndex, static_cast<LineSource>(random(3)));
+        }
+        else
+        {
+            int height = contentMapper.getContentHeight();
+            int firstLine = random(height + 1);
+            int count = random(std::min(3, height - firstLine) + 1);
+            contentMapper.applyModification(Modification{ firstLine, count, { "e" + std::to_string(action) } });
+        }
+        results.push_back(mergeResult(contentMapper));
+    }
+
+    ASSERT_EQ(contentMapper.getHistorySize(), results.size() - 1);
+    for(int jump = 0; jump < 30; jump++)
+    {
+        size_t position = static_cast<size_t>(random(static_cast<int>(results.size())));
+        contentMapper.goToHistoryPosition(position);
+        ASSERT_EQ(mergeResult(contentMapper), results[position]);
+    }
+}
+
+TEST(TestContentMapper, snapshots_keep_their_content_while_the_original_changes)
+{
+    /* Enough sections to fill several chunks */
+    Diff3Table diff3Table;
+    for(int i = 0; i < 2000; i++)
+    {
+        bool equal = i % 2 == 0;
+        diff3Table.push_back(Diff3Line{ i, i, i, equal, equal, equal });
+    }
+
+    ContentMapper contentMapper;
+    contentMapper.determineMergeResultSections(diff3Table);
+    contentMapper.toggleSectionSource(1, LineSource::A);
+
+    std::vector<ContentMapper> snapshots;
+    std::vector<std::vector<std::string>> results;
+    for(int round = 0; round < 3; round++)
+    {
+        snapshots.push_back(contentMapper.createSnapshot());
+        results.push_back(mergeResult(contentMapper));
+        for(size_t sectionIndex = 1; sectionIndex < contentMapper.getNumberOfSections(); sectionIndex += 2 * (round + 1))
+        {
+            contentMapper.toggleSectionSource(sectionIndex, LineSource::B);
+        }
+        contentMapper.applyModification(Modification{ 10 * round, 2, { "round " + std::to_string(round) } });
+    }
+
+    for(size_t i = 0; i < snapshots.size(); i++)
+    {
+        ASSERT_EQ(mergeResult(snapshots[i]), results[i]);
+        ASSERT_EQ(snapshots[i].getHistorySize(), 0u);
+    }
+    ASSERT_NE(mergeResult(contentMapper), results.back());
+}
@@ -0,0 +1,1217 @@
+#include <cstdlib>
+#include <list>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <tuple>
+
+#include "gtest/gtest.h"
+#include "../src/diff.h"
+#include "vectorlineprovider.h"
+
+using Row = std::tuple<bool, bool, bool, int, int, int>;
+
+static std::vector<Row> toRows(Diff3Table& d3ll)
+{
+    std::vector<Row> rows;
+    for(size_t i = 0; i < d3ll.size(); i++)
+    {
+        auto d3l = d3ll.get(i);
+        rows.emplace_back(d3l.bAEqB, d3l.bAEqC, d3l.bBEqC, d3l.lineA, d3l.lineB, d3l.lineC);
+    }
+    return rows;
+}
+
+static std::vector<Row> toRows(std::vector<Diff3Line>& d3ll)
+{
+    std::vector<Row> rows;
+    for(auto& d3l: d3ll)
+    {
+        rows.emplace_back(d3l.bAEqB, d3l.bAEqC, d3l.bBEqC, d3l.lineA, d3l.lineB, d3l.lineC);
+    }
+    return rows;
+}
+
+/*
+ * Straightforward translations of the algorithms in diff.d that have been
+ * replaced by faster ones, used as a reference for their results.
+ */
+namespace reference
+{
+
+using List = std::list<Diff3Line>;
+using It = List::iterator;
+
+void updateUsingAB(const DiffList& diffList12, List& d3ll)
+{
+    int lineA = 0;
+    int lineB = 0;
+
+    for(auto d: diffList12)
+    {
+        for(; d.nofEquals > 0; d.nofEquals--)
+        {
+            Diff3Line d3l;
+            d3l.bAEqB = true;
+            d3l.lineA = lineA++;
+            d3l.lineB = lineB++;
+            d3ll.push_back(d3l);
+        }
+        for(; d.diff1 > 0 && d.diff2 > 0; d.diff1--, d.diff2--)
+        {
+            Diff3Line d3l;
+            d3l.lineA = lineA++;
+            d3l.lineB = lineB++;
+            d3ll.push_back(d3l);
+        }
+        for(; d.diff1 > 0; d.diff1--)
+        {
+            Diff3Line d3l;
+            d3l.lineA = lineA++;
+            d3ll.push_back(d3l);
+        }
+        for(; d.diff2 > 0; d.diff2--)
+        {
+            Diff3Line d3l;
+            d3l.lineB = lineB++;
+            d3ll.push_back(d3l);
+        }
+    }
+}
+
+void updateUsingAC(const DiffList& diffList13, List& d3ll)
+{
+    int lineA = 0;
+    int lineC = 0;
+    It r3 = d3ll.begin();
+
+    for(auto d: diffList13)
+    {
+        for(; d.nofEquals > 0; d.nofEquals--)
+        {
+            while(r3->lineA != lineA)
+            {
+                ++r3;
+            }
+            r3->lineC = lineC;
+            r3->bAEqC = true;
+            r3->bBEqC = r3->bAEqB;
+            lineA++;
+            lineC++;
+            ++r3;
+        }
+        lineA += d.diff1;
+        for(; d.diff2 > 0; d.diff2--)
+        {
+            Diff3Line d3l;
+            d3l.lineC = lineC++;
+            d3ll.insert(r3, d3l);
+        }
+    }
+}
+
+void moveLowerLineUp(List& d3ll, It r3b, It r3c)
+{
+    It r3b1 = r3b;
+    It r3c1 = r3c;
+    while(r3b1 != r3c && r3c1 != r3b)
+    {
+        if(r3b1 != d3ll.end()) ++r3b1;
+        if(r3c1 != d3ll.end()) ++r3c1;
+    }
+
+    bool bFirst = (r3b1 == r3c);
+    auto leftEqualToA = [bFirst](Diff3Line& d3l) -> bool& { return bFirst ? d3l.bAEqB : d3l.bAEqC; };
+    auto rightEqualToA = [bFirst](Diff3Line& d3l) -> bool& { return bFirst ? d3l.bAEqC : d3l.bAEqB; };
+    auto rightLine = [bFirst](Diff3Line& d3l) -> int& { return bFirst ? d3l.lineC : d3l.lineB; };
+
+    It first = bFirst ? r3b : r3c;
+    It last = bFirst ? r3c : r3b;
+
+    if(rightEqualToA(*last))
+    {
+        return;
+    }
+
+    It r3LastEqualA = last;
+    int nofDisturbingLines = 0;
+    for(It r3 = first; r3 != last; ++r3)
+    {
+        if(rightLine(*r3) != -1)
+        {
+            nofDisturbingLines++;
+            if(rightEqualToA(*r3))
+            {
+                r3LastEqualA = r3;
+            }
+        }
+    }
+
+    if(nofDisturbingLines > 0)
+    {
+        bool beforeOrOnEqualLineInA = (r3LastEqualA != last);
+        for(It r3 = first; r3 != last; ++r3)
+        {
+            if(rightLine(*r3) != -1 || (beforeOrOnEqualLineInA && r3->lineA != -1))
+            {
+                Diff3Line d3l;
+                rightLine(d3l) = rightLine(*r3);
+                rightLine(*r3) = -1;
+                if(beforeOrOnEqualLineInA)
+                {
+                    d3l.lineA = r3->lineA;
+                    rightEqualToA(d3l) = rightEqualToA(*r3);
+                    r3->lineA = -1;
+                    leftEqualToA(*r3) = false;
+                }
+                rightEqualToA(*r3) = false;
+                r3->bBEqC = false;
+                d3ll.insert(first, d3l);
+            }
+            if(r3 == r3LastEqualA)
+            {
+                beforeOrOnEqualLineInA = false;
+            }
+        }
+    }
+
+    rightLine(*first) = rightLine(*last);
+    first->bBEqC = true;
+    rightEqualToA(*first) = leftEqualToA(*first);
+    rightLine(*last) = -1;
+    rightEqualToA(*last) = false;
+    last->bBEqC = false;
+}
+
+void updateUsingBC(const DiffList& diffList23, List& d3ll)
+{
+    int lineB = 0;
+    int lineC = 0;
+    It r3b = d3ll.begin();
+    It r3c = d3ll.begin();
+
+    for(auto d: diffList23)
+    {
+        for(; d.nofEquals > 0; d.nofEquals--)
+        {
+            while(r3b->lineB != lineB)
+            {
+                ++r3b;
+            }
+            while(r3c->lineC != lineC)
+            {
+                ++r3c;
+            }
+            if(r3b == r3c)
+            {
+                r3b->bBEqC = true;
+            }
+            else
+            {
+                moveLowerLineUp(d3ll, r3b, r3c);
+            }
+            lineB++;
+            lineC++;
+            ++r3b;
+            ++r3c;
+        }
+
+        It r3from = r3b;
+        for(; d.diff1 > 0; d.diff1--)
+        {
+            while(r3from->lineB != lineB)
+            {
+                ++r3from;
+            }
+            if(r3from != r3b && !r3from->bAEqB)
+            {
+                Diff3Line d3l;
+                d3l.lineB = lineB;
+                d3ll.insert(r3b, d3l);
+                r3from->lineB = -1;
+            }
+            else
+            {
+                ++r3from;
+                r3b = r3from;
+            }
+            lineB++;
+        }
+        lineC += d.diff2;
+    }
+}
+
+std::vector<Diff3Line> calcDiff3LineList(const DiffList& diffList12, const DiffList& diffList13, const DiffList& diffList23)
+{
+    List d3ll;
+    updateUsingAB(diffList12, d3ll);
+    updateUsingAC(diffList13, d3ll);
+    updateUsingBC(diffList23, d3ll);
+    return std::vector<Diff3Line>(d3ll.begin(), d3ll.end());
+}
+
+/*
+ * The character-by-character version of calcDiff.
+ */
+void trimDiff3LineList(std::vector<Diff3Line>& d3ll, const std::vector<int> (&files)[3])
+{
+    auto equal = [&](int file1, int line1, int file2, int line2)
+    {
+        return files[file1][line1] == files[file2][line2];
+    };
+
+    size_t lineA = 0;
+    size_t lineB = 0;
+    size_t lineC = 0;
+
+    for(size_t line = 0; line < d3ll.size(); line++)
+    {
+        auto& r3 = d3ll[line];
+
+        if(line > lineA && r3.lineA != -1 && d3ll[lineA].lineB != -1 && d3ll[lineA].bBEqC &&
+           equal(0, r3.lineA, 1, d3ll[lineA].lineB))
+        {
+            d3ll[lineA].lineA = r3.lineA;
+            d3ll[lineA].bAEqB = true;
+            d3ll[lineA].bAEqC = true;
+            r3.lineA = -1;
+            r3.bAEqB = false;
+            r3.bAEqC = false;
+            lineA++;
+        }
+
+        if(line > lineB && r3.lineB != -1 && d3ll[lineB].lineA != -1 && d3ll[lineB].bAEqC &&
+           equal(1, r3.lineB, 0, d3ll[lineB].lineA))
+        {
+            d3ll[lineB].lineB = r3.lineB;
+            d3ll[lineB].bAEqB = true;
+            d3ll[lineB].bBEqC = true;
+            r3.lineB = -1;
+            r3.bAEqB = false;
+            r3.bBEqC = false;
+            lineB++;
+        }
+
+        if(line > lineC && r3.lineC != -1 && d3ll[lineC].lineA != -1 && d3ll[lineC].bAEqB &&
+           equal(2, r3.lineC, 0, d3ll[lineC].lineA))
+        {
+            d3ll[lineC].lineC = r3.lineC;
+            d3ll[lineC].bAEqC = true;
+            d3ll[lineC].bBEqC = true;
+            r3.lineC = -1;
+            r3.bAEqC = false;
+            r3.bBEqC = false;
+            lineC++;
+        }
+
+        if(line > lineA && r3.lineA != -1 && !r3.bAEqB && !r3.bAEqC)
+        {
+            auto& r3a = d3ll[lineA];
+            r3a.lineA = r3.lineA;
+            r3.lineA = -1;
+            if(r3a.lineB != -1 && equal(0, r3a.lineA, 1, r3a.lineB))
+                r3a.bAEqB = true;
+            if((r3a.bAEqB && r3a.bBEqC) || (r3a.lineC != -1 && equal(0, r3a.lineA, 2, r3a.lineC)))
+                r3a.bAEqC = true;
+            lineA++;
+        }
+
+        if(line > lineB && r3.lineB != -1 && !r3.bAEqB && !r3.bBEqC)
+        {
+            auto& r3b = d3ll[lineB];
+            r3b.lineB = r3.lineB;
+            r3.lineB = -1;
+            if(r3b.lineA != -1 && equal(0, r3b.lineA, 1, r3b.lineB))
+                r3b.bAEqB = true;
+            if((r3b.bAEqB && r3b.bAEqC) || (r3b.lineC != -1 && equal(1, r3b.lineB, 2, r3b.lineC)))
+                r3b.bBEqC = true;
+            lineB++;
+        }
+
+        if(line > lineC && r3.lineC != -1 && !r3.bAEqC && !r3.bBEqC)
+        {
+            auto& r3c = d3ll[lineC];
+            r3c.lineC = r3.lineC;
+            r3.lineC = -1;
+            if(r3c.lineA != -1 && equal(0, r3c.lineA, 2, r3c.lineC))
+                r3c.bAEqC = true;
+            if((r3c.bAEqC && r3c.bAEqB) || (r3c.lineB != -1 && equal(1, r3c.lineB, 2, r3c.lineC)))
+                r3c.bBEqC = true;
+            lineC++;
+        }
+
+        if(line > lineA && line > lineB && r3.lineA != -1 && r3.bAEqB && !r3.bAEqC)
+        {
+            size_t l = std::max(lineA, lineB);
+            auto& r = d3ll[l];
+            r.lineA = r3.lineA;
+            r.lineB = r3.lineB;
+            r.bAEqB = true;
+            if(r.lineC != -1 && equal(0, r.lineA, 2, r.lineC))
+            {
+                r.bAEqC = true;
+                r.bBEqC = true;
+            }
+            r3.lineA = -1;
+            r3.lineB = -1;
+            r3.bAEqB = false;
+            lineA = l + 1;
+            lineB = l + 1;
+        }
+        else if(line > lineA && line > lineC && r3.lineA != -1 && r3.bAEqC && !r3.bAEqB)
+        {
+            size_t l = std::max(lineA, lineC);
+            auto& r = d3ll[l];
+            r.lineA = r3.lineA;
+            r.lineC = r3.lineC;
+            r.bAEqC = true;
+            if(r.lineB != -1 && equal(0, r.lineA, 1, r.lineB))
+            {
+                r.bAEqB = true;
+                r.bBEqC = true;
+            }
+            r3.lineA = -1;
+            r3.lineC = -1;
+            r3.bAEqC = false;
+            lineA = l + 1;
+            lineC = l + 1;
+        }
+        else if(line > lineB && line > lineC && r3.lineB != -1 && r3.bBEqC && !r3.bAEqC)
+        {
+            size_t l = std::max(lineB, lineC);
+            auto& r = d3ll[l];
+            r.lineB = r3.lineB;
+            r.lineC = r3.lineC;
+            r.bBEqC = true;
+            if(r.lineA != -1 && equal(0, r.lineA, 1, r.lineB))
+            {
+                r.bAEqB = true;
+                r.bAEqC = true;
+            }
+            r3.lineB = -1;
+            r3.lineC = -1;
+            r3.bBEqC = false;
+            lineB = l + 1;
+            lineC = l + 1;
+        }
+
+        if(r3.lineA != -1) lineA = line + 1;
+        if(r3.lineB != -1) lineB = line + 1;
+        if(r3.lineC != -1) lineC = line + 1;
+    }
+
+    d3ll.erase(std::remove_if(d3ll.begin(), d3ll.end(),
+                              [](const Diff3Line& d3l) { return d3l.lineA == -1 && d3l.lineB == -1 && d3l.lineC == -1; }),
+               d3ll.end());
+}
+
+DiffList calcDiff(std::string_view line1, std::string_view line2, int match, int maxSearchRange)
+{
+    DiffList diffList;
+
+    /* TODO: this algorithm must be done char by char, but the count in the
+     * Diff's returned should be in bytes so it can be used for splicing the
+     * string */
+
+    /* The parts of the lines that have not been matched yet */
+    auto r1 = line1;
+    auto r2 = line2;
+
+    for(;;)
+    {
+        int nofEquals = 0;
+        while(!r1.empty() && !r2.empty() && r1.front() == r2.front())
+        {
+            r1.remove_prefix(1);
+            r2.remove_prefix(1);
+            nofEquals++;
+        }
+
+        bool bestValid = false;
+        int bestI1 = 0;
+        int bestI2 = 0;
+        int r1Length = static_cast<int>(r1.size());
+        int r2Length = static_cast<int>(r2.size());
+
+        // Look for a character that occurs in both r1 and r2 and that is closest to the current position
+        for(int i1 = 0; ; i1++)
+        {
+            // Stop looking ahead in r1 if we've already found a match that is closer to the current position
+            if(i1 == r1Length || (bestValid && (i1 >= bestI1 + bestI2)))
+            {
+                break;
+            }
+            for(int i2 = 0; i2 < maxSearchRange; i2++)
+            {
+                // Stop looking ahead in r2 if we've already found a match that is closer to the current position
+                if(i2 == r2Length || (bestValid && ((i1 + i2) >= (bestI1 + bestI2))))
+                {
+                    break;
+                }
+                // If we've found a matching character and one of the following holds..
+                // - it is about as far from the previous set of matching chars in r1 as in r2
+                // - it is the last char in both r1 and r2
+                // - the next char in r1 and r2 also matches
+                else if( (r1[i1] == r2[i2]) &&
+                         ( match == 1 ||
+                           std::abs(i1 - i2) < 3 ||
+                           (i1 + 1 == r1Length && i2 + 1 == r2Length) ||
+                           (i1 + 1 != r1Length && i2 + 1 != r2Length && r1[i1 + 1] == r2[i2 + 1]) ) )
+                {
+                    bestI1 = i1;
+                    bestI2 = i2;
+                    bestValid = true;
+                    break;
+                }
+            }
+        }
+
+        bool endReached = false;
+        if(bestValid)
+        {
+            // continue somehow
+            diffList.push_back(Diff(nofEquals, bestI1, bestI2));
+
+            r1.remove_prefix(bestI1);
+            r2.remove_prefix(bestI2);
+        }
+        else
+        {
+            // Nothing else to match.
+            diffList.push_back(Diff(nofEquals, r1Length, r2Length));
+
+            endReached = true;
+        }
+
+        // Sometimes the algorithm that chooses the first match unfortunately chooses
+        // a match where later actually equal parts don't match anymore.
+        // A different match could be achieved, if we start at the end.
+        // Do it, if it would be a better match.
+        int nofUnmatched = 0;
+        auto ru1 = line1.substr(0, line1.size() - r1.size());
+        auto ru2 = line2.substr(0, line2.size() - r2.size());
+
+        while(!ru1.empty() && !ru2.empty() && ru1.back() == ru2.back())
+        {
+            nofUnmatched++;
+            ru1.remove_suffix(1);
+            ru2.remove_suffix(1);
+        }
+
+        if(nofUnmatched > 0)
+        {
+            // We want to go backwards the nofUnmatched elements and redo
+            // the matching
+            Diff d = diffList.back();
+            Diff origBack = d;
+            diffList.pop_back();
+
+            while(nofUnmatched > 0)
+            {
+                if(d.diff1 > 0 && d.diff2 > 0)
+                {
+                    d.diff1--;
+                    d.diff2--;
+                    nofUnmatched--;
+                }
+                else if(d.nofEquals > 0)
+                {
+                    d.nofEquals--;
+                    nofUnmatched--;
+                }
+
+                if(d.nofEquals == 0 && (d.diff1 == 0 || d.diff2 == 0) && nofUnmatched > 0)
+                {
+                    if(diffList.empty())
+                    {
+                        break;
+                    }
+                    d.nofEquals += diffList.back().nofEquals;
+                    d.diff1 += diffList.back().diff1;
+                    d.diff2 += diffList.back().diff2;
+                    diffList.pop_back();
+                    endReached = false;
+                }
+            }
+
+            if(endReached)
+            {
+                diffList.push_back(origBack);
+            }
+            else
+            {
+                assert(nofUnmatched == 0);
+                r1 = line1.substr(ru1.size() + nofUnmatched);
+                r2 = line2.substr(ru2.size() + nofUnmatched);
+                diffList.push_back(d);
+            }
+        }
+
+        if(endReached)
+        {
+            break;
+        }
+    }
+
+    return diffList;
+}
+
+}
+
+/*
+ * Computes a minimal diff list between two sequences of line ids.
+ */
+static DiffList lcsDiff(const std::vector<int>& a, const std::vector<int>& b)
+{
+    std::vector<std::vector<int>> lcs(a.size() + 1, std::vector<int>(b.size() + 1, 0));
+    for(int i = a.size() - 1; i >= 0; i--)
+    {
+        for(int j = b.size() - 1; j >= 0; j--)
+        {
+            lcs[i][j] = (a[i] == b[j]) ? lcs[i + 1][j + 1] + 1 : std::max(lcs[i + 1][j], lcs[i][j + 1]);
+        }
+    }
+
+    DiffList diffList;
+    Diff d(0, 0, 0);
+    size_t i = 0;
+    size_t j = 0;
+    while(i < a.size() || j < b.size())
+    {
+        if(i < a.size() && j < b.size() && a[i] == b[j])
+        {
+            if(d.diff1 > 0 || d.diff2 > 0)
+            {
+                diffList.push_back(d);
+                d = Diff(0, 0, 0);
+            }
+            d.nofEquals++;
+            i++;
+            j++;
+        }
+        else if(j == b.size() || (i < a.size() && lcs[i + 1][j] >= lcs[i][j + 1]))
+        {
+            d.diff1++;
+            i++;
+        }
+        else
+        {
+            d.diff2++;
+            j++;
+        }
+    }
+    if(d.nofEquals > 0 || d.diff1 > 0 || d.diff2 > 0)
+    {
+        diffList.push_back(d);
+    }
+    return diffList;
+}
+
+TEST(TestDiff3LineList, all_equal)
+{
+    DiffList dl = { Diff(2, 0, 0) };
+
+    auto d3ll = calcDiff3LineList(dl, dl, dl);
+
+    std::vector<Row> expected = {
+        Row(true, true, true, 0, 0, 0),
+        Row(true, true, true, 1, 1, 1),
+    };
+    ASSERT_EQ(toRows(d3ll), expected);
+}
+
+TEST(TestDiff3LineList, unequal_lines_of_b_and_c_get_rows_of_their_own)
+{
+    /* A = [p, q, r], B = [p, x, r], C = [p, y, z, q, r] */
+    auto d3ll = calcDiff3LineList({ Diff(1, 1, 1), Diff(1, 0, 0) },
+                                  { Diff(1, 0, 2), Diff(2, 0, 0) },
+                                  { Diff(1, 1, 3), Diff(1, 0, 0) });
+
+    std::vector<Row> expected = {
+        Row(true,  true,  true,  0,  0,  0),
+        Row(false, false, false, -1, 1,  -1),
+        Row(false, false, false, -1, -1, 1),
+        Row(false, false, false, -1, -1, 2),
+        Row(false, true,  false, 1,  -1, 3),
+        Row(true,  true,  true,  2,  2,  4),
+    };
+    ASSERT_EQ(toRows(d3ll), expected);
+}
+
+TEST(TestDiff3LineList, equal_b_and_c_move_into_one_row)
+{
+    /* A = [x], B = [y], C = [y] */
+    auto d3ll = calcDiff3LineList({ Diff(0, 1, 1) },
+                                  { Diff(0, 1, 1) },
+                                  { Diff(1, 0, 0) });
+
+    std::vector<Row> expected = {
+        Row(false, false, true,  -1, 0,  0),
+        Row(false, false, false, 0,  -1, -1),
+    };
+    ASSERT_EQ(toRows(d3ll), expected);
+}
+
+/*
+ * Derives three files from a common base with a few random edits.
+ */
+static void deriveRandomFiles(std::mt19937& rng, std::vector<int> (&files)[3])
+{
+    std::vector<int> base(std::uniform_int_distribution<int>(0, 30)(rng));
+    for(auto& line: base)
+    {
+        line = std::uniform_int_distribution<int>(0, 5)(rng);
+    }
+
+    for(auto& file: files)
+    {
+        file = base;
+        int edits = std::uniform_int_distribution<int>(0, 6)(rng);
+        for(int edit = 0; edit < edits; edit++)
+        {
+            int pos = std::uniform_int_distribution<int>(0, file.size())(rng);
+            int line = std::uniform_int_distribution<int>(0, 7)(rng);
+            switch(std::uniform_int_distribution<int>(0, 2)(rng))
+            {
+            case 0:
+                file.insert(file.begin() + pos, line);
+                break;
+            case 1:
+                if(pos < static_cast<int>(file.size())) file.erase(file.begin() + pos);
+                break;
+            case 2:
+                if(pos < static_cast<int>(file.size())) file[pos] = line;
+                break;
+            }
+        }
+    }
+}
+
+TEST(TestDiff3LineList, same_as_three_pass_algorithm)
+{
+    std::mt19937 rng(1);
+
+    for(int iteration = 0; iteration < 2000; iteration++)
+    {
+        std::vector<int> files[3];
+        deriveRandomFiles(rng, files);
+
+        auto dl12 = lcsDiff(files[0], files[1]);
+        auto dl13 = lcsDiff(files[0], files[2]);
+        auto dl23 = lcsDiff(files[1], files[2]);
+
+        auto d3ll = calcDiff3LineList(dl12, dl13, dl23);
+        auto expected = reference::calcDiff3LineList(dl12, dl13, dl23);
+        ASSERT_EQ(toRows(d3ll), toRows(expected)) << "iteration " << iteration;
+
+        for(int n = 0; n < 3; n++)
+        {
+            validateDiff3LineListForN(d3ll, n, 0, static_cast<int>(files[n].size()) - 1);
+        }
+    }
+}
+
+static Diff3Table toDiff3Table(const std::vector<Row>& rows)
+{
+    Diff3Table diff3Table;
+    for(auto& [bAEqB, bAEqC, bBEqC, lineA, lineB, lineC]: rows)
+    {
+        diff3Table.push_back(Diff3Line{ lineA, lineB, lineC, bAEqB, bAEqC, bBEqC });
+    }
+    return diff3Table;
+}
+
+/*
+ * Line i of every file is the same and differs from all other lines.
+ */
+static LineEquivalences lineNumberEquivalences(LineId nrOfLines)
+{
+    LineEquivalences lineEquivalences;
+    for(int n = 0; n < 3; n++)
+    {
+        lineEquivalences.ids(n).resize(nrOfLines);
+        std::iota(lineEquivalences.ids(n).begin(), lineEquivalences.ids(n).end(), 0);
+    }
+    return lineEquivalences;
+}
+
+TEST(TestTrimDiff3LineList, lines_from_a_are_compacted)
+{
+    auto d3ll = toDiff3Table({ Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false,  1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false,  1, -1, -1) });
+
+    auto trimmed = trimDiff3LineList(d3ll, lineNumberEquivalences(20));
+
+    std::vector<Row> expected = {
+        Row(false, false, false,  1, -1, -1),
+        Row(false, false, false,  1, -1, -1),
+    };
+    ASSERT_EQ(toRows(trimmed), expected);
+}
+
+TEST(TestTrimDiff3LineList, lines_from_b_are_compacted)
+{
+    auto d3ll = toDiff3Table({ Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1,  1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1,  1, -1) });
+
+    auto trimmed = trimDiff3LineList(d3ll, lineNumberEquivalences(20));
+
+    std::vector<Row> expected = {
+        Row(false, false, false, -1,  1, -1),
+        Row(false, false, false, -1,  1, -1),
+    };
+    ASSERT_EQ(toRows(trimmed), expected);
+}
+
+TEST(TestTrimDiff3LineList, lines_from_c_are_compacted)
+{
+    auto d3ll = toDiff3Table({ Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1,  1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1, -1),
+                               Row(false, false, false, -1, -1,  1) });
+
+    auto trimmed = trimDiff3LineList(d3ll, lineNumberEquivalences(20));
+
+    std::vector<Row> expected = {
+        Row(false, false, false, -1, -1,  1),
+        Row(false, false, false, -1, -1,  1),
+    };
+    ASSERT_EQ(toRows(trimmed), expected);
+}
+
+TEST(TestTrimDiff3LineList, equal_lines_move_into_one_row)
+{
+    /* A = [x], B = [x], C = [x] with the line of B in a row of its own */
+    auto d3ll = toDiff3Table({ Row(false, false, false, -1,  0, -1),
+                               Row(false, true,  false,  0, -1,  0) });
+
+    auto trimmed = trimDiff3LineList(d3ll, lineNumberEquivalences(1));
+
+    std::vector<Row> expected = {
+        Row(true, true, true, 0, 0, 0),
+    };
+    ASSERT_EQ(toRows(trimmed), expected);
+}
+
+TEST(TestTrimDiff3LineList, same_as_list_based_algorithm)
+{
+    std::mt19937 rng(2);
+
+    for(int iteration = 0; iteration < 2000; iteration++)
+    {
+        std::vector<int> files[3];
+        deriveRandomFiles(rng, files);
+
+        auto d3ll = calcDiff3LineList(lcsDiff(files[0], files[1]),
+                                      lcsDiff(files[0], files[2]),
+                                      lcsDiff(files[1], files[2]));
+        auto expected = reference::calcDiff3LineList(lcsDiff(files[0], files[1]),
+                                                     lcsDiff(files[0], files[2]),
+                                                     lcsDiff(files[1], files[2]));
+
+        LineEquivalences lineEquivalences;
+        for(int n = 0; n < 3; n++)
+        {
+            lineEquivalences.ids(n).assign(files[n].begin(), files[n].end());
+        }
+
+        auto trimmed = trimDiff3LineList(d3ll, lineEquivalences);
+        reference::trimDiff3LineList(expected, files);
+        ASSERT_EQ(toRows(trimmed), toRows(expected)) << "iteration " << iteration;
+
+        for(int n = 0; n < 3; n++)
+        {
+            validateDiff3LineListForN(trimmed, n, 0, static_cast<int>(files[n].size()) - 1);
+        }
+    }
+}
+
+TEST(TestTrimDiff3LineList, parallel_parts_are_the_same_as_whole_table)
+{
+    std::mt19937 rng(3);
+    WorkerPool pool(3);
+
+    for(int iteration = 0; iteration < 200; iteration++)
+    {
+        /* Blocks of random edits between separator lines that all files
+         * share, so that there are sync points to split at */
+        std::vector<int> files[3];
+        int nrOfBlocks = std::uniform_int_distribution<int>(1, 20)(rng);
+        for(int block = 0; block < nrOfBlocks; block++)
+        {
+            std::vector<int> blockFiles[3];
+            deriveRandomFiles(rng, blockFiles);
+            for(int n = 0; n < 3; n++)
+            {
+                files[n].insert(files[n].end(), blockFiles[n].begin(), blockFiles[n].end());
+                files[n].push_back(100 + block);
+            }
+        }
+
+        auto dl12 = lcsDiff(files[0], files[1]);
+        auto dl13 = lcsDiff(files[0], files[2]);
+        auto dl23 = lcsDiff(files[1], files[2]);
+
+        LineEquivalences lineEquivalences;
+        for(int n = 0; n < 3; n++)
+        {
+            lineEquivalences.ids(n).assign(files[n].begin(), files[n].end());
+        }
+
+        auto d3ll = calcDiff3LineList(dl12, dl13, dl23);
+        auto expected = trimDiff3LineList(d3ll, lineEquivalences);
+        auto trimmed = calcTrimmedDiff3LineList(dl12, dl13, dl23, lineEquivalences, pool);
+        ASSERT_EQ(toRows(trimmed), toRows(expected)) << "iteration " << iteration;
+
+        for(int n = 0; n < 3; n++)
+        {
+            validateDiff3LineListForN(trimmed, n, 0, static_cast<int>(files[n].size()) - 1);
+        }
+    }
+}
+
+TEST(TestTrimDiff3LineList, streamed_diffs_give_the_same_table)
+{
+    std::mt19937 rng(4);
+
+    for(int iteration = 0; iteration < 200; iteration++)
+    {
+        std::vector<int> files[3];
+        deriveRandomFiles(rng, files);
+
+        DiffList diffLists[3] = { lcsDiff(files[0], files[1]),
+                                  lcsDiff(files[0], files[2]),
+                                  lcsDiff(files[1], files[2]) };
+
+        LineEquivalences lineEquivalences;
+        for(int n = 0; n < 3; n++)
+        {
+            lineEquivalences.ids(n).assign(files[n].begin(), files[n].end());
+        }
+
+        /* Small queues, so that the producers have to wait for the table */
+        DiffQueue queues[3] = { DiffQueue(1, 1), DiffQueue(1, 1), DiffQueue(1, 1) };
+        std::vector<std::thread> producers;
+        for(int i = 0; i < 3; i++)
+        {
+            producers.emplace_back([&, i]()
+            {
+                for(auto& d: diffLists[i])
+                {
+                    queues[i].push(d);
+                }
+                queues[i].close();
+            });
+        }
+        auto streamed = calcTrimmedDiff3LineList(queues[0], queues[1], queues[2], lineEquivalences);
+        for(auto& producer: producers)
+        {
+            producer.join();
+        }
+
+        auto d3ll = calcDiff3LineList(diffLists[0], diffLists[1], diffLists[2]);
+        auto expected = trimDiff3LineList(d3ll, lineEquivalences);
+        ASSERT_EQ(toRows(streamed), toRows(expected)) << "iteration " << iteration;
+    }
+}
+
+TEST(TestTrimDiff3LineList, streamed_stretches_give_the_same_table)
+{
+    std::mt19937 rng(5);
+    WorkerPool pool(3);
+
+    for(int iteration = 0; iteration < 200; iteration++)
+    {
+        /* Blocks of random edits between separator lines that all files
+         * share, so that the diffs can be split into stretches */
+        std::vector<int> files[3];
+        int nrOfBlocks = std::uniform_int_distribution<int>(1, 20)(rng);
+        for(int block = 0; block < nrOfBlocks; block++)
+        {
+            std::vector<int> blockFiles[3];
+            deriveRandomFiles(rng, blockFiles);
+            for(int n = 0; n < 3; n++)
+            {
+                files[n].insert(files[n].end(), blockFiles[n].begin(), blockFiles[n].end());
+                files[n].push_back(100 + block);
+            }
+        }
+
+        DiffList diffLists[3] = { lcsDiff(files[0], files[1]),
+                                  lcsDiff(files[0], files[2]),
+                                  lcsDiff(files[1], files[2]) };
+
+        LineEquivalences lineEquivalences;
+        for(int n = 0; n < 3; n++)
+        {
+            lineEquivalences.ids(n).assign(files[n].begin(), files[n].end());
+        }
+
+        DiffListSource sources[3] = { DiffListSource(diffLists[0]),
+                                      DiffListSource(diffLists[1]),
+                                      DiffListSource(diffLists[2]) };
+        int minStretchLines = std::uniform_int_distribution<int>(1, 10)(rng);
+        auto streamed = calcTrimmedDiff3LineList(sources[0], sources[1], sources[2], lineEquivalences, pool,
+                                                 minStretchLines);
+
+        auto d3ll = calcDiff3LineList(diffLists[0], diffLists[1], diffLists[2]);
+        auto expected = trimDiff3LineList(d3ll, lineEquivalences);
+        ASSERT_EQ(toRows(streamed), toRows(expected)) << "iteration " << iteration;
+    }
+}
+
+static DiffList mirrored(DiffList diffList)
+{
+    for(auto& d: diffList)
+    {
+        std::swap(d.diff1, d.diff2);
+    }
+    return diffList;
+}
+
+/*
+ * Merges diffs that calcDiff may have split up in a way that does not change
+ * the meaning of the diff list.
+ */
+static DiffList normalize(const DiffList& diffList)
+{
+    DiffList normalized;
+
+    Diff newD(0, 0, 0);
+    for(auto d: diffList)
+    {
+        if(newD.diff1 == 0 && newD.diff2 == 0)
+        {
+            newD.nofEquals += d.nofEquals;
+            d.nofEquals = 0;
+        }
+        if(d.nofEquals == 0)
+        {
+            newD.diff1 += d.diff1;
+            newD.diff2 += d.diff2;
+        }
+        else
+        {
+            normalized.push_back(newD);
+            newD = d;
+        }
+    }
+    if(!(newD == Diff(0, 0, 0)))
+    {
+        normalized.push_back(newD);
+    }
+
+    return normalized;
+}
+
+static void testCalcDiffIncludingMirrored(std::string_view line1, std::string_view line2, const DiffList& expected)
+{
+    ASSERT_EQ(normalize(calcDiff(line1, line2, 2, 500)), expected) << line1 << " vs " << line2;
+    ASSERT_EQ(normalize(calcDiff(line2, line1, 2, 500)), mirrored(expected)) << line2 << " vs " << line1;
+}
+
+TEST(TestCalcDiff, finds_character_differences)
+{
+    testCalcDiffIncludingMirrored("match", "match", { Diff(5, 0, 0) });
+
+    testCalcDiffIncludingMirrored("matmatch", "match", { Diff(0, 3, 0), Diff(5, 0, 0) });
+    testCalcDiffIncludingMirrored("mat_match", "match", { Diff(0, 4, 0), Diff(5, 0, 0) });
+    testCalcDiffIncludingMirrored("mat_______match", "match", { Diff(0, 10, 0), Diff(5, 0, 0) });
+
+    testCalcDiffIncludingMirrored("amat_match", "bmatch", { Diff(0, 5, 1), Diff(5, 0, 0) });
+
+    testCalcDiffIncludingMirrored("matchtch", "match", { Diff(5, 3, 0) });
+    testCalcDiffIncludingMirrored("match_tch", "match", { Diff(5, 4, 0) });
+    testCalcDiffIncludingMirrored("match_______tch", "match", { Diff(5, 10, 0) });
+}
+
+TEST(TestCalcDiff, counts_bytes_of_multibyte_characters)
+{
+    testCalcDiffIncludingMirrored("παρ", "παρ", { Diff(6, 0, 0) });
+    testCalcDiffIncludingMirrored("ｔｅｒ", "ｔｅｒ", { Diff(9, 0, 0) });
+    testCalcDiffIncludingMirrored("ｅｒ", "ｔｅｒ", { Diff(0, 0, 3), Diff(6, 0, 0) });
+}
+
+TEST(TestFineDiff, short_equal_stretches_become_differences)
+{
+    ASSERT_EQ(fineDiff(0, 0, "same_", "same_"), DiffList({ Diff(5, 0, 0) }));
+    ASSERT_EQ(fineDiff(0, 0, "same_a", "same_b"), DiffList({ Diff(5, 1, 1) }));
+    ASSERT_EQ(fineDiff(0, 0, "same_a", "same_bc"), DiffList({ Diff(5, 1, 2) }));
+    ASSERT_EQ(fineDiff(0, -1, "ae\n", ""), DiffList({ Diff(0, 3, 0) }));
+}
+
+TEST(TestDiffListIterator, returns_runs_of_one_file)
+{
+    DiffList dl1 = { Diff(1, 2, 3) };
+    ASSERT_EQ(DiffListIterator(dl1, 0).getNextRun(), std::make_pair(true, 1));
+
+    DiffList dl2 = { Diff(0, 2, 3) };
+    ASSERT_EQ(DiffListIterator(dl2, 0).getNextRun(), std::make_pair(false, 2));
+    ASSERT_EQ(DiffListIterator(dl2, 1).getNextRun(), std::make_pair(false, 3));
+
+    DiffList dl3 = { Diff(3, 5, 7) };
+    DiffListIterator it(dl3, 0);
+    it.advance(2);
+    ASSERT_EQ(it.getNextRun(), std::make_pair(true, 1));
+    it.advance(1);
+    ASSERT_EQ(it.getNextRun(), std::make_pair(false, 5));
+    it.advance(1);
+    ASSERT_EQ(it.getNextRun(), std::make_pair(false, 4));
+
+    DiffListIterator it1(dl3, 1);
+    it1.advance(4);
+    ASSERT_EQ(it1.getNextRun(), std::make_pair(false, 6));
+
+    DiffList dl4 = { Diff(3, 5, 7), Diff(3, 2, 1) };
+    DiffListIterator it2(dl4, 0);
+    it2.advance(10);
+    ASSERT_EQ(it2.getNextRun(), std::make_pair(true, 1));
+    ASSERT_EQ(dl4, DiffList({ Diff(3, 5, 7), Diff(3, 2, 1) }));
+}
+
+static StyleList lineStyle(const DiffList& dl1, const DiffList& dl2)
+{
+    DiffListIterator it1(dl1, 0);
+    DiffListIterator it2(dl2, 0);
+    return lineStyleFromFineDiffs(it1, it2, DiffStyle::A_B_SAME, DiffStyle::A_C_SAME);
+}
+
+TEST(TestLineStyleFromFineDiffs, combines_two_fine_diffs)
+{
+    // Both identical
+    ASSERT_EQ(lineStyle({ Diff(1, 2, 3) }, { Diff(1, 2, 3) }),
+              StyleList({ { DiffStyle::ALL_SAME, 1 }, { DiffStyle::DIFFERENT, 2 } }));
+
+    // Difference trumps equal in same Diff
+    ASSERT_EQ(lineStyle({ Diff(3, 2, 2) }, { Diff(1, 4, 3) }),
+              StyleList({ { DiffStyle::ALL_SAME, 1 }, { DiffStyle::A_B_SAME, 2 }, { DiffStyle::DIFFERENT, 2 } }));
+
+    // Difference trumps equal in next Diff
+    ASSERT_EQ(lineStyle({ Diff(2, 1, 1), Diff(1, 1, 1) }, { Diff(1, 4, 3) }),
+              StyleList({ { DiffStyle::ALL_SAME, 1 }, { DiffStyle::A_B_SAME, 1 }, { DiffStyle::DIFFERENT, 1 },
+                          { DiffStyle::A_B_SAME, 1 }, { DiffStyle::DIFFERENT, 1 } }));
+
+    // Difference on either side trumps equal in other
+    ASSERT_EQ(lineStyle({ Diff(2, 2, 0), Diff(2, 0, 0) }, { Diff(0, 2, 0), Diff(2, 2, 0) }),
+              StyleList({ { DiffStyle::A_B_SAME, 2 }, { DiffStyle::A_C_SAME, 2 }, { DiffStyle::A_B_SAME, 2 } }));
+
+    // Equal in the middle of a stretch of diff
+    ASSERT_EQ(lineStyle({ Diff(0, 2, 0), Diff(3, 4, 0) }, { Diff(9, 0, 0) }),
+              StyleList({ { DiffStyle::A_C_SAME, 2 }, { DiffStyle::ALL_SAME, 3 }, { DiffStyle::A_C_SAME, 4 } }));
+
+    // Diff in the middle of a stretch of equal
+    ASSERT_EQ(lineStyle({ Diff(2, 3, 0), Diff(4, 0, 0) }, { Diff(9, 0, 0) }),
+              StyleList({ { DiffStyle::ALL_SAME, 2 }, { DiffStyle::A_C_SAME, 3 }, { DiffStyle::ALL_SAME, 4 } }));
+
+    ASSERT_EQ(lineStyle({ Diff(2, 18, 0), Diff(1, 0, 0) }, { Diff(0, 1, 36), Diff(1, 19, 0) }),
+              StyleList({ { DiffStyle::A_B_SAME, 1 }, { DiffStyle::ALL_SAME, 1 }, { DiffStyle::DIFFERENT, 18 },
+                          { DiffStyle::A_B_SAME, 1 } }));
+}
+
+TEST(TestFineDiffStyle, parallel_styles_are_the_same_as_per_line_styles)
+{
+    std::mt19937 rng(1);
+    std::vector<std::string> lines[3];
+    Diff3Table diff3Table;
+    for(int row = 0; row < 5000; row++)
+    {
+        /* Long runs of equal lines with a few differences in between */
+        bool allEqual = std::uniform_int_distribution<int>(0, 9)(rng) != 0;
+        std::string text = "line " + std::to_string(row);
+        for(int i = 0; i < 3; i++)
+        {
+            lines[i].push_back(allEqual ? text + "\n" : text + " in file " + std::to_string(i) + "\n");
+        }
+        diff3Table.push_back(Diff3Line{ row, row, row, allEqual, allEqual, allEqual });
+    }
+    VectorLineProvider lpA(lines[0]);
+    VectorLineProvider lpB(lines[1]);
+    VectorLineProvider lpC(lines[2]);
+
+    WorkerPool pool(3);
+    determineFineDiffStyle(diff3Table, lpA, lpB, lpC, FineDiffGranularity::CHARACTER, pool);
+
+    for(size_t row = 0; row < diff3Table.size(); row++)
+    {
+        auto expected = determineFineDiffStylePerLine(diff3Table.get(row), lpA, lpB, lpC);
+        for(int i = 0; i < 3; i++)
+        {
+            ASSERT_EQ(diff3Table.style(row, i), expected[i]) << "row " << row << " line " << i;
+        }
+    }
+}
+
+TEST(TestFineDiffStyle, lines_with_the_same_id_are_not_diffed)
+{
+    /* A and B are the same line, but the line provider of B has a slightly
+     * different text for it to show that it is not compared */
+    VectorLineProvider lpA({ "same\n" });
+    VectorLineProvider lpB({ "sane\n" });
+    VectorLineProvider lpC({ "other\n" });
+    LineEquivalences lineEquivalences;
+    lineEquivalences.ids(0) = { 1 };
+    lineEquivalences.ids(1) = { 1 };
+    lineEquivalences.ids(2) = { 2 };
+
+    FineDiffBuffers buffers;
+    Diff3Line d3l{ 0, 0, 0, false, false, false };
+    auto styles = determineFineDiffStylePerLine(d3l, lpA, lpB, lpC, buffers, FineDiffGranularity::CHARACTER,
+                                                &lineEquivalences);
+
+    ASSERT_EQ(buffers.diffListAB, DiffList({ Diff(5, 0, 0) }));
+    ASSERT_NE(buffers.diffListAC, DiffList({ Diff(5, 0, 0) }));
+    ASSERT_NE(styles, determineFineDiffStylePerLine(d3l, lpA, lpB, lpC));
+}
+
+TEST(TestCalcDiff, same_as_character_by_character_algorithm)
+{
+    std::mt19937 rng(1);
+
+    for(int iteration = 0; iteration < 3000; iteration++)
+    {
+        /* Derive two lines from a common base with a few random edits, with
+         * bases long enough to exceed the search range now and then */
+        int length = std::uniform_int_distribution<int>(0, iteration % 10 == 0 ? 2000 : 60)(rng);
+        char maxChar = "bdz"[iteration % 3];
+        std::string base;
+        for(int i = 0; i < length; i++)
+        {
+            base += static_cast<char>(std::uniform_int_distribution<int>('a', maxChar)(rng));
+        }
+
+        std::string lines[2] = { base, base };
+        for(auto& line: lines)
+        {
+            int edits = std::uniform_int_distribution<int>(0, 5)(rng);
+            for(int edit = 0; edit < edits; edit++)
+            {
+                int pos = std::uniform_int_distribution<int>(0, line.size())(rng);
+                int size = std::uniform_int_distribution<int>(1, 8)(rng);
+                if(std::uniform_int_distribution<int>(0, 1)(rng) == 0)
+                {
+                    line.insert(pos, std::string(size, 'x'));
+                }
+                else
+                {
+                    line.erase(pos, size);
+                }
+            }
+        }
+
+        for(int match: { 1, 2 })
+        {
+            ASSERT_EQ(calcDiff(lines[0], lines[1], match, 500), reference::calcDiff(lines[0], lines[1], match, 500))
+                << "iteration " << iteration << ": " << lines[0] << " vs " << lines[1];
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/diff3contentprovider.h"
+#include "vectorlineprovider.h"
+
+/*
+ * A run of equal rows with a row between them in which file B has no line
+ * and one in which all lines differ.
+ */
+static Diff3Table tableWithRunsAndGaps()
+{
+    Diff3Table diff3Table;
+    for(int i = 0; i < 100; i++)
+    {
+        diff3Table.push_back(Diff3Line{ i, i, i, true, true, true });
+    }
+    diff3Table.push_back(Diff3Line{ 100, -1, 100, false, true, false });
+    diff3Table.push_back(Diff3Line{ 101, 100, 101, false, false, false });
+    for(int i = 0; i < 100; i++)
+    {
+        diff3Table.push_back(Diff3Line{ 102 + i, 101 + i, 102 + i, true, true, true });
+    }
+    return diff3Table;
+}
+
+static std::vector<std::string> lines(int nrOfLines, const std::string& prefix)
+{
+    std::vector<std::string> result;
+    for(int i = 0; i < nrOfLines; i++)
+    {
+        result.push_back(prefix + std::to_string(i) + "\n");
+    }
+    return result;
+}
+
+TEST(TestDiff3ContentProvider, content_lines_are_the_lines_of_the_file_in_each_row)
+{
+    VectorLineProvider lpA(lines(202, "a"));
+    VectorLineProvider lpB(lines(201, "b"));
+    VectorLineProvider lpC(lines(202, "c"));
+    auto diff3Table = tableWithRunsAndGaps();
+    FineDiffCache fineDiffCache(diff3Table, lpA, lpB, lpC);
+
+    int height = static_cast<int>(diff3Table.size());
+    Diff3ContentProvider cpB(20, height, diff3Table, 1, lpB, fineDiffCache);
+    ASSERT_EQ(cpB.getContentWidth(), 20);
+    ASSERT_EQ(cpB.getContentHeight(), height);
+
+    ASSERT_EQ(cpB.get(0), std::optional<std::string>("b0\n"));
+    ASSERT_EQ(cpB.get(99), std::optional<std::string>("b99\n"));
+    ASSERT_EQ(cpB.get(100), std::nullopt);
+    ASSERT_EQ(cpB.get(101), std::optional<std::string>("b100\n"));
+    ASSERT_EQ(cpB.get(201), std::optional<std::string>("b200\n"));
+    ASSERT_EQ(cpB.get(height), std::nullopt);
+
+    Diff3ContentProvider cpC(20, height, diff3Table, 2, lpC, fineDiffCache);
+    ASSERT_EQ(cpC.get(100), std::optional<std::string>("c100\n"));
+    ASSERT_EQ(cpC.get(201), std::optional<std::string>("c201\n"));
+}
+
+TEST(TestDiff3ContentProvider, formats_are_the_fine_diff_styles_of_the_row)
+{
+    VectorLineProvider lpA(lines(202, "a"));
+    VectorLineProvider lpB(lines(201, "b"));
+    VectorLineProvider lpC(lines(202, "c"));
+    auto diff3Table = tableWithRunsAndGaps();
+    FineDiffCache fineDiffCache(diff3Table, lpA, lpB, lpC);
+
+    int height = static_cast<int>(diff3Table.size());
+    Diff3ContentProvider cpA(20, height, diff3Table, 0, lpA, fineDiffCache);
+
+    ASSERT_TRUE(cpA.getFormat(50).empty());
+    ASSERT_FALSE(cpA.getFormat(101).empty());
+    ASSERT_EQ(cpA.getFormat(101), fineDiffCache.getStyle(101, 0));
+    ASSERT_TRUE(cpA.getFormat(height).empty());
+}
@@ -0,0 +1,175 @@
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../src/diff3table.h"
+
+static Diff3Line makeDiff3Line(int lineA, int lineB, int lineC, bool bAEqB, bool bAEqC, bool bBEqC)
+{
+    Diff3Line d3l;
+    d3l.lineA = lineA;
+    d3l.lineB = lineB;
+    d3l.lineC = lineC;
+    d3l.bAEqB = bAEqB;
+    d3l.bAEqC = bAEqC;
+    d3l.bBEqC = bBEqC;
+    return d3l;
+}
+
+TEST(TestDiff3Table, rows_are_stored_as_pushed)
+{
+    Diff3Table table;
+    table.push_back(makeDiff3Line(0, 0, 0, true, true, true));
+    table.push_back(makeDiff3Line(1, -1, 1, false, true, false));
+    table.push_back(makeDiff3Line(-1, 1, -1, false, false, false));
+
+    ASSERT_EQ(table.size(), 3u);
+
+    auto row = table[1];
+    ASSERT_EQ(row.line(0), 1);
+    ASSERT_EQ(row.line(1), -1);
+    ASSERT_EQ(row.line(2), 1);
+    ASSERT_FALSE(row.equal(DiffSelection::A_vs_B));
+    ASSERT_TRUE(row.equal(DiffSelection::A_vs_C));
+    ASSERT_FALSE(row.equal(DiffSelection::B_vs_C));
+
+    auto d3l = table.get(0);
+    ASSERT_TRUE(d3l.bAEqB && d3l.bAEqC && d3l.bBEqC);
+    ASSERT_EQ(table.get(2).lineB, 1);
+}
+
+TEST(TestDiff3Table, rows_of_equal_runs_are_derived_from_the_first_row)
+{
+    Diff3Table table;
+    for(int i = 0; i < 100; i++)
+    {
+        table.push_back(makeDiff3Line(i, i + 10, i + 20, true, true, true));
+    }
+    table.push_back(makeDiff3Line(-1, 110, -1, false, false, false));
+    for(int i = 100; i < 200; i++)
+    {
+        table.push_back(makeDiff3Line(i, i + 11, i + 20, true, true, true));
+    }
+
+    ASSERT_EQ(table.size(), 201u);
+
+    auto d3l = table.get(42);
+    ASSERT_EQ(d3l.lineA, 42);
+    ASSERT_EQ(d3l.lineB, 52);
+    ASSERT_EQ(d3l.lineC, 62);
+    ASSERT_TRUE(d3l.bAEqB && d3l.bAEqC && d3l.bBEqC);
+
+    ASSERT_EQ(table.get(100).lineB, 110);
+    ASSERT_FALSE(table.get(100).bBEqC);
+    ASSERT_EQ(table.get(200).lineB, 210);
+
+    int i = 0;
+    for(auto row: table)
+    {
+        ASSERT_EQ(row.line(0), table.get(i).lineA);
+        ASSERT_EQ(row.equal(DiffSelection::A_vs_B), table.get(i).bAEqB);
+        i++;
+    }
+    ASSERT_EQ(i, 201);
+}
+
+TEST(TestDiff3Table, equal_runs_end_where_lines_are_not_consecutive)
+{
+    Diff3Table table;
+    table.push_back(makeDiff3Line(0, 0, 0, true, true, true));
+    table.push_back(makeDiff3Line(1, 1, 1, true, true, true));
+    table.push_back(makeDiff3Line(2, 3, 2, true, true, true));
+    table.push_back(makeDiff3Line(3, -1, 3, false, true, false));
+    table.push_back(makeDiff3Line(4, 4, 4, true, true, true));
+
+    ASSERT_EQ(table.endOfEqualRun(0), 2u);
+    ASSERT_EQ(table.endOfEqualRun(1), 2u);
+    ASSERT_EQ(table.endOfEqualRun(2), 3u);
+    ASSERT_EQ(table.endOfEqualRun(3), 4u);
+    ASSERT_EQ(table.endOfEqualRun(4), 5u);
+    ASSERT_EQ(table.get(2).lineB, 3);
+    ASSERT_EQ(table.get(4).lineB, 4);
+}
+
+TEST(TestDiff3Table, appended_rows_continue_equal_runs)
+{
+    Diff3Table first;
+    Diff3Table second;
+    for(int i = 0; i < 10; i++)
+    {
+        first.push_back(makeDiff3Line(i, i, i + 1, true, true, true));
+    }
+    for(int i = 10; i < 20; i++)
+    {
+        second.push_back(makeDiff3Line(i, i, i + 1, true, true, true));
+    }
+    second.push_back(makeDiff3Line(-1, 20, -1, false, false, false));
+    second.push_back(makeDiff3Line(20, 21, 21, true, true, true));
+
+    first.append(second);
+
+    ASSERT_EQ(first.size(), 22u);
+    ASSERT_EQ(first.endOfEqualRun(0), 20u);
+    ASSERT_EQ(first.get(15).lineC, 16);
+    ASSERT_EQ(first.get(20).lineB, 20);
+    ASSERT_FALSE(first.get(20).bAEqB);
+    ASSERT_EQ(first.get(21).lineA, 20);
+    ASSERT_TRUE(first.get(21).bBEqC);
+}
+
+TEST(TestDiff3Table, styles_are_only_stored_when_set)
+{
+    Diff3Table table;
+    table.push_back(makeDiff3Line(0, 0, -1, true, false, false));
+    table.push_back(makeDiff3Line(1, 1, -1, false, false, false));
+
+    table[1].style(0).push_back(StyleFragment{DiffStyle::DIFFERENT, 3});
+
+    ASSERT_TRUE(table.style(0, 0).empty());
+    ASSERT_TRUE(table.style(1, 1).empty());
+    ASSERT_EQ(table.style(1, 0).size(), 1u);
+    ASSERT_EQ(table.style(1, 0)[0].length, 3);
+}
+
+TEST(TestDiff3Table, damaged_tables_are_not_read)
+{
+    Diff3Table table;
+    for(int i = 0; i < 10; i++)
+    {
+        table.push_back(makeDiff3Line(i, i, i, true, true, true));
+    }
+    table.push_back(makeDiff3Line(10, -1, 10, false, true, false));
+    table.push_back(makeDiff3Line(11, 10, 11, true, true, true));
+
+    std::ostringstream output;
+    table.write(output);
+    std::string written = output.str();
+
+    auto read = [](const std::string& data)
+    {
+        std::istringstream input(data);
+        Diff3Table readTable;
+        return Diff3Table::read(input, readTable) && readTable.size() == 12 && readTable.get(10).lineB == -1;
+    };
+    ASSERT_TRUE(read(written));
+
+    /* The input ends early */
+    ASSERT_FALSE(read(written.substr(0, written.size() - 1)));
+
+    /* The number of segments is far more than the input holds */
+    auto damaged = written;
+    uint64_t nrOfSegments = uint64_t(1) << 60;
+    damaged.replace(sizeof(uint64_t), sizeof(nrOfSegments), reinterpret_cast<const char *>(&nrOfSegments), sizeof(nrOfSegments));
+    ASSERT_FALSE(read(damaged));
+
+    /* The first segment does not start at the first row */
+    damaged = written;
+    uint64_t firstRow = 1;
+    damaged.replace(2 * sizeof(uint64_t), sizeof(firstRow), reinterpret_cast<const char *>(&firstRow), sizeof(firstRow));
+    ASSERT_FALSE(read(damaged));
+
+    /* Whether the first segment is an equal run is neither true nor false */
+    damaged = written;
+    damaged[2 * sizeof(uint64_t) + 2 * sizeof(uint64_t) + 3 * sizeof(int32_t)] = 2;
+    ASSERT_FALSE(read(damaged));
+}
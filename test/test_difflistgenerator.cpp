@@ -0,0 +1,454 @@
+#include <algorithm>
+#include <array>
+#include <random>
+#include <tuple>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/diff.h"
+#include "../src/difflistgenerator.h"
+#include "gnudiff.h"
+#include "vectorlineprovider.h"
+
+static CommonEnds findEnds(const std::vector<std::string_view>& contents)
+{
+    return findCommonEnds(contents, { 0, 1, 2 });
+}
+
+TEST(TestFindCommonEnds, ends_are_cut_back_to_complete_lines)
+{
+    auto ends = findEnds({ "same\nab\nx\nend\n", "same\nac\nend\n", "same\nad\ny\nend\n" });
+    ASSERT_EQ(ends.prefixBytes, 5u);
+    ASSERT_EQ(ends.prefixLines, 1);
+    ASSERT_EQ(ends.suffixBytes, 4u);
+    ASSERT_EQ(ends.suffixLines, 1);
+
+    /* The common suffix "b\nend\n" does not start at the start of a line */
+    ends = findEnds({ "ab\nend\n", "cb\nend\n", "db\nend\n" });
+    ASSERT_EQ(ends.prefixLines, 0);
+    ASSERT_EQ(ends.suffixBytes, 4u);
+    ASSERT_EQ(ends.suffixLines, 1);
+}
+
+TEST(TestFindCommonEnds, an_empty_file_has_no_common_ends)
+{
+    auto ends = findEnds({ "", "a\n", "a\n" });
+    ASSERT_EQ(ends.prefixBytes, 0u);
+    ASSERT_EQ(ends.suffixBytes, 0u);
+    ASSERT_EQ(ends.prefixLines, 0);
+    ASSERT_EQ(ends.suffixLines, 0);
+}
+
+TEST(TestFindCommonEnds, a_file_can_be_all_prefix)
+{
+    auto ends = findEnds({ "a\nb\n", "a\nb\nc\n", "a\nb\nd\n" });
+    ASSERT_EQ(ends.prefixBytes, 4u);
+    ASSERT_EQ(ends.prefixLines, 2);
+    ASSERT_EQ(ends.suffixBytes, 0u);
+    ASSERT_EQ(ends.suffixLines, 0);
+
+    /* A last line without a newline can be the start of a longer line */
+    ends = findEnds({ "a\nb", "a\nbc\n", "a\nb\n" });
+    ASSERT_EQ(ends.prefixBytes, 2u);
+    ASSERT_EQ(ends.prefixLines, 1);
+    ASSERT_EQ(ends.suffixBytes, 0u);
+}
+
+TEST(TestFindCommonEnds, prefix_and_suffix_do_not_overlap)
+{
+    /* "a\n" is both a common prefix and a common suffix of all files */
+    auto ends = findEnds({ "a\na\n", "a\n", "a\nb\na\n" });
+    ASSERT_EQ(ends.prefixLines, 1);
+    ASSERT_EQ(ends.suffixLines, 0);
+
+    ends = findEnds({ "x\nx\nx\n", "x\nx\n", "x\nx\nx\nx\n" });
+    ASSERT_EQ(ends.prefixLines + ends.suffixLines, 2);
+    ASSERT_EQ(ends.prefixBytes + ends.suffixBytes, 4u);
+}
+
+TEST(TestFindCommonEnds, only_the_specified_files_are_compared)
+{
+    auto ends = findCommonEnds({ "a\nb\n", "x\n", "a\nc\n" }, { 0, 2 });
+    ASSERT_EQ(ends.prefixLines, 1);
+}
+
+TEST(TestFindCommonEnds, ends_are_complete_lines_that_all_files_have)
+{
+    std::mt19937 rng(1);
+    const char *lines[] = { "a\n", "b\n", "ab\n", "\n", "a", "b" };
+
+    for(int round = 0; round < 2000; round++)
+    {
+        std::string files[3];
+        for(auto& file: files)
+        {
+            int nrOfLines = std::uniform_int_distribution<int>(0, 6)(rng);
+            for(int i = 0; i < nrOfLines; i++)
+            {
+                file += lines[std::uniform_int_distribution<int>(0, 5)(rng)];
+            }
+        }
+
+        auto ends = findEnds({ files[0], files[1], files[2] });
+        for(auto& file: files)
+        {
+            ASSERT_LE(ends.prefixBytes + ends.suffixBytes, file.size());
+            ASSERT_EQ(file.substr(0, ends.prefixBytes), files[0].substr(0, ends.prefixBytes));
+            ASSERT_EQ(file.substr(file.size() - ends.suffixBytes), files[0].substr(files[0].size() - ends.suffixBytes));
+
+            /* The prefix ends and the suffix starts at the start of a line */
+            ASSERT_TRUE(ends.prefixBytes == 0 || file[ends.prefixBytes - 1] == '\n');
+            size_t suffixStart = file.size() - ends.suffixBytes;
+            ASSERT_TRUE(ends.suffixBytes == 0 || suffixStart == 0 || file[suffixStart - 1] == '\n');
+        }
+
+        auto prefix = files[0].substr(0, ends.prefixBytes);
+        ASSERT_EQ(std::count(prefix.begin(), prefix.end(), '\n'), ends.prefixLines);
+        auto suffix = files[0].substr(files[0].size() - ends.suffixBytes);
+        ASSERT_EQ(std::count(suffix.begin(), suffix.end(), '\n') + (!suffix.empty() && suffix.back() != '\n'),
+                  ends.suffixLines);
+    }
+}
+
+using DiffTuple = std::tuple<int, int, int>;
+
+static std::vector<DiffTuple> toTuples(const DiffList& diffList)
+{
+    std::vector<DiffTuple> tuples;
+    for(auto& d: diffList)
+    {
+        tuples.emplace_back(d.nofEquals, d.diff1, d.diff2);
+    }
+    return tuples;
+}
+
+static std::vector<std::string> splitLines(const std::string& content)
+{
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while(start < content.size())
+    {
+        size_t end = content.find('\n', start);
+        end = (end == std::string::npos) ? content.size() : end + 1;
+        lines.push_back(content.substr(start, end - start));
+        start = end;
+    }
+    return lines;
+}
+
+/**
+ * Diffs the files with generateDiffLists and checks that every diff list
+ * covers both of its files and only pairs lines with the same ID.
+ */
+static std::vector<DiffList> diffFiles(const std::string& a, const std::string& b, const std::string& c,
+                                       LineEquivalences& lineEquivalences)
+{
+    setProgressOutput(false);
+    VectorLineProvider lpA(splitLines(a)), lpB(splitLines(b)), lpC(splitLines(c));
+    auto diffLists = generateDiffLists({ &lpA, &lpB, &lpC }, lineEquivalences);
+
+    const std::pair<int, int> pairs[] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+    for(int i = 0; i < 3; i++)
+    {
+        auto [first, second] = pairs[i];
+        auto& ids0 = lineEquivalences.ids(first);
+        auto& ids1 = lineEquivalences.ids(second);
+        size_t line0 = 0;
+        size_t line1 = 0;
+        for(auto& d: diffLists[i])
+        {
+            for(int j = 0; j < d.nofEquals; j++)
+            {
+                EXPECT_EQ(ids0[line0 + j], ids1[line1 + j]);
+            }
+            line0 += d.nofEquals + d.diff1;
+            line1 += d.nofEquals + d.diff2;
+        }
+        EXPECT_EQ(line0, ids0.size());
+        EXPECT_EQ(line1, ids1.size());
+    }
+    return diffLists;
+}
+
+TEST(TestGenerateDiffLists, identical_files_are_not_diffed)
+{
+    LineEquivalences lineEquivalences;
+    auto diffLists = diffFiles("x\ny\n", "x\ny\n", "x\ny\n", lineEquivalences);
+    for(auto& diffList: diffLists)
+    {
+        ASSERT_EQ(toTuples(diffList), std::vector<DiffTuple>({ { 2, 0, 0 } }));
+    }
+    ASSERT_EQ(lineEquivalences.ids(1), lineEquivalences.ids(0));
+    ASSERT_EQ(lineEquivalences.ids(2), lineEquivalences.ids(0));
+
+    diffLists = diffFiles("", "", "", lineEquivalences);
+    for(auto& diffList: diffLists)
+    {
+        ASSERT_TRUE(diffList.empty());
+    }
+}
+
+TEST(TestGenerateDiffLists, a_single_diff_provides_all_lists_if_two_files_are_identical)
+{
+    std::vector<DiffTuple> unchanged = { { 2, 0, 0 } };
+    std::vector<DiffTuple> inserted = { { 1, 0, 1 }, { 1, 0, 0 } };
+    std::vector<DiffTuple> removed = { { 1, 1, 0 }, { 1, 0, 0 } };
+
+    LineEquivalences lineEquivalences;
+    auto diffLists = diffFiles("a\nb\n", "a\nb\n", "a\nx\nb\n", lineEquivalences);
+    ASSERT_EQ(toTuples(diffLists[0]), unchanged);
+    ASSERT_EQ(toTuples(diffLists[1]), inserted);
+    ASSERT_EQ(toTuples(diffLists[2]), inserted);
+    ASSERT_EQ(lineEquivalences.ids(1), lineEquivalences.ids(0));
+
+    diffLists = diffFiles("a\nb\n", "a\nx\nb\n", "a\nb\n", lineEquivalences);
+    ASSERT_EQ(toTuples(diffLists[0]), inserted);
+    ASSERT_EQ(toTuples(diffLists[1]), unchanged);
+    ASSERT_EQ(toTuples(diffLists[2]), removed);
+    ASSERT_EQ(lineEquivalences.ids(2), lineEquivalences.ids(0));
+
+    diffLists = diffFiles("a\nb\n", "a\nx\nb\n", "a\nx\nb\n", lineEquivalences);
+    ASSERT_EQ(toTuples(diffLists[0]), inserted);
+    ASSERT_EQ(toTuples(diffLists[1]), inserted);
+    ASSERT_EQ(toTuples(diffLists[2]), std::vector<DiffTuple>({ { 3, 0, 0 } }));
+    ASSERT_EQ(lineEquivalences.ids(2), lineEquivalences.ids(1));
+}
+
+TEST(TestGenerateDiffLists, lists_of_identical_files_pair_equal_lines)
+{
+    std::mt19937 rng(1);
+    const char *lines[] = { "a\n", "b\n", "c\n", "d\n" };
+    auto randomFile = [&]()
+    {
+        std::string file;
+        int nrOfLines = std::uniform_int_distribution<int>(0, 30)(rng);
+        for(int i = 0; i < nrOfLines; i++)
+        {
+            file += lines[std::uniform_int_distribution<int>(0, 3)(rng)];
+        }
+        return file;
+    };
+
+    for(int round = 0; round < 100; round++)
+    {
+        auto file1 = randomFile();
+        auto file2 = randomFile();
+        LineEquivalences lineEquivalences;
+        diffFiles(file1, file1, file2, lineEquivalences);
+        diffFiles(file1, file2, file1, lineEquivalences);
+        diffFiles(file1, file2, file2, lineEquivalences);
+        ASSERT_FALSE(testing::Test::HasFailure());
+    }
+}
+
+TEST(TestGenerateDiffLists, lines_in_the_common_ends_are_equal_to_the_same_lines_elsewhere)
+{
+    LineEquivalences lineEquivalences;
+    diffFiles("a\nS\n", "b\nS\nS\n", "b\nS\nS\n", lineEquivalences);
+
+    /* The last S is the common suffix */
+    ASSERT_TRUE(lineEquivalences.equal(0, 1, 1, 1));
+    ASSERT_TRUE(lineEquivalences.equal(0, 1, 2, 1));
+    ASSERT_TRUE(lineEquivalences.equal(1, 1, 1, 2));
+    ASSERT_FALSE(lineEquivalences.equal(0, 0, 1, 0));
+
+    diffFiles("S\nx", "S\ny\nx", "S\nz\nS\nx", lineEquivalences);
+    ASSERT_TRUE(lineEquivalences.equal(0, 0, 2, 2));
+    ASSERT_TRUE(lineEquivalences.equal(1, 2, 2, 3));
+    ASSERT_FALSE(lineEquivalences.equal(1, 1, 2, 1));
+}
+
+TEST(TestGenerateDiffLists, ids_are_equal_if_and_only_if_the_lines_are_equal)
+{
+    std::mt19937 rng(1);
+    const char *lines[] = { "a\n", "b\n", "c\n", "a" };
+    auto randomFile = [&](const std::string& prefix, const std::string& suffix)
+    {
+        std::string file = prefix;
+        int nrOfLines = std::uniform_int_distribution<int>(0, 8)(rng);
+        for(int i = 0; i < nrOfLines; i++)
+        {
+            file += lines[std::uniform_int_distribution<int>(0, 2)(rng)];
+        }
+        return file + suffix;
+    };
+
+    for(int round = 0; round < 200; round++)
+    {
+        /* Shared ends, so that the same lines occur both in and between them */
+        std::string prefix;
+        std::string suffix;
+        for(int i = std::uniform_int_distribution<int>(0, 3)(rng); i > 0; i--)
+        {
+            prefix += lines[std::uniform_int_distribution<int>(0, 2)(rng)];
+            suffix += lines[std::uniform_int_distribution<int>(0, 2)(rng)];
+        }
+        if(std::uniform_int_distribution<int>(0, 1)(rng) == 1)
+        {
+            suffix += lines[3];
+        }
+
+        std::string files[] = { randomFile(prefix, suffix), randomFile(prefix, suffix), randomFile(prefix, suffix) };
+        LineEquivalences lineEquivalences;
+        diffFiles(files[0], files[1], files[2], lineEquivalences);
+
+        std::vector<std::string> text[] = { splitLines(files[0]), splitLines(files[1]), splitLines(files[2]) };
+        for(int file1 = 0; file1 < 3; file1++)
+        {
+            for(int file2 = 0; file2 < 3; file2++)
+            {
+                for(size_t line1 = 0; line1 < text[file1].size(); line1++)
+                {
+                    for(size_t line2 = 0; line2 < text[file2].size(); line2++)
+                    {
+                        ASSERT_EQ(lineEquivalences.equal(file1, line1, file2, line2),
+                                  text[file1][line1] == text[file2][line2])
+                            << files[file1] << "|" << files[file2] << "|" << line1 << "|" << line2;
+                    }
+                }
+            }
+        }
+    }
+}
+
+extern "C" void collectHunk(int first0, int last0, int first1, int last1, void *pContext)
+{
+    static_cast<std::vector<std::array<int, 4>> *>(pContext)->push_back({ first0, last0, first1, last1 });
+}
+
+/**
+ * Diffs two lists of line IDs with gnudiff counting the lines per ID
+ * itself, as it did before the lines were marked while hashing.
+ */
+static DiffList diffCountingInGnudiff(std::vector<LineId> ids0, std::vector<LineId> ids1)
+{
+    lin equivMax = 1 + std::max(*std::max_element(ids0.begin(), ids0.end()),
+                                *std::max_element(ids1.begin(), ids1.end()));
+    comparison cmp{};
+    cmp.file[0].buffered_lines = static_cast<lin>(ids0.size());
+    cmp.file[0].equivs = ids0.data();
+    cmp.file[0].equiv_max = equivMax;
+    cmp.file[1].buffered_lines = static_cast<lin>(ids1.size());
+    cmp.file[1].equivs = ids1.data();
+    cmp.file[1].equiv_max = equivMax;
+
+    std::vector<std::array<int, 4>> hunks;
+    setHunkCallback(&collectHunk, &hunks);
+    diff_2_files(&cmp);
+
+    DiffList diffList;
+    int line0 = 0;
+    for(auto [first0, last0, first1, last1]: hunks)
+    {
+        static_cast<void>(first1);
+        diffList.push_back(Diff(first0 - 1 - line0, last0 - first0 + 1, last1 - first1 + 1));
+        line0 = last0;
+    }
+    if(line0 < static_cast<int>(ids0.size()))
+    {
+        diffList.push_back(Diff(static_cast<int>(ids0.size()) - line0, 0, 0));
+    }
+    return diffList;
+}
+
+TEST(TestGenerateDiffLists, lines_marked_while_hashing_give_the_same_diffs_as_counting_in_gnudiff)
+{
+    std::mt19937 rng(1);
+
+    for(int round = 0; round < 30; round++)
+    {
+        /* Different first and last lines leave no common ends, so gnudiff
+         * sees all lines in both cases. Some lines occur in one file only,
+         * some occur far more often than the threshold for provisionally
+         * discardable lines and the others occur about as often. */
+        int nrOfLines = std::uniform_int_distribution<int>(10, 3000)(rng);
+        int nrOfOtherLines = nrOfLines / std::uniform_int_distribution<int>(1, 64)(rng) + 1;
+        std::string files[3];
+        for(int file = 0; file < 3; file++)
+        {
+            files[file] = "first " + std::to_string(file) + "\n";
+            for(int i = 0; i < nrOfLines; i++)
+            {
+                int kind = std::uniform_int_distribution<int>(0, 9)(rng);
+                if(kind < 4)
+                {
+                    files[file] += "frequent " + std::to_string(kind) + "\n";
+                }
+                else if(kind < 7)
+                {
+                    files[file] += "only in " + std::to_string(file) + "\n";
+                }
+                else
+                {
+                    files[file] += "line " + std::to_string(std::uniform_int_distribution<int>(0, nrOfOtherLines)(rng)) + "\n";
+                }
+            }
+            files[file] += "last " + std::to_string(file) + "\n";
+        }
+
+        LineEquivalences lineEquivalences;
+        auto diffLists = diffFiles(files[0], files[1], files[2], lineEquivalences);
+
+        const std::pair<int, int> pairs[] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+        for(int i = 0; i < 3; i++)
+        {
+            auto [first, second] = pairs[i];
+            auto expected = diffCountingInGnudiff(lineEquivalences.ids(first), lineEquivalences.ids(second));
+            ASSERT_EQ(toTuples(diffLists[i]), toTuples(expected)) << "round " << round << " pair " << i;
+        }
+    }
+}
+
+using Row = std::tuple<bool, bool, bool, int, int, int>;
+
+static std::vector<Row> toRows(Diff3Table& d3ll)
+{
+    std::vector<Row> rows;
+    for(size_t i = 0; i < d3ll.size(); i++)
+    {
+        auto d3l = d3ll.get(i);
+        rows.emplace_back(d3l.bAEqB, d3l.bAEqC, d3l.bBEqC, d3l.lineA, d3l.lineB, d3l.lineC);
+    }
+    return rows;
+}
+
+TEST(TestGenerateDiff3Table, tables_are_the_same_as_from_the_diff_lists_when_diffing_again)
+{
+    setProgressOutput(false);
+    std::mt19937 rng(1);
+    const char *lines[] = { "a\n", "b\n", "c\n", "d\n" };
+    auto randomFile = [&]()
+    {
+        std::string file;
+        int nrOfLines = std::uniform_int_distribution<int>(1, 200)(rng);
+        for(int i = 0; i < nrOfLines; i++)
+        {
+            file += lines[std::uniform_int_distribution<int>(0, 3)(rng)];
+        }
+        return file;
+    };
+
+    for(int round = 0; round < 50; round++)
+    {
+        VectorLineProvider lpA(splitLines(randomFile()));
+        VectorLineProvider lpB(splitLines(randomFile()));
+        VectorLineProvider lpC(splitLines(randomFile()));
+        std::vector<ILineProvider *> lineProviders = { &lpA, &lpB, &lpC };
+
+        LineEquivalences lineEquivalences;
+        auto diff3Table = generateDiff3Table(lineProviders, lineEquivalences);
+
+        LineEquivalences expectedLineEquivalences;
+        auto diffLists = generateDiffLists(lineProviders, expectedLineEquivalences);
+        auto expected = calcTrimmedDiff3LineList(diffLists[0], diffLists[1], diffLists[2], expectedLineEquivalences);
+        ASSERT_EQ(toRows(diff3Table), toRows(expected)) << "round " << round;
+
+        /* Later diffs must work after the memory has been released as well */
+        if(round % 10 == 9)
+        {
+            releaseDiffMemory();
+        }
+    }
+}
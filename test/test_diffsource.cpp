@@ -0,0 +1,62 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/diffsource.h"
+
+static std::vector<Diff> readAll(IDiffSource& source)
+{
+    std::vector<Diff> diffs;
+    Diff d(0, 0, 0);
+    while(source.next(d))
+    {
+        diffs.push_back(d);
+    }
+    return diffs;
+}
+
+TEST(TestDiffListSource, provides_the_diffs_of_the_list)
+{
+    DiffList diffList = { Diff(1, 2, 3), Diff(4, 5, 6) };
+    DiffListSource source(diffList);
+
+    ASSERT_EQ(readAll(source), diffList);
+
+    Diff d(0, 0, 0);
+    ASSERT_FALSE(source.next(d));
+}
+
+TEST(TestDiffQueue, diffs_pushed_before_closing_are_all_provided)
+{
+    DiffQueue queue(4, 2);
+    queue.push(Diff(1, 0, 1));
+    queue.push(Diff(2, 1, 0));
+    queue.close();
+
+    ASSERT_EQ(readAll(queue), (std::vector<Diff>{ Diff(1, 0, 1), Diff(2, 1, 0) }));
+}
+
+TEST(TestDiffQueue, producer_waits_for_the_consumer_when_full)
+{
+    /* Far more diffs than fit in the queue, so the producer has to wait */
+    DiffQueue queue(3, 2);
+    std::vector<Diff> expected;
+    for(int i = 0; i < 10000; i++)
+    {
+        expected.push_back(Diff(i, i % 3, i % 5));
+    }
+
+    std::thread producer([&]()
+    {
+        for(auto& d: expected)
+        {
+            queue.push(d);
+        }
+        queue.close();
+    });
+
+    auto diffs = readAll(queue);
+    producer.join();
+
+    ASSERT_EQ(diffs, expected);
+}
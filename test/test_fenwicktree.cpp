@@ -0,0 +1,77 @@
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/fenwicktree.h"
+
+TEST(TestFenwickTree, finds_the_element_containing_a_position)
+{
+    FenwickTree tree({ 2, 0, 3, 1 });
+
+    ASSERT_EQ(tree.total(), 6);
+    ASSERT_EQ(tree.prefixSum(0), 0);
+    ASSERT_EQ(tree.prefixSum(2), 2);
+    ASSERT_EQ(tree.prefixSum(3), 5);
+
+    int offset;
+    ASSERT_EQ(tree.find(0, offset), 0u);
+    ASSERT_EQ(offset, 0);
+    ASSERT_EQ(tree.find(1, offset), 0u);
+    ASSERT_EQ(offset, 1);
+    /* Element 1 is empty, so position 2 is in element 2 */
+    ASSERT_EQ(tree.find(2, offset), 2u);
+    ASSERT_EQ(offset, 0);
+    ASSERT_EQ(tree.find(5, offset), 3u);
+    ASSERT_EQ(offset, 0);
+    ASSERT_EQ(tree.find(6, offset), 4u);
+}
+
+TEST(TestFenwickTree, empty_tree_contains_no_positions)
+{
+    FenwickTree tree;
+    int offset;
+    ASSERT_EQ(tree.total(), 0);
+    ASSERT_EQ(tree.find(0, offset), 0u);
+}
+
+TEST(TestFenwickTree, same_as_linear_sums_after_changes)
+{
+    std::mt19937 rng(1);
+
+    for(int iteration = 0; iteration < 100; iteration++)
+    {
+        std::vector<int> counts(std::uniform_int_distribution<int>(1, 70)(rng));
+        for(auto& count: counts)
+        {
+            count = std::uniform_int_distribution<int>(0, 4)(rng);
+        }
+        FenwickTree tree(counts);
+
+        for(int change = 0; change < 20; change++)
+        {
+            size_t index = std::uniform_int_distribution<size_t>(0, counts.size() - 1)(rng);
+            counts[index] = std::uniform_int_distribution<int>(0, 4)(rng);
+            tree.set(index, counts[index]);
+
+            for(size_t i = 0; i <= counts.size(); i++)
+            {
+                ASSERT_EQ(tree.prefixSum(i), std::accumulate(counts.begin(), counts.begin() + i, 0));
+            }
+
+            int position = 0;
+            for(size_t i = 0; i < counts.size(); i++)
+            {
+                for(int offset = 0; offset < counts[i]; offset++)
+                {
+                    int foundOffset;
+                    ASSERT_EQ(tree.find(position, foundOffset), i);
+                    ASSERT_EQ(foundOffset, offset);
+                    position++;
+                }
+            }
+            int foundOffset;
+            ASSERT_EQ(tree.find(position, foundOffset), counts.size());
+        }
+    }
+}
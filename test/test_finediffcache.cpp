@@ -0,0 +1,104 @@
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "../src/diff.h"
+#include "../src/finediffcache.h"
+#include "vectorlineprovider.h"
+
+static Diff3Table changedRows(int nrOfRows)
+{
+    Diff3Table diff3Table;
+    for(int i = 0; i < nrOfRows; i++)
+    {
+        diff3Table.push_back(Diff3Line{ i, i, i, true, false, false });
+    }
+    return diff3Table;
+}
+
+static std::vector<std::string> lines(int nrOfLines, const std::string& suffix)
+{
+    std::vector<std::string> result;
+    for(int i = 0; i < nrOfLines; i++)
+    {
+        result.push_back("line " + std::to_string(i) + suffix);
+    }
+    return result;
+}
+
+TEST(TestFineDiffCache, styles_are_the_same_as_when_calculated_directly)
+{
+    VectorLineProvider lpA(lines(20, " a\n"));
+    VectorLineProvider lpB(lines(20, " a\n"));
+    VectorLineProvider lpC(lines(20, " c\n"));
+    auto diff3Table = changedRows(20);
+
+    FineDiffCache cache(diff3Table, lpA, lpB, lpC, FineDiffGranularity::CHARACTER, 8, 2);
+    for(int row: { 5, 0, 19, 5, 12 })
+    {
+        auto expected = determineFineDiffStylePerLine(diff3Table.get(row), lpA, lpB, lpC);
+        for(int i = 0; i < 3; i++)
+        {
+            ASSERT_EQ(cache.getStyle(row, i), expected[i]) << "row " << row << " line " << i;
+        }
+    }
+}
+
+TEST(TestFineDiffCache, rows_with_equal_lines_are_not_calculated)
+{
+    VectorLineProvider lpA(lines(1000, "\n"));
+    VectorLineProvider lpB(lines(1000, "\n"));
+    VectorLineProvider lpC(lines(1000, "\n"));
+    Diff3Table diff3Table;
+    for(int i = 0; i < 1000; i++)
+    {
+        diff3Table.push_back(Diff3Line{ i, i, i, true, true, true });
+    }
+
+    FineDiffCache cache(diff3Table, lpA, lpB, lpC);
+    ASSERT_TRUE(cache.getStyle(500, 0).empty());
+    cache.prefetch(0, 999);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    ASSERT_EQ(lpA.m_nrOfGets, 0);
+    ASSERT_EQ(cache.size(), 0u);
+}
+
+TEST(TestFineDiffCache, cache_does_not_grow_beyond_its_capacity)
+{
+    VectorLineProvider lpA(lines(100, " a\n"));
+    VectorLineProvider lpB(lines(100, " b\n"));
+    VectorLineProvider lpC(lines(100, " c\n"));
+    auto diff3Table = changedRows(100);
+
+    FineDiffCache cache(diff3Table, lpA, lpB, lpC, FineDiffGranularity::CHARACTER, 10, 50);
+    for(int row = 0; row < 100; row++)
+    {
+        cache.getStyle(row, 0);
+        ASSERT_LE(cache.size(), 10u);
+    }
+}
+
+TEST(TestFineDiffCache, rows_around_a_requested_row_are_prefetched)
+{
+    VectorLineProvider lpA(lines(1000, " a\n"));
+    VectorLineProvider lpB(lines(1000, " b\n"));
+    VectorLineProvider lpC(lines(1000, " c\n"));
+    auto diff3Table = changedRows(1000);
+
+    FineDiffCache cache(diff3Table, lpA, lpB, lpC, FineDiffGranularity::CHARACTER, 100, 10);
+    cache.getStyle(500, 0);
+
+    /* Rows 490 to 510 end up in the cache */
+    for(int attempt = 0; attempt < 1000 && cache.size() < 21; attempt++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    ASSERT_EQ(cache.size(), 21u);
+
+    /* Getting a prefetched row does not read any lines */
+    int nrOfGets = lpA.m_nrOfGets;
+    cache.getStyle(495, 1);
+    ASSERT_EQ(lpA.m_nrOfGets, nrOfGets);
+}
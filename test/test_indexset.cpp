@@ -0,0 +1,68 @@
+#include <random>
+#include <set>
+
+#include "gtest/gtest.h"
+#include "../src/indexset.h"
+
+TEST(TestIndexSet, finds_members_across_words)
+{
+    IndexSet set(200);
+    set.set(3, true);
+    set.set(130, true);
+
+    ASSERT_EQ(set.count(), 2u);
+    ASSERT_EQ(set.findFrom(0), 3u);
+    ASSERT_EQ(set.findFrom(4), 130u);
+    ASSERT_EQ(set.findFrom(131), IndexSet::npos);
+    ASSERT_EQ(set.findUpTo(199), 130u);
+    ASSERT_EQ(set.findUpTo(129), 3u);
+    ASSERT_EQ(set.findUpTo(2), IndexSet::npos);
+
+    set.set(3, false);
+    ASSERT_EQ(set.count(), 1u);
+    ASSERT_EQ(set.findFrom(0), 130u);
+    ASSERT_EQ(set.findUpTo(129), IndexSet::npos);
+}
+
+TEST(TestIndexSet, empty_set_has_no_members)
+{
+    IndexSet set;
+    ASSERT_EQ(set.findFrom(0), IndexSet::npos);
+    ASSERT_EQ(set.findUpTo(0), IndexSet::npos);
+}
+
+TEST(TestIndexSet, same_as_ordered_set)
+{
+    std::mt19937 rng(1);
+
+    /* Large enough for three levels, sparse enough to skip empty words */
+    const size_t size = 10000;
+    IndexSet set(size);
+    std::set<size_t> expected;
+
+    for(int change = 0; change < 2000; change++)
+    {
+        size_t index = std::uniform_int_distribution<size_t>(0, size - 1)(rng);
+        bool isMember = std::uniform_int_distribution<int>(0, 2)(rng) != 0;
+        set.set(index, isMember);
+        if(isMember)
+        {
+            expected.insert(index);
+        }
+        else
+        {
+            expected.erase(index);
+        }
+
+        ASSERT_EQ(set.count(), expected.size());
+        for(int query = 0; query < 10; query++)
+        {
+            size_t from = std::uniform_int_distribution<size_t>(0, size)(rng);
+            auto next = expected.lower_bound(from);
+            ASSERT_EQ(set.findFrom(from), next == expected.end() ? IndexSet::npos : *next);
+
+            auto after = expected.upper_bound(from);
+            ASSERT_EQ(set.findUpTo(from), after == expected.begin() ? IndexSet::npos : *std::prev(after));
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../src/linenumbercontentprovider.h"
+
+TEST(TestLineNumberContentProvider, line_numbers_are_those_of_the_file_in_each_row)
+{
+    Diff3Table diff3Table;
+    for(int i = 0; i < 1000; i++)
+    {
+        diff3Table.push_back(Diff3Line{ i, i, i, true, true, true });
+    }
+    diff3Table.push_back(Diff3Line{ 1000, -1, 1000, false, true, false });
+    for(int i = 0; i < 1000; i++)
+    {
+        diff3Table.push_back(Diff3Line{ 1001 + i, 1000 + i, 1001 + i, true, true, true });
+    }
+
+    int height = static_cast<int>(diff3Table.size());
+    LineNumberContentProvider lnpB(5, height, diff3Table, 1);
+    ASSERT_EQ(lnpB.getContentWidth(), 5);
+    ASSERT_EQ(lnpB.getContentHeight(), height);
+
+    ASSERT_EQ(lnpB.get(0), std::optional<std::string>("00000"));
+    ASSERT_EQ(lnpB.get(999), std::optional<std::string>("00999"));
+    ASSERT_EQ(lnpB.get(1000), std::nullopt);
+    ASSERT_EQ(lnpB.get(1001), std::optional<std::string>("01000"));
+    ASSERT_EQ(lnpB.get(2000), std::optional<std::string>("01999"));
+    ASSERT_EQ(lnpB.get(height), std::nullopt);
+
+    LineNumberContentProvider lnpA(5, height, diff3Table, 0);
+    ASSERT_EQ(lnpA.get(1000), std::optional<std::string>("01000"));
+    ASSERT_EQ(lnpA.get(2000), std::optional<std::string>("02000"));
+}
@@ -0,0 +1,104 @@
+#include <chrono>
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../src/diff.h"
+#include "../src/longlinediff.h"
+
+static std::string randomText(std::mt19937& rng, size_t size)
+{
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string text;
+    text.reserve(size);
+    for(size_t i = 0; i < size; i++)
+    {
+        text += alphabet[std::uniform_int_distribution<int>(0, 63)(rng)];
+    }
+    return text;
+}
+
+/*
+ * Checks that the diff list covers both lines and that the stretches it
+ * calls equal really are. Returns the number of equal bytes.
+ */
+static size_t checkDiffList(const DiffList& diffList, std::string_view line1, std::string_view line2)
+{
+    size_t pos1 = 0;
+    size_t pos2 = 0;
+    size_t equalBytes = 0;
+    for(auto& d: diffList)
+    {
+        EXPECT_EQ(line1.substr(pos1, d.nofEquals), line2.substr(pos2, d.nofEquals));
+        equalBytes += d.nofEquals;
+        pos1 += d.nofEquals + d.diff1;
+        pos2 += d.nofEquals + d.diff2;
+    }
+    EXPECT_EQ(pos1, line1.size());
+    EXPECT_EQ(pos2, line2.size());
+    return equalBytes;
+}
+
+TEST(TestLongLineDiff, identical_lines_are_equal)
+{
+    std::mt19937 rng(1);
+    auto line = randomText(rng, 100000);
+
+    ASSERT_EQ(calcLongLineDiff(line, line), DiffList({ Diff(100000, 0, 0) }));
+}
+
+TEST(TestLongLineDiff, small_edits_are_found_exactly)
+{
+    std::mt19937 rng(1);
+    auto line1 = randomText(rng, 200000);
+    auto line2 = line1;
+    line2.replace(1000, 3, "xyz!");
+    line2.erase(150000, 10);
+    line2.insert(60000, "inserted");
+
+    auto diffList = calcLongLineDiff(line1, line2);
+
+    size_t equalBytes = checkDiffList(diffList, line1, line2);
+    ASSERT_EQ(equalBytes, line1.size() - 3 - 10);
+}
+
+TEST(TestLongLineDiff, moved_and_repeated_parts_still_give_a_valid_diff)
+{
+    std::mt19937 rng(2);
+    auto part1 = randomText(rng, 30000);
+    auto part2 = randomText(rng, 30000);
+    auto repeated = randomText(rng, 300);
+    auto line1 = part1 + repeated + part2 + repeated + repeated;
+    auto line2 = part2 + repeated + part1 + repeated;
+
+    auto diffList = calcLongLineDiff(line1, line2);
+
+    size_t equalBytes = checkDiffList(diffList, line1, line2);
+    ASSERT_GE(equalBytes, 30000u);
+}
+
+TEST(TestLongLineDiff, unrelated_lines_take_bounded_time)
+{
+    std::mt19937 rng(3);
+    auto line1 = randomText(rng, 4000000);
+    auto line2 = randomText(rng, 4000000);
+
+    auto start = std::chrono::steady_clock::now();
+    auto diffList = calcLongLineDiff(line1, line2);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    checkDiffList(diffList, line1, line2);
+    ASSERT_LT(elapsed, std::chrono::seconds(5));
+}
+
+TEST(TestLongLineDiff, fine_diff_uses_it_for_long_lines)
+{
+    std::mt19937 rng(4);
+    auto line1 = randomText(rng, LONG_LINE_THRESHOLD * 10);
+    auto line2 = line1;
+    line2[LONG_LINE_THRESHOLD * 5] = '!';
+
+    auto diffList = fineDiff(0, 0, line1, line2);
+
+    ASSERT_EQ(checkDiffList(diffList, line1, line2), line1.size() - 1);
+}
@@ -0,0 +1,240 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "../src/mergeresultwriter.h"
+#include "../src/mmappedfilelineprovider.h"
+#include "tempfilename.h"
+#include "vectorlineprovider.h"
+
+struct Merge
+{
+    Merge(const std::vector<Diff3Line>& d3ls,
+          std::vector<std::string> a, std::vector<std::string> b, std::vector<std::string> c):
+        lpA(std::move(a)), lpB(std::move(b)), lpC(std::move(c))
+    {
+        for(auto& d3l: d3ls)
+        {
+            diff3Table.push_back(d3l);
+        }
+        contentMapper.determineMergeResultSections(diff3Table);
+        contentMapper.automaticallyResolveDifferences(diff3Table);
+    }
+
+    std::string write(size_t expectedConflicts)
+    {
+        std::ostringstream output;
+        EXPECT_EQ(writeMergeResult(output, contentMapper, { &lpA, &lpB, &lpC }, { "base", "ours", "theirs" }),
+                  expectedConflicts);
+        return output.str();
+    }
+
+    std::string writeToFile(size_t expectedConflicts)
+    {
+        std::unique_ptr<FILE, int (*)(FILE *)> file(tmpfile(), fclose);
+        EXPECT_EQ(writeMergeResult(fileno(file.get()), contentMapper, { &lpA, &lpB, &lpC }, { "base", "ours", "theirs" }),
+                  expectedConflicts);
+
+        std::string content;
+        char buffer[4096];
+        rewind(file.get());
+        size_t count;
+        while((count = fread(buffer, 1, sizeof(buffer), file.get())) > 0)
+        {
+            content.append(buffer, count);
+        }
+        return content;
+    }
+
+    VectorLineProvider lpA, lpB, lpC;
+    Diff3Table diff3Table;
+    ContentMapper contentMapper;
+};
+
+TEST(TestMergeResultWriter, resolved_differences_are_written_without_markers)
+{
+    Merge merge({ { 0, 0, 0, true, true, true },
+                  { 1, 1, 1, false, true, false },
+                  { -1, 2, -1, false, true, false },
+                  { 2, 3, 2, true, true, true } },
+                { "x\n", "a\n", "z\n" },
+                { "x\n", "b\n", "new\n", "z\n" },
+                { "x\n", "a\n", "z\n" });
+
+    ASSERT_EQ(merge.write(0), "x\nb\nnew\nz\n");
+}
+
+TEST(TestMergeResultWriter, conflicts_are_written_between_markers)
+{
+    Merge merge({ { 0, 0, 0, true, true, true },
+                  { 1, 1, 1, false, false, false },
+                  { -1, 2, -1, false, false, false } },
+                { "x\n", "a" },
+                { "x\n", "b\n", "b2\n" },
+                { "x\n", "c\n" });
+
+    ASSERT_EQ(merge.write(1), "x\n"
+                              "<<<<<<< ours\nb\nb2\n"
+                              "||||||| base\na\n"
+                              "=======\nc\n"
+                              ">>>>>>> theirs\n");
+}
+
+TEST(TestMergeResultWriter, edits_are_written_instead_of_conflicts)
+{
+    Merge merge({ { 0, 0, 0, false, false, false },
+                  { 1, 1, 1, true, true, true } },
+                { "a\n", "z\n" },
+                { "b\n", "z\n" },
+                { "c\n", "z\n" });
+
+    merge.contentMapper.applyModification(Modification{ 0, 1, { "e\n", "f\n" } });
+    ASSERT_EQ(merge.write(0), "e\nf\nz\n");
+
+    /* Removing all lines of a difference leaves a line without a source */
+    merge.contentMapper.applyModification(Modification{ 0, 2, {} });
+    ASSERT_EQ(merge.write(0), "z\n");
+}
+
+TEST(TestMergeResultWriter, runs_of_lines_are_copied_from_the_input_files)
+{
+    std::vector<std::string> a, b, c;
+    std::vector<Diff3Line> d3ls;
+    for(int i = 0; i < 30000; i++)
+    {
+        a.push_back("line " + std::to_string(i) + "\n");
+        b.push_back(i % 10000 == 5000 ? "changed\n" : a.back());
+        c.push_back(i == 20000 ? "other\n" : a.back());
+        bool aEqB = (a.back() == b.back());
+        bool aEqC = (a.back() == c.back());
+        d3ls.push_back(Diff3Line{ i, i, i, aEqB, aEqC, b.back() == c.back() });
+    }
+
+    Merge merge(d3ls, a, b, c);
+    auto expected = merge.write(0);
+    ASSERT_NE(expected.find("changed\n"), std::string::npos);
+    ASSERT_NE(expected.find("other\n"), std::string::npos);
+
+    /* Without file descriptors all fragments are written from memory */
+    ASSERT_EQ(merge.writeToFile(0), expected);
+
+    merge.lpA.storeInFile();
+    merge.lpB.storeInFile();
+    merge.lpC.storeInFile();
+    ASSERT_EQ(merge.writeToFile(0), expected);
+}
+
+TEST(TestMergeResultWriter, segments_are_saved_in_parallel)
+{
+    std::vector<std::string> a, b, c;
+    std::vector<Diff3Line> d3ls;
+    for(int i = 0; i < 300000; i++)
+    {
+        a.push_back("a line that is long enough to be split " + std::to_string(i) + "\n");
+        b.push_back(i % 100000 == 50000 ? "changed\n" : a.back());
+        c.push_back(i % 70000 == 1 ? "other\n" : a.back());
+        bool aEqB = (a.back() == b.back());
+        bool aEqC = (a.back() == c.back());
+        d3ls.push_back(Diff3Line{ i, i, i, aEqB, aEqC, b.back() == c.back() });
+    }
+
+    Merge merge(d3ls, a, b, c);
+    merge.contentMapper.applyModification(Modification{ 123456, 2, { "edited\n" } });
+    merge.lpA.storeInFile();
+    auto expected = merge.write(0);
+    ASSERT_GT(expected.size(), 3 * 4 * 1024 * 1024u);
+
+    std::string fileName = tempFileName("merge_result");
+    {
+        std::ofstream existing(fileName);
+        existing << "previous content";
+    }
+    chmod(fileName.c_str(), 0640);
+
+    WorkerPool workerPool(2);
+    ASSERT_EQ(saveMergeResult(fileName, merge.contentMapper, { &merge.lpA, &merge.lpB, &merge.lpC },
+                              { "base", "ours", "theirs" }, workerPool), 0u);
+
+    std::ifstream saved(fileName, std::ios::binary);
+    ASSERT_EQ(std::string(std::istreambuf_iterator<char>(saved), std::istreambuf_iterator<char>()), expected);
+
+    struct stat statbuf;
+    ASSERT_EQ(stat(fileName.c_str(), &statbuf), 0);
+    ASSERT_EQ(statbuf.st_mode & 0777, 0640u);
+    remove(fileName.c_str());
+}
+
+TEST(TestMergeResultWriter, an_input_file_can_be_saved_over_itself)
+{
+    std::string content;
+    for(int i = 0; i < 100000; i++)
+    {
+        content += "line " + std::to_string(i) + "\n";
+    }
+
+    std::string fileNames[3];
+    for(int i = 0; i < 3; i++)
+    {
+        fileNames[i] = tempFileName("input" + std::to_string(i));
+        std::ofstream file(fileNames[i], std::ios::binary);
+        file << (i == 0 ? "base\n" : content);
+    }
+
+    {
+        MmappedFileLineProvider lpA(fileNames[0]), lpB(fileNames[1]), lpC(fileNames[2]);
+        saveInputFile(fileNames[1], { &lpA, &lpB, &lpC }, 2);
+    }
+
+    std::ifstream saved(fileNames[1], std::ios::binary);
+    ASSERT_EQ(std::string(std::istreambuf_iterator<char>(saved), std::istreambuf_iterator<char>()), content);
+
+    for(auto& fileName: fileNames)
+    {
+        remove(fileName.c_str());
+    }
+}
+
+TEST(TestMergeResultWriter, links_to_the_output_file_are_kept)
+{
+    Merge merge({ Diff3Line{ 0, 0, 0, true, true, true },
+                  Diff3Line{ 1, 1, 1, false, true, false } },
+                { "same\n", "base\n" }, { "same\n", "ours\n" }, { "same\n", "base\n" });
+    auto expected = merge.write(0);
+
+    std::string fileName = tempFileName("merge_result");
+    std::string symbolicLinkName = fileName + "_symbolic";
+    std::string hardLinkName = fileName + "_hard";
+    {
+        std::ofstream existing(fileName);
+        existing << "a previous content that is longer than the merge result\n";
+    }
+    ASSERT_EQ(symlink(fileName.c_str(), symbolicLinkName.c_str()), 0);
+    ASSERT_EQ(link(fileName.c_str(), hardLinkName.c_str()), 0);
+
+    ASSERT_EQ(saveMergeResult(symbolicLinkName, merge.contentMapper, { &merge.lpA, &merge.lpB, &merge.lpC },
+                              { "base", "ours", "theirs" }), 0u);
+
+    struct stat statbuf;
+    ASSERT_EQ(lstat(symbolicLinkName.c_str(), &statbuf), 0);
+    ASSERT_TRUE(S_ISLNK(statbuf.st_mode));
+    ASSERT_EQ(stat(fileName.c_str(), &statbuf), 0);
+    ASSERT_EQ(statbuf.st_nlink, 2u);
+
+    for(auto& name: { fileName, hardLinkName })
+    {
+        std::ifstream saved(name, std::ios::binary);
+        ASSERT_EQ(std::string(std::istreambuf_iterator<char>(saved), std::istreambuf_iterator<char>()), expected);
+    }
+
+    remove(symbolicLinkName.c_str());
+    remove(hardLinkName.c_str());
+    remove(fileName.c_str());
+}
@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/mergestate.h"
+#include "tempfilename.h"
+
+class TestMergeState: public testing::Test
+{
+protected:
+    TestMergeState():
+        stateFileName(tempFileName("state"))
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            inputFileNames.push_back(tempFileName("input" + std::to_string(i)));
+            std::ofstream(inputFileNames.back()) << "input " << i << "\n";
+        }
+
+        for(int i = 0; i < 1000; i++)
+        {
+            bool aEqB = (i % 100 != 10);
+            bool aEqC = (i % 100 != 20);
+            diff3Table.push_back(Diff3Line{ i, i, i, aEqB, aEqC, aEqB && aEqC });
+        }
+        contentMapper.determineMergeResultSections(diff3Table);
+        contentMapper.automaticallyResolveDifferences(diff3Table);
+    }
+
+    ~TestMergeState()
+    {
+        remove(stateFileName.c_str());
+        for(auto& inputFileName: inputFileNames)
+        {
+            remove(inputFileName.c_str());
+        }
+    }
+
+    std::string stateFileName;
+    std::vector<std::string> inputFileNames;
+    Diff3Table diff3Table;
+    ContentMapper contentMapper;
+};
+
+TEST_F(TestMergeState, saved_state_is_loaded_for_the_same_input_files)
+{
+    auto stateId = saveMergeState(stateFileName, inputFileNames, diff3Table, contentMapper);
+
+    Diff3Table loadedTable;
+    ContentMapper loadedContentMapper;
+    uint64_t loadedStateId;
+    ASSERT_TRUE(loadMergeState(stateFileName, inputFileNames, loadedTable, loadedContentMapper, loadedStateId));
+    ASSERT_EQ(loadedStateId, stateId);
+
+    ASSERT_EQ(loadedTable.size(), diff3Table.size());
+    for(size_t i = 0; i < diff3Table.size(); i++)
+    {
+        auto expected = diff3Table.get(i);
+        auto loaded = loadedTable.get(i);
+        ASSERT_EQ(loaded.lineA, expected.lineA);
+        ASSERT_EQ(loaded.lineC, expected.lineC);
+        ASSERT_EQ(loaded.bAEqB, expected.bAEqB);
+        ASSERT_EQ(loaded.bBEqC, expected.bBEqC);
+    }
+
+    ASSERT_EQ(loadedContentMapper.getNumberOfSections(), contentMapper.getNumberOfSections());
+    for(size_t i = 0; i < contentMapper.getNumberOfSections(); i++)
+    {
+        auto& expected = contentMapper.getSection(i);
+        auto& loaded = loadedContentMapper.getSection(i);
+        ASSERT_EQ(loaded.isDifference(), expected.isDifference());
+        ASSERT_EQ(loaded.getLineNumberRange(LineSource::B).firstLine, expected.getLineNumberRange(LineSource::B).firstLine);
+        ASSERT_EQ(loaded.getDiff3LineNumberRange().lastLine, expected.getDiff3LineNumberRange().lastLine);
+        ASSERT_EQ(loaded.getSelectedSources(), expected.getSelectedSources());
+    }
+    ASSERT_EQ(loadedContentMapper.getContentHeight(), contentMapper.getContentHeight());
+}
+
+TEST_F(TestMergeState, state_is_not_loaded_if_an_input_file_changed)
+{
+    saveMergeState(stateFileName, inputFileNames, diff3Table, contentMapper);
+    std::ofstream(inputFileNames[1], std::ios::app) << "another line\n";
+
+    Diff3Table loadedTable;
+    ContentMapper loadedContentMapper;
+    uint64_t loadedStateId;
+    ASSERT_FALSE(loadMergeState(stateFileName, inputFileNames, loadedTable, loadedContentMapper, loadedStateId));
+    ASSERT_EQ(loadedContentMapper.getNumberOfSections(), 0u);
+}
@@ -0,0 +1,89 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/piecetable.h"
+
+/*
+ * Returns original lines as their line number and added lines as their text.
+ */
+static std::vector<std::string> content(const PieceTable& pieceTable)
+{
+    std::vector<std::string> lines;
+    for(int i = 0; i < pieceTable.size(); i++)
+    {
+        auto line = pieceTable.getLine(i);
+        lines.push_back(line.isOriginal ? std::to_string(line.index) : std::string(line.text));
+    }
+    return lines;
+}
+
+TEST(TestPieceTable, lines_are_replaced)
+{
+    PieceTable pieceTable(5);
+    pieceTable.replace(1, 2, { "a", "b", "c" });
+
+    ASSERT_EQ(content(pieceTable), (std::vector<std::string>{ "0", "a", "b", "c", "3", "4" }));
+
+    pieceTable.replace(0, 4, {});
+    ASSERT_EQ(content(pieceTable), (std::vector<std::string>{ "3", "4" }));
+
+    pieceTable.replace(2, 0, { "d" });
+    ASSERT_EQ(content(pieceTable), (std::vector<std::string>{ "3", "4", "d" }));
+}
+
+TEST(TestPieceTable, copies_keep_their_content)
+{
+    PieceTable pieceTable(3);
+    pieceTable.replace(1, 1, { "a" });
+    PieceTable copy = pieceTable;
+
+    pieceTable.replace(0, 2, { "b" });
+
+    ASSERT_EQ(content(copy), (std::vector<std::string>{ "0", "a", "2" }));
+    ASSERT_EQ(content(pieceTable), (std::vector<std::string>{ "b", "2" }));
+}
+
+TEST(TestPieceTable, large_insert_is_a_single_piece)
+{
+    PieceTable pieceTable(100000);
+    pieceTable.replace(50000, 0, std::vector<std::string>(100000, "pasted"));
+
+    ASSERT_EQ(pieceTable.size(), 200000);
+    ASSERT_EQ(pieceTable.getNumberOfPieces(), 3);
+    ASSERT_EQ(pieceTable.getLine(150000).index, 50000);
+}
+
+TEST(TestPieceTable, same_as_vector_of_lines)
+{
+    std::mt19937 rng(1);
+
+    for(int iteration = 0; iteration < 50; iteration++)
+    {
+        int originalLineCount = std::uniform_int_distribution<int>(0, 50)(rng);
+        PieceTable pieceTable(originalLineCount);
+        std::vector<std::string> expected;
+        for(int i = 0; i < originalLineCount; i++)
+        {
+            expected.push_back(std::to_string(i));
+        }
+
+        for(int edit = 0; edit < 100; edit++)
+        {
+            int firstLine = std::uniform_int_distribution<int>(0, expected.size())(rng);
+            int lineCount = std::uniform_int_distribution<int>(0, std::min<int>(3, expected.size() - firstLine))(rng);
+            std::vector<std::string> lines(std::uniform_int_distribution<int>(0, 3)(rng));
+            for(auto& line: lines)
+            {
+                line = "edit " + std::to_string(edit);
+            }
+
+            pieceTable.replace(firstLine, lineCount, lines);
+            expected.erase(expected.begin() + firstLine, expected.begin() + firstLine + lineCount);
+            expected.insert(expected.begin() + firstLine, lines.begin(), lines.end());
+
+            ASSERT_EQ(content(pieceTable), expected) << "iteration " << iteration << " edit " << edit;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+#include "gtest/gtest.h"
+#include "../src/resolutionjournal.h"
+#include "tempfilename.h"
+
+static std::vector<std::string> mergeResult(const ContentMapper& contentMapper)
+{
+    std::vector<std::string> lines;
+    for(int i = 0; i < contentMapper.getContentHeight(); i++)
+    {
+        auto lineInfo = contentMapper.getMergeResultLineInfo(i);
+        if(lineInfo.state == LineState::EDITED && lineInfo.lineNumber != -1)
+        {
+            lines.emplace_back(contentMapper.getEditedLine(lineInfo.sectionIndex, lineInfo.lineNumber));
+        }
+        else
+        {
+            lines.push_back(std::to_string(static_cast<int>(lineInfo.state)) + ":" +
+                            std::to_string(static_cast<int>(lineInfo.source)) + ":" +
+                            std::to_string(lineInfo.lineNumber));
+        }
+    }
+    return lines;
+}
+
+class TestResolutionJournal: public testing::Test
+{
+protected:
+    TestResolutionJournal():
+        journalFileName(tempFileName("journal"))
+    {
+        remove(journalFileName.c_str());
+        for(int i = 0; i < 100; i++)
+        {
+            bool equal = (i % 10 != 5);
+            diff3Table.push_back(Diff3Line{ i, i, i, equal, equal, equal });
+        }
+    }
+
+    ~TestResolutionJournal()
+    {
+        remove(journalFileName.c_str());
+    }
+
+    ContentMapper createContentMapper()
+    {
+        ContentMapper contentMapper;
+        contentMapper.determineMergeResultSections(diff3Table);
+        return contentMapper;
+    }
+
+    std::string journalFileName;
+    Diff3Table diff3Table;
+};
+
+TEST_F(TestResolutionJournal, replaying_the_journal_restores_the_merge_result)
+{
+    auto contentMapper = createContentMapper();
+    {
+        ResolutionJournal journal(journalFileName, 42);
+        contentMapper.setActionListener(&journal);
+        contentMapper.toggleSectionSource(1, LineSource::A);
+        contentMapper.toggleSectionSource(3, LineSource::B);
+        contentMapper.applyModification(Modification{ 2, 5, { "x", "y" } });
+        contentMapper.applyModification(Modification{ 30, 0, { "inserted" } });
+        contentMapper.undo();
+        contentMapper.undo();
+        contentMapper.redo();
+        contentMapper.toggleSectionSource(5, LineSource::C);
+        contentMapper.setActionListener(nullptr);
+    }
+
+    auto resumed = createContentMapper();
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 42, resumed), 8u);
+    ASSERT_EQ(mergeResult(resumed), mergeResult(contentMapper));
+    ASSERT_EQ(resumed.getHistoryPosition(), contentMapper.getHistoryPosition());
+
+    /* A journal of another state is not replayed */
+    auto other = createContentMapper();
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 43, other), 0u);
+    ASSERT_EQ(mergeResult(other), mergeResult(createContentMapper()));
+}
+
+TEST_F(TestResolutionJournal, a_damaged_end_is_cut_off)
+{
+    auto contentMapper = createContentMapper();
+    {
+        ResolutionJournal journal(journalFileName, 7);
+        contentMapper.setActionListener(&journal);
+        contentMapper.toggleSectionSource(1, LineSource::A);
+        contentMapper.applyModification(Modification{ 0, 1, { "first edit" } });
+        contentMapper.setActionListener(nullptr);
+    }
+    auto expected = mergeResult(contentMapper);
+
+    /* Half of a record, as if the system went down while it was written */
+    {
+        std::ofstream journal(journalFileName, std::ios::binary | std::ios::app);
+        journal.write("\x20\x00\x00\x00\x12\x34", 6);
+    }
+
+    auto resumed = createContentMapper();
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 7, resumed), 2u);
+    ASSERT_EQ(mergeResult(resumed), expected);
+
+    /* Actions after the replay follow the last valid one */
+    {
+        ResolutionJournal journal(journalFileName, 7);
+        resumed.setActionListener(&journal);
+        resumed.toggleSectionSource(3, LineSource::B);
+        resumed.setActionListener(nullptr);
+    }
+
+    auto resumedAgain = createContentMapper();
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 7, resumedAgain), 3u);
+    ASSERT_EQ(mergeResult(resumedAgain), mergeResult(resumed));
+}
+
+TEST_F(TestResolutionJournal, a_journal_of_another_state_is_started_over)
+{
+    auto contentMapper = createContentMapper();
+    {
+        ResolutionJournal journal(journalFileName, 1);
+        contentMapper.setActionListener(&journal);
+        contentMapper.toggleSectionSource(1, LineSource::A);
+        contentMapper.setActionListener(nullptr);
+    }
+    {
+        ResolutionJournal journal(journalFileName, 2);
+    }
+
+    auto resumed = createContentMapper();
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 1, resumed), 0u);
+    ASSERT_EQ(ResolutionJournal::replay(journalFileName, 2, resumed), 0u);
+}
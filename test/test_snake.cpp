@@ -0,0 +1,104 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gnudiff.h"
+
+/* Lines around the range, which the kernels must not look at */
+static const lin GUARD = 16;
+
+static std::vector<snake_kernel> getKernels()
+{
+    const snake_kernel *kernels;
+    int nrOfKernels = snake_kernels(&kernels);
+    return std::vector<snake_kernel>(kernels, kernels + nrOfKernels);
+}
+
+/**
+ * Checks every kernel on a range of n equal lines, and then with a line
+ * that differs at every position of the range in the low half, the high
+ * half or the sign of the line.
+ */
+static void checkRange(const snake_kernel& kernel, lin n, bool guardsAreEqual)
+{
+    std::mt19937_64 rng(n);
+    std::vector<lin> x(n + 2 * GUARD);
+    for(auto& line: x)
+    {
+        line = static_cast<lin>(rng());
+    }
+    std::vector<lin> y = x;
+    if(!guardsAreEqual)
+    {
+        for(lin i = 0; i < GUARD; i++)
+        {
+            y[i] = ~x[i];
+            y[GUARD + n + i] = ~x[GUARD + n + i];
+        }
+    }
+
+    const lin *xv = x.data() + GUARD;
+    const lin *yv = y.data() + GUARD;
+    ASSERT_EQ(kernel.forward(xv, yv, n), n) << kernel.name << " n=" << n;
+    ASSERT_EQ(kernel.backward(xv + n, yv + n, n), n) << kernel.name << " n=" << n;
+
+    const uint64_t flips[] = { 1, uint64_t(1) << 40, uint64_t(1) << 63 };
+    for(lin position = 0; position < n; position++)
+    {
+        for(auto flip: flips)
+        {
+            auto& line = y[GUARD + position];
+            line = static_cast<lin>(static_cast<uint64_t>(line) ^ flip);
+            ASSERT_EQ(kernel.forward(xv, yv, n), position) << kernel.name << " n=" << n;
+            ASSERT_EQ(kernel.backward(xv + n, yv + n, n), n - 1 - position) << kernel.name << " n=" << n;
+            line = x[GUARD + position];
+        }
+    }
+}
+
+TEST(TestSnake, kernels_find_a_difference_at_every_position)
+{
+    auto kernels = getKernels();
+    ASSERT_GE(kernels.size(), 1u);
+
+    for(auto& kernel: kernels)
+    {
+        for(lin n = 0; n <= 40; n++)
+        {
+            checkRange(kernel, n, true);
+            checkRange(kernel, n, false);
+        }
+        checkRange(kernel, 1000, true);
+    }
+}
+
+TEST(TestSnake, kernels_are_the_same_as_the_scalar_loop)
+{
+    auto kernels = getKernels();
+    std::mt19937_64 rng(1);
+
+    for(int round = 0; round < 2000; round++)
+    {
+        lin n = std::uniform_int_distribution<lin>(0, 100)(rng);
+        std::vector<lin> x(n + 2 * GUARD);
+        std::vector<lin> y(n + 2 * GUARD);
+        for(size_t i = 0; i < x.size(); i++)
+        {
+            /* Few values, so that runs of equal lines of any length occur */
+            x[i] = std::uniform_int_distribution<lin>(0, 1)(rng);
+            y[i] = (std::uniform_int_distribution<int>(0, 15)(rng) == 0) ? 1 - x[i] : x[i];
+        }
+
+        const lin *xv = x.data() + GUARD;
+        const lin *yv = y.data() + GUARD;
+        lin forward = kernels[0].forward(xv, yv, n);
+        lin backward = kernels[0].backward(xv + n, yv + n, n);
+        for(auto& kernel: kernels)
+        {
+            ASSERT_EQ(kernel.forward(xv, yv, n), forward) << kernel.name;
+            ASSERT_EQ(kernel.backward(xv + n, yv + n, n), backward) << kernel.name;
+        }
+    }
+}
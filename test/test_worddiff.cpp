@@ -0,0 +1,189 @@
+#include <random>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "../src/diff.h"
+#include "../src/worddiff.h"
+
+static std::vector<size_t> findTokenStartsByteByByte(std::string_view line)
+{
+    auto tokenClass = [](unsigned char c)
+    {
+        if((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c >= 0x80)
+            return 0;
+        if(c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            return 1;
+        return 2;
+    };
+
+    std::vector<size_t> starts;
+    for(size_t i = 0; i < line.size(); i++)
+    {
+        int current = tokenClass(line[i]);
+        if(i == 0 || current == 2 || current != tokenClass(line[i - 1]))
+        {
+            starts.push_back(i);
+        }
+    }
+    return starts;
+}
+
+static std::string randomText(std::mt19937& rng, size_t size)
+{
+    static const char alphabet[] = "ab_Z09 \t\n.,;(){}\x80\xff@[`{";
+    std::string text;
+    for(size_t i = 0; i < size; i++)
+    {
+        text += alphabet[std::uniform_int_distribution<int>(0, sizeof(alphabet) - 2)(rng)];
+    }
+    return text;
+}
+
+/*
+ * Returns the number of tokens of line1 in equal stretches, after checking
+ * that the diff list covers both lines, that equal stretches are equal and
+ * that all stretches consist of whole tokens.
+ */
+static size_t checkDiffList(const DiffList& diffList, std::string_view line1, std::string_view line2)
+{
+    auto starts1 = findTokenStarts(line1);
+    auto starts2 = findTokenStarts(line2);
+    auto isBoundary = [](const std::vector<size_t>& starts, size_t pos, size_t size)
+    {
+        return pos == size || std::binary_search(starts.begin(), starts.end(), pos);
+    };
+
+    size_t pos1 = 0;
+    size_t pos2 = 0;
+    size_t equalTokens = 0;
+    for(auto& d: diffList)
+    {
+        EXPECT_EQ(line1.substr(pos1, d.nofEquals), line2.substr(pos2, d.nofEquals));
+        equalTokens += std::count_if(starts1.begin(), starts1.end(),
+                                     [&](size_t start) { return start >= pos1 && start < pos1 + d.nofEquals; });
+        pos1 += d.nofEquals;
+        pos2 += d.nofEquals;
+        EXPECT_TRUE(isBoundary(starts1, pos1, line1.size()));
+        EXPECT_TRUE(isBoundary(starts2, pos2, line2.size()));
+        pos1 += d.diff1;
+        pos2 += d.diff2;
+        EXPECT_TRUE(isBoundary(starts1, pos1, line1.size()));
+        EXPECT_TRUE(isBoundary(starts2, pos2, line2.size()));
+    }
+    EXPECT_EQ(pos1, line1.size());
+    EXPECT_EQ(pos2, line2.size());
+    return equalTokens;
+}
+
+static size_t longestCommonTokenSequence(std::string_view line1, std::string_view line2)
+{
+    auto tokens = [](std::string_view line)
+    {
+        std::vector<std::string_view> result;
+        auto starts = findTokenStarts(line);
+        for(size_t i = 0; i < starts.size(); i++)
+        {
+            size_t end = (i + 1 == starts.size()) ? line.size() : starts[i + 1];
+            result.push_back(line.substr(starts[i], end - starts[i]));
+        }
+        return result;
+    };
+    auto a = tokens(line1);
+    auto b = tokens(line2);
+
+    std::vector<std::vector<size_t>> lcs(a.size() + 1, std::vector<size_t>(b.size() + 1, 0));
+    for(size_t i = 1; i <= a.size(); i++)
+    {
+        for(size_t j = 1; j <= b.size(); j++)
+        {
+            lcs[i][j] = (a[i - 1] == b[j - 1]) ? lcs[i - 1][j - 1] + 1 : std::max(lcs[i - 1][j], lcs[i][j - 1]);
+        }
+    }
+    return lcs[a.size()][b.size()];
+}
+
+TEST(TestWordDiff, tokens_are_words_whitespace_and_single_punctuation)
+{
+    ASSERT_EQ(findTokenStarts("int foo_1(a,  b);\n"),
+              std::vector<size_t>({ 0, 3, 4, 9, 10, 11, 12, 14, 15, 16, 17 }));
+    ASSERT_EQ(findTokenStarts(""), std::vector<size_t>());
+}
+
+TEST(TestWordDiff, tokens_are_the_same_as_when_classified_byte_by_byte)
+{
+    std::mt19937 rng(1);
+    for(int iteration = 0; iteration < 500; iteration++)
+    {
+        auto line = randomText(rng, std::uniform_int_distribution<int>(0, 300)(rng));
+        ASSERT_EQ(findTokenStarts(line), findTokenStartsByteByByte(line)) << line;
+    }
+}
+
+TEST(TestWordDiff, changed_words_are_one_difference)
+{
+    std::string line1 = "the quick brown fox jumps\n";
+    std::string line2 = "the quack brawn fox jumps\n";
+
+    /* The space between the changed words stays equal */
+    ASSERT_EQ(calcWordDiff(line1, line2), DiffList({ Diff(4, 5, 5), Diff(1, 5, 5), Diff(11, 0, 0) }));
+    ASSERT_EQ(calcWordDiff(line1, line1), DiffList({ Diff(line1.size(), 0, 0) }));
+    ASSERT_EQ(calcWordDiff("", ""), DiffList({ Diff(0, 0, 0) }));
+}
+
+TEST(TestWordDiff, finds_the_longest_common_token_sequence)
+{
+    std::mt19937 rng(2);
+    for(int iteration = 0; iteration < 1000; iteration++)
+    {
+        auto line1 = randomText(rng, std::uniform_int_distribution<int>(0, 80)(rng));
+        auto line2 = line1;
+        int edits = std::uniform_int_distribution<int>(0, 6)(rng);
+        for(int edit = 0; edit < edits; edit++)
+        {
+            size_t pos = std::uniform_int_distribution<size_t>(0, line2.size())(rng);
+            if(std::uniform_int_distribution<int>(0, 1)(rng) == 0)
+            {
+                line2.insert(pos, randomText(rng, 5));
+            }
+            else
+            {
+                line2.erase(pos, 5);
+            }
+        }
+
+        auto diffList = calcWordDiff(line1, line2);
+        ASSERT_EQ(checkDiffList(diffList, line1, line2), longestCommonTokenSequence(line1, line2))
+            << line1 << " vs " << line2;
+    }
+}
+
+TEST(TestWordDiff, word_mode_gives_fewer_fragments_than_character_mode)
+{
+    std::string line1 = "    result = computeTotal(items, taxRate) + shippingCost;\n";
+    std::string line2 = "    total = computeSubtotal(items, discount) + handlingFee;\n";
+
+    auto characterDiff = fineDiff(0, 0, line1, line2, FineDiffGranularity::CHARACTER);
+    auto wordDiff = fineDiff(0, 0, line1, line2, FineDiffGranularity::WORD);
+
+    checkDiffList(wordDiff, line1, line2);
+    ASSERT_LT(wordDiff.size(), characterDiff.size());
+}
+
+TEST(TestWordDiff, lines_needing_many_edits_get_one_difference_between_their_common_ends)
+{
+    std::string line1 = "start";
+    std::string line2 = "start";
+    for(int i = 0; i < 1000; i++)
+    {
+        line1 += " a" + std::to_string(i);
+        line2 += " b" + std::to_string(i);
+    }
+    line1 += " end\n";
+    line2 += " end\n";
+
+    auto diffList = calcWordDiff(line1, line2);
+
+    checkDiffList(diffList, line1, line2);
+    ASSERT_EQ(diffList.size(), 2);
+    ASSERT_EQ(diffList[0].nofEquals, 6);
+}
@@ -0,0 +1,45 @@
+#include <atomic>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "../src/workerpool.h"
+
+TEST(TestWorkerPool, runs_every_task_once)
+{
+    WorkerPool pool(3);
+    std::vector<std::atomic<int>> runs(1000);
+
+    pool.run(runs.size(), [&](size_t task, unsigned worker)
+    {
+        ASSERT_LT(worker, pool.concurrency());
+        runs[task]++;
+    });
+
+    for(auto& count: runs)
+    {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(TestWorkerPool, can_run_several_jobs)
+{
+    WorkerPool pool(2);
+    for(int job = 0; job < 100; job++)
+    {
+        std::atomic<size_t> sum{0};
+        pool.run(job, [&](size_t task, unsigned) { sum += task; });
+        ASSERT_EQ(sum, static_cast<size_t>(job * (job - 1) / 2));
+    }
+}
+
+TEST(TestWorkerPool, works_without_threads_of_its_own)
+{
+    WorkerPool pool(0);
+    int count = 0;
+    pool.run(10, [&](size_t, unsigned worker)
+    {
+        ASSERT_EQ(worker, 0u);
+        count++;
+    });
+    ASSERT_EQ(count, 10);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/ilineprovider.h"
+
+/*
+ * Provides lines from memory and counts how often lines are asked for.
+ */
+class VectorLineProvider: public ILineProvider
+{
+public:
+    VectorLineProvider(const std::vector<std::string>& lines)
+    {
+        for(auto& line: lines)
+        {
+            m_content += line;
+        }
+        size_t offset = 0;
+        for(auto& line: lines)
+        {
+            m_lines.push_back(std::string_view(m_content).substr(offset, line.size()));
+            offset += line.size();
+        }
+    }
+
+    std::vector<std::string_view> get(size_t line) override
+    {
+        m_nrOfGets++;
+        if(line >= m_lines.size())
+        {
+            return {};
+        }
+        return { m_lines[line] };
+    }
+
+    size_t getLastLineNumber() override
+    {
+        return m_lines.size() - 1;
+    }
+
+    std::string_view getContent() override
+    {
+        return m_content;
+    }
+
+    int getFileDescriptor() override
+    {
+        return m_file ? fileno(m_file.get()) : -1;
+    }
+
+    /*
+     * Makes the content available through a temporary file as well.
+     */
+    void storeInFile()
+    {
+        m_file.reset(tmpfile());
+        fwrite(m_content.data(), 1, m_content.size(), m_file.get());
+        fflush(m_file.get());
+    }
+
+    std::atomic<int> m_nrOfGets{0};
+
+private:
+    std::string m_content;
+    std::vector<std::string_view> m_lines;
+    std::unique_ptr<FILE, int (*)(FILE *)> m_file{ nullptr, fclose };
+};